@@ -1,215 +1,59 @@
 #include "BitUtils.h"
 
 #if __cplusplus >= 201100 // C++11
-#ifdef CHAR_BIT
-constexpr const std::size_t CHAR_SIZE = CHAR_BIT;
-#else
-#ifdef __CHAR_BIT__
-constexpr const std::size_t CHAR_SIZE = __CHAR_BIT__;
-#endif // __CHAR_BIT__
-#endif // CHAR_BIT
-
-// Checks if the current machine is big endian or little endian. 
-#define _BITUTILS_IS_LITTLE_ENDIAN (1 << 1) > 1
-
-inline bool is_bounded(
-	const std::size_t n,
-	const std::size_t start_bit,
-	const std::size_t end_bit
-) {
-	return start_bit != 0 || end_bit != n;
-}
-
-inline bool is_soft_bounded(
-	const std::size_t n,
-	const std::size_t start_bit,
-	const std::size_t end_bit
-) {
-	return !is_bounded(n, start_bit, end_bit) && BitUtils::size(n) * CHAR_SIZE != n;
-}
-
-inline bool do_bounds_overlap(
-	const void* const left,
-	const std::size_t left_start_bit,
-	const std::size_t left_end_bit,
-	const void* const right,
-	const std::size_t right_start_bit,
-	const std::size_t right_end_bit
-) {
-	if (left == right)
-		return true;
-	return (unsigned char*)left + (left_end_bit - left_start_bit) >= right ||
-		(unsigned char*)right + (right_end_bit - right_start_bit) >= left;
-}
 
-std::size_t log2l(const std::size_t n) {
-	std::size_t i = 0;
-#if _BITUTILS_IS_LITTLE_ENDIAN
-	while (((std::size_t)1 << i) < n) {
-#else
-	while (((std::size_t)1 >> i) < n) {
-#endif
-		i++;
+// Helpers that only the functions in here need.
+namespace BitUtils {
+	inline bool is_bounded(
+		const std::size_t n,
+		const std::size_t start_bit,
+		const std::size_t end_bit
+	) {
+		return start_bit != 0 || end_bit != n;
 	}
-	return i;
-}
 
-inline void _validateBounds(const std::size_t start_bit, const std::size_t end_bit, const std::size_t i) {
-	// 0 <= start_bit < end_bit
-	// end_bit - start_bit <= n
-	// i < end_bit - start_bit
-	if (start_bit >= end_bit) // guarantees start_bit < end_bit
-		throw std::invalid_argument("start_bit cannot be >= end_bit");
-
-	// i is the local index for the unbounded/bounded bit array.
-
-	if (i >= end_bit - start_bit)
-		throw std::out_of_range("i is out of range for a bounded memory block with " + std::to_string(end_bit - start_bit) + " bits to work with.");
-}
-
-inline void _validateBounds(const std::size_t n, const std::size_t i) {
-	// 0 <= i < n
-	if (n == 0) // guarantees n > 0 (unsigned numbers only)
-		throw std::invalid_argument("n cannot be == 0.");
-	if (i >= n) {
-		if (n != BitUtils::size(n) * CHAR_SIZE)
-			throw std::out_of_range("i is out of range for a soft bounded memory block with " + std::to_string(n) + " bits to work with.");
-		else
-			throw std::out_of_range("i is out of range for an unbounded memory block with " + std::to_string(n) + " bits to work with.");
+	inline bool is_soft_bounded(
+		const std::size_t n,
+		const std::size_t start_bit,
+		const std::size_t end_bit
+	) {
+		return !is_bounded(n, start_bit, end_bit) && size(n) * CHAR_SIZE != n;
 	}
-}
-
-unsigned char* const getPage(void* const src, const std::size_t start_bit, const std::size_t end_bit, const std::size_t i) {
-	_validateBounds(start_bit, end_bit, i);
-	if (end_bit - start_bit == CHAR_SIZE)
-		return (unsigned char*)src;
-	else
-		return (unsigned char*)src + ((i + start_bit) / CHAR_SIZE);
-}
-
-const unsigned char* const getPage(const void* const src, const std::size_t start_bit, const std::size_t end_bit, const std::size_t i) {
-	_validateBounds(start_bit, end_bit, i);
-	if (end_bit - start_bit == CHAR_SIZE)
-		return (unsigned char*)src;
-	else
-		return (unsigned char*)src + ((i + start_bit) / CHAR_SIZE);
-}
-
-unsigned char* const getPage(void* const src, const std::size_t n, const std::size_t i) {
-	_validateBounds(n, i);
-	if (n == CHAR_SIZE)
-		return (unsigned char*)src;
-	else
-		return (unsigned char*)src + (i / CHAR_SIZE);
-}
-
-const unsigned char* const getPage(const void* const src, const std::size_t n, const std::size_t i) {
-	_validateBounds(n, i);
-	if (n == CHAR_SIZE)
-		return (unsigned char*)src;
-	else
-		return (unsigned char*)src + (i / CHAR_SIZE);
-}
-
-void* BitUtils::create(const std::size_t n) {
-	return calloc(size(n), 1);
-}
-
-// ============ CORE FUNCTIONS ============
-
-inline std::size_t BitUtils::size(const std::size_t n) {
-	if (n <= CHAR_SIZE)
-		return 1;
-	auto temp = (n / CHAR_SIZE) * CHAR_SIZE;
-	return (temp / CHAR_SIZE) + (temp < n);
-}
-
-std::size_t BitUtils::size(const std::size_t start_bit, const std::size_t end_bit) {
-	return size(start_bit) + size(end_bit - start_bit);
-}
-
-bool BitUtils::get(const void* const block,
-	const std::size_t start_bit,
-	const std::size_t end_bit,
-	const std::size_t i
-) {
-#if _BITUTILS_IS_LITTLE_ENDIAN
-	return *getPage(block, start_bit, end_bit, i) & ((std::size_t)1 << ((i + start_bit) % CHAR_SIZE));
-#else
-	return *getPage(block, start_bit, end_bit, i) & ((std::size_t)1 >> ((i + start_bit) % CHAR_SIZE));
-#endif
-}
-
-bool BitUtils::get(const void* const block,
-	const std::size_t n,
-	const std::size_t i
-) {
-#if _BITUTILS_IS_LITTLE_ENDIAN
-	return *getPage(block, n, i) & ((std::size_t)1 << (i % CHAR_SIZE));
-#else
-	return *getPage(block, n, i) & ((std::size_t)1 >> (i % CHAR_SIZE));
-#endif
-}
 
-void BitUtils::flip(void* const block,
-	const std::size_t start_bit,
-	const std::size_t end_bit,
-	const std::size_t i
-) {
-#if _BITUTILS_IS_LITTLE_ENDIAN
-	*getPage(block, start_bit, end_bit, i) ^= ((std::size_t)1 << ((i + start_bit) % CHAR_SIZE));
-#else
-	*getPage(block, start_bit, end_bit, i) ^= ((std::size_t)1 >> ((i + start_bit) % CHAR_SIZE));
-#endif
-}
-
-void BitUtils::flip(void* const block,
-	const std::size_t n,
-	const std::size_t i
-) {
-#if _BITUTILS_IS_LITTLE_ENDIAN
-	*getPage(block, n, i) ^= ((std::size_t)1 << (i % CHAR_SIZE));
-#else
-	*getPage(block, n, i) ^= ((std::size_t)1 >> (i  % CHAR_SIZE));
-#endif
-}
+	inline bool do_bounds_overlap(
+		const void* const left,
+		const std::size_t left_start_bit,
+		const std::size_t left_end_bit,
+		const void* const right,
+		const std::size_t right_start_bit,
+		const std::size_t right_end_bit
+	) {
+		if (left == right)
+			return true;
+		return (unsigned char*)left + (left_end_bit - left_start_bit) >= right ||
+			(unsigned char*)right + (right_end_bit - right_start_bit) >= left;
+	}
 
-void BitUtils::set(void* const block,
-	const std::size_t start_bit,
-	const std::size_t end_bit,
-	const std::size_t i,
-	const bool b
-) {
-	// Setting the bit to true regardless of its state
+	inline std::size_t log2l(const std::size_t n) {
+		std::size_t i = 0;
 #if _BITUTILS_IS_LITTLE_ENDIAN
-	*getPage(block, start_bit, end_bit, i) |= (std::size_t)1 << ((i + start_bit) % CHAR_SIZE);
+		while (((std::size_t)1 << i) < n) {
 #else
-	*getPage(block, start_bit, end_bit, i) |= (std::size_t)1 >> ((i + start_bit) % CHAR_SIZE);
+		while (((std::size_t)1 >> i) < n) {
 #endif
-	// Flipping the bit if user wants it to be false
-	if (!b)
-		flip(block, start_bit, end_bit, i);
-}
+			i++;
+		}
+		return i;
+	}
+};
 
-void BitUtils::set(void* const block,
-	const std::size_t n,
-	const std::size_t i,
-	const bool b
-) {
-	// Setting the bit to true regardless of its state
-#if _BITUTILS_IS_LITTLE_ENDIAN
-	*getPage(block, n, i) |= (std::size_t)1 << (i % CHAR_SIZE);
-#else
-	*getPage(block, n, i) |= (std::size_t)1 >> (i  % CHAR_SIZE);
-#endif
-	// Flipping the bit if user wants it to be false
-	if (!b)
-		flip(block, n, i);
+_BITUTILS_INLINE void* BitUtils::create(const std::size_t n) {
+	return calloc(size(n), 1);
 }
 
 // ============ FUNCTIONS ============
 
-void BitUtils::fill(void* const src,
+_BITUTILS_INLINE void BitUtils::fill(void* const src,
 	const std::size_t start_bit,
 	const std::size_t end_bit,
 	const bool b
@@ -219,7 +63,7 @@ void BitUtils::fill(void* const src,
 	}
 }
 
-void BitUtils::fill(void* const src,
+_BITUTILS_INLINE void BitUtils::fill(void* const src,
 	const std::size_t n,
 	const bool b
 ) {
@@ -229,7 +73,7 @@ void BitUtils::fill(void* const src,
 		memset(src, b ? (unsigned char)-1 : 0, size(n));
 }
 
-void BitUtils::copy(const void* const src,
+_BITUTILS_INLINE void BitUtils::copy(const void* const src,
 	const std::size_t src_start_bit,
 	const std::size_t src_end_bit,
 	void* const dst,
@@ -268,30 +112,32 @@ void BitUtils::copy(const void* const src,
 	}
 }
 
-void BitUtils::copy(const void* const src,
+_BITUTILS_INLINE void BitUtils::copy(const void* const src,
 	void* const dst,
 	const std::size_t start_bit,
 	const std::size_t end_bit
 ) {
 	if (src == dst)
 		return;
-	_validateBounds(start_bit, end_bit, 0);
-#if defined(__GNUG__) || defined(_CRT_SECURE_NO_WARNINGS) // if you're using gcc or don't want to use memcpy_s
-	memcpy(dst, src, size(n));
-#else // if you're using vc++
-	memcpy_s(dst, size(start_bit, end_bit), src, size(start_bit, end_bit));
-#endif
+	copy(ConstBitSpan(src, start_bit, end_bit), BitSpan(dst, start_bit, end_bit));
 }
 
-void BitUtils::copy(
+_BITUTILS_INLINE void BitUtils::copy(
 	const void* const src,
 	void* const dst,
 	const std::size_t n
 ) {
-	copy(src, dst, 0, n);
+	if (src == dst)
+		return;
+	_validateBounds(n, 0);
+#if defined(__GNUG__) || defined(_CRT_SECURE_NO_WARNINGS) // if you're using gcc or don't want to use memcpy_s
+	memcpy(dst, src, size(n));
+#else // if you're using vc++
+	memcpy_s(dst, size(n), src, size(n));
+#endif
 }
 
-void BitUtils::bitwise_and(
+_BITUTILS_INLINE void BitUtils::bitwise_and(
 	const void* const left,
 	const std::size_t left_start_bit,
 	const std::size_t left_end_bit,
@@ -349,7 +195,7 @@ void BitUtils::bitwise_and(
 	}
 }
 
-void BitUtils::bitwise_and(
+_BITUTILS_INLINE void BitUtils::bitwise_and(
 	const void* const left,
 	const std::size_t left_start_bit,
 	const std::size_t left_end_bit,
@@ -384,7 +230,7 @@ void BitUtils::bitwise_and(
 	}
 }
 
-void BitUtils::bitwise_and(
+_BITUTILS_INLINE void BitUtils::bitwise_and(
 	const void* const left,
 	const void* const right,
 	void* const dst,
@@ -402,13 +248,13 @@ void BitUtils::bitwise_and(
 	}
 
 	for (std::size_t i = 0; i < n; i += CHAR_SIZE) {
-		*getPage(dst, n, i) =
-			*getPage(left, n, i) &
-			*getPage(right, n, i);
+		*_getPage(dst, n, i) =
+			*_getPage(left, n, i) &
+			*_getPage(right, n, i);
 	}
 }
 
-void BitUtils::bitwise_and(
+_BITUTILS_INLINE void BitUtils::bitwise_and(
 	const void* const left,
 	const bool right,
 	void* const dst,
@@ -417,7 +263,7 @@ void BitUtils::bitwise_and(
 	bitwise_and(left, 0, n, right, dst, 0, n);
 }
 
-void BitUtils::bitwise_and(
+_BITUTILS_INLINE void BitUtils::bitwise_and(
 	const void* const left,
 	const void* const right,
 	void* const dst,
@@ -431,7 +277,7 @@ void BitUtils::bitwise_and(
 	);
 }
 
-void BitUtils::bitwise_and(
+_BITUTILS_INLINE void BitUtils::bitwise_and(
 	const void* const left,
 	const bool right,
 	void* const dst,
@@ -441,7 +287,7 @@ void BitUtils::bitwise_and(
 	bitwise_and(left, start_bit, end_bit, right, dst, start_bit, end_bit);
 }
 
-void BitUtils::bitwise_or(
+_BITUTILS_INLINE void BitUtils::bitwise_or(
 	const void* const left,
 	const std::size_t left_start_bit,
 	const std::size_t left_end_bit,
@@ -476,7 +322,7 @@ void BitUtils::bitwise_or(
 	}
 }
 
-void BitUtils::bitwise_or(
+_BITUTILS_INLINE void BitUtils::bitwise_or(
 	const void* const left,
 	const void* const right,
 	void* const dst,
@@ -492,13 +338,13 @@ void BitUtils::bitwise_or(
 		return;
 	}
 	for (std::size_t i = 0; i < n; i += CHAR_SIZE) {
-		*getPage(dst, n, i) =
-			*getPage(left, n, i) |
-			*getPage(right, n, i);
+		*_getPage(dst, n, i) =
+			*_getPage(left, n, i) |
+			*_getPage(right, n, i);
 	}
 }
 
-void BitUtils::bitwise_or(const void* const left,
+_BITUTILS_INLINE void BitUtils::bitwise_or(const void* const left,
 	const void* const right,
 	void* const dst,
 	const std::size_t start_bit,
@@ -511,7 +357,7 @@ void BitUtils::bitwise_or(const void* const left,
 	);
 }
 
-void BitUtils::bitwise_xor(
+_BITUTILS_INLINE void BitUtils::bitwise_xor(
 	const void* const left,
 	const std::size_t left_start_bit,
 	const std::size_t left_end_bit,
@@ -567,7 +413,7 @@ void BitUtils::bitwise_xor(
 	}
 }
 
-void BitUtils::bitwise_xor(
+_BITUTILS_INLINE void BitUtils::bitwise_xor(
 	const void* const left,
 	const void* const right,
 	void* const dst,
@@ -581,7 +427,7 @@ void BitUtils::bitwise_xor(
 	);
 }
 
-void BitUtils::bitwise_xor(const void* const left,
+_BITUTILS_INLINE void BitUtils::bitwise_xor(const void* const left,
 	const void* const right,
 	void* const dst,
 	const std::size_t n
@@ -591,13 +437,13 @@ void BitUtils::bitwise_xor(const void* const left,
 		return;
 	}
 	for (std::size_t i = 0; i < n; i += CHAR_SIZE) {
-		*getPage(dst, n, i) =
-			*getPage(left, n, i) ^
-			*getPage(right, n, i);
+		*_getPage(dst, n, i) =
+			*_getPage(left, n, i) ^
+			*_getPage(right, n, i);
 	}
 }
 
-void BitUtils::bitwise_not(
+_BITUTILS_INLINE void BitUtils::bitwise_not(
 	const void* const src,
 	const std::size_t src_start_bit,
 	const std::size_t src_end_bit,
@@ -631,7 +477,7 @@ void BitUtils::bitwise_not(
 	}
 }
 
-void BitUtils::bitwise_not(
+_BITUTILS_INLINE void BitUtils::bitwise_not(
 	const void* const src,
 	void* const dst,
 	const std::size_t start_bit,
@@ -643,16 +489,16 @@ void BitUtils::bitwise_not(
 	);
 }
 
-void BitUtils::bitwise_not(const void* const src,
+_BITUTILS_INLINE void BitUtils::bitwise_not(const void* const src,
 	void* const dst,
 	const std::size_t n
 ) {
 	for (std::size_t i = 0; i < n; i += CHAR_SIZE) {
-		*getPage(dst, n, i) = ~(*getPage(src, n, i));
+		*_getPage(dst, n, i) = ~(*_getPage(src, n, i));
 	}
 }
 
-void BitUtils::bitwise_not(void* const src,
+_BITUTILS_INLINE void BitUtils::bitwise_not(void* const src,
 	const std::size_t start_bit,
 	const std::size_t end_bit
 ) {
@@ -662,13 +508,13 @@ void BitUtils::bitwise_not(void* const src,
 	);
 }
 
-void BitUtils::bitwise_not(void* const src,
+_BITUTILS_INLINE void BitUtils::bitwise_not(void* const src,
 	const std::size_t n
 ) {
 	bitwise_not(src, 0, n);
 }
 
-bool BitUtils::bool_op(const void* const src,
+_BITUTILS_INLINE bool BitUtils::bool_op(const void* const src,
 	const std::size_t start_bit,
 	const std::size_t end_bit
 ) {
@@ -680,17 +526,17 @@ bool BitUtils::bool_op(const void* const src,
 	return false;
 }
 
-bool BitUtils::bool_op(const void* const src,
+_BITUTILS_INLINE bool BitUtils::bool_op(const void* const src,
 	const std::size_t n
 ) {
 	for (std::size_t i = 0; i < n; i += CHAR_SIZE) {
-		if (*getPage(src, n, i))
+		if (*_getPage(src, n, i))
 			return true;
 	}
 	return false;
 }
 
-bool BitUtils::equals(const void* const left,
+_BITUTILS_INLINE bool BitUtils::equals(const void* const left,
 	const std::size_t left_start_bit,
 	const std::size_t left_end_bit,
 	const void* const right,
@@ -703,7 +549,7 @@ bool BitUtils::equals(const void* const left,
 	);
 }
 
-bool BitUtils::equals(
+_BITUTILS_INLINE bool BitUtils::equals(
 	const void* const left,
 	const void* const right,
 	const std::size_t start_bit,
@@ -712,18 +558,18 @@ bool BitUtils::equals(
 	return equals(left, start_bit, end_bit, right, start_bit, end_bit);
 }
 
-bool BitUtils::equals(const void* left,
+_BITUTILS_INLINE bool BitUtils::equals(const void* left,
 	const void* const right,
 	const std::size_t n
 ) {
 	for (std::size_t i = 0; i < size(n); i++) {
-		if (*getPage(left, n, i * CHAR_SIZE) != *getPage(right, n, i * CHAR_SIZE))
+		if (*_getPage(left, n, i * CHAR_SIZE) != *_getPage(right, n, i * CHAR_SIZE))
 			return false;
 	}
 	return true;
 }
 
-void BitUtils::shift_left(
+_BITUTILS_INLINE void BitUtils::shift_left(
 	void* const block,
 	const std::size_t start_bit,
 	const std::size_t end_bit,
@@ -743,7 +589,7 @@ void BitUtils::shift_left(
 	fill(block, end_bit - by, end_bit, 0);
 }
 
-void BitUtils::shift_left(
+_BITUTILS_INLINE void BitUtils::shift_left(
 	void* const block,
 	const std::size_t n,
 	const std::size_t by
@@ -751,7 +597,7 @@ void BitUtils::shift_left(
 	shift_left(block, 0, n, by);
 }
 
-void BitUtils::shift_right(
+_BITUTILS_INLINE void BitUtils::shift_right(
 	void* const block,
 	const std::size_t start_bit,
 	const std::size_t end_bit,
@@ -771,7 +617,7 @@ void BitUtils::shift_right(
 	fill(block, start_bit, start_bit + by, 0);
 }
 
-void BitUtils::shift_right(
+_BITUTILS_INLINE void BitUtils::shift_right(
 	void* const block,
 	const std::size_t n,
 	const std::size_t by
@@ -779,7 +625,7 @@ void BitUtils::shift_right(
 	shift_right(block, 0, n, by);
 }
 
-bool BitUtils::all(
+_BITUTILS_INLINE bool BitUtils::all(
 	const void* const block,
 	const std::size_t start_bit,
 	const std::size_t end_bit
@@ -791,15 +637,15 @@ bool BitUtils::all(
 	return true;
 }
 
-bool BitUtils::all(const void* const block, const std::size_t n) {
+_BITUTILS_INLINE bool BitUtils::all(const void* const block, const std::size_t n) {
 	for (std::size_t i = 0; i < size(n); i++) {
-		if (*getPage(block, n, i * CHAR_SIZE) != (unsigned char)-1)
+		if (*_getPage(block, n, i * CHAR_SIZE) != (unsigned char)-1)
 			return false;
 	}
 	return true;
 }
 
-int BitUtils::compare(
+_BITUTILS_INLINE int BitUtils::compare(
 	const void* const left,
 	const std::size_t left_start_bit,
 	const std::size_t left_end_bit,
@@ -821,14 +667,14 @@ int BitUtils::compare(
 	return 0;
 }
 
-int BitUtils::compare(const void* const left,
+_BITUTILS_INLINE int BitUtils::compare(const void* const left,
 	const void* const right,
 	const std::size_t n
 ) {
 	return memcmp(left, right, size(n));
 }
 
-int BitUtils::compare(const void* const left,
+_BITUTILS_INLINE int BitUtils::compare(const void* const left,
 	const void* const right,
 	const std::size_t start_bit,
 	const std::size_t end_bit
@@ -838,7 +684,7 @@ int BitUtils::compare(const void* const left,
 		right, start_bit, end_bit);
 }
 
-void BitUtils::str(const void* const src,
+_BITUTILS_INLINE void BitUtils::str(const void* const src,
 	const std::size_t src_start_bit,
 	const std::size_t src_end_bit,
 	char* const buf
@@ -851,7 +697,7 @@ void BitUtils::str(const void* const src,
 	buf[((src_end_bit - src_start_bit) < strlen(buf) ? (src_end_bit - src_start_bit) : strlen(buf))] = '\0';
 }	
 
-void BitUtils::wstr(const void* const src,
+_BITUTILS_INLINE void BitUtils::wstr(const void* const src,
 	const std::size_t src_start_bit,
 	const std::size_t src_end_bit,
 	wchar_t* const buf
@@ -864,7 +710,7 @@ void BitUtils::wstr(const void* const src,
 	buf[((src_end_bit - src_start_bit) < wcslen(buf) ? (src_end_bit - src_start_bit) : wcslen(buf))] = L'\0';
 }
 
-void BitUtils::str(
+_BITUTILS_INLINE void BitUtils::str(
 	const void* const src,
 	const std::size_t start_bit,
 	const std::size_t end_bit,
@@ -877,7 +723,7 @@ void BitUtils::str(
 	}
 }
 
-std::string BitUtils::str(
+_BITUTILS_INLINE std::string BitUtils::str(
 	const void* const src,
 	const std::size_t start_bit,
 	const std::size_t end_bit
@@ -887,11 +733,11 @@ std::string BitUtils::str(
 	return ss.str();
 }
 
-std::string BitUtils::str(const void* const src, const std::size_t n) {
+_BITUTILS_INLINE std::string BitUtils::str(const void* const src, const std::size_t n) {
 	return str(src, 0, n);
 }
 
-void BitUtils::wstr(
+_BITUTILS_INLINE void BitUtils::wstr(
 	const void* const src,
 	const std::size_t start_bit,
 	const std::size_t end_bit,
@@ -904,7 +750,7 @@ void BitUtils::wstr(
 	}
 }
 
-std::wstring BitUtils::wstr(const void* const src,
+_BITUTILS_INLINE std::wstring BitUtils::wstr(const void* const src,
 	const std::size_t start_bit,
 	const std::size_t end_bit
 ) {
@@ -913,11 +759,11 @@ std::wstring BitUtils::wstr(const void* const src,
 	return wss.str();
 }
 
-std::wstring BitUtils::wstr(const void* const src, const std::size_t n) {
+_BITUTILS_INLINE std::wstring BitUtils::wstr(const void* const src, const std::size_t n) {
 	return wstr(src, 0, n);
 }
 
-void BitUtils::from_str(
+_BITUTILS_INLINE void BitUtils::from_str(
 	void* const block, 
 	const std::size_t start_bit,
 	const std::size_t end_bit,
@@ -939,11 +785,11 @@ void BitUtils::from_str(
 	}
 }
 
-void BitUtils::from_str(void* const block, const std::size_t n, const std::string& s) {
+_BITUTILS_INLINE void BitUtils::from_str(void* const block, const std::size_t n, const std::string& s) {
 	from_str(block, 0, n, s);
 }
 
-void BitUtils::from_wstr(
+_BITUTILS_INLINE void BitUtils::from_wstr(
 	void* const block,
 	const std::size_t start_bit,
 	const std::size_t end_bit,
@@ -965,70 +811,739 @@ void BitUtils::from_wstr(
 	}
 }
 
-void BitUtils::from_wstr(void* const block, const std::size_t n, const std::wstring& s) {
+_BITUTILS_INLINE void BitUtils::from_wstr(void* const block, const std::size_t n, const std::wstring& s) {
 	from_wstr(block, 0, n, s);
 }
 
-template < class UnaryFunction >
-void BitUtils::for_each_byte(void* const begin, void* const end, UnaryFunction f) {
-	bool reverse = begin > end;
+// ============ BIT SPANS ============
+
+namespace BitUtils {
+	// The absolute position of the first bit of a view. Used to figure out which direction is safe when views overlap.
+	inline std::uintptr_t _bit_address(const ConstBitSpan& span) {
+		return (std::uintptr_t)span.page * CHAR_SIZE + span.shift;
+	}
+
+	// Returns true if the first n bits of the views share any bits.
+	inline bool _overlaps(const ConstBitSpan& a, const ConstBitSpan& b, const std::size_t n) {
+		return _bit_address(a) < _bit_address(b) + n && _bit_address(b) < _bit_address(a) + n;
+	}
+
+	// Applies op to every word of the views. If dst starts after a source it overlaps then we go backwards, so that we don't read bits
+	// we've already written (the same trick the bounded bitwise functions use). If dst starts between two sources it overlaps, neither direction
+	// works, so the source after it is copied out first.
+	template < class BinaryOp >
+	void _for_each_word(const ConstBitSpan& left, const ConstBitSpan& right, const BitSpan& dst, BinaryOp op) {
+		std::size_t min_n = left.n < right.n ? left.n : right.n;
+		min_n = min_n < dst.n ? min_n : dst.n;
+		const std::size_t words = (min_n + 63) / 64;
+		const std::uintptr_t d = _bit_address(dst);
+		const bool left_overlaps = _overlaps(dst, left, min_n);
+		const bool right_overlaps = _overlaps(dst, right, min_n);
+		const bool after_left = left_overlaps && d > _bit_address(left);
+		const bool after_right = right_overlaps && d > _bit_address(right);
+		const bool before_left = left_overlaps && d < _bit_address(left);
+		const bool before_right = right_overlaps && d < _bit_address(right);
+		if ((after_left && before_right) || (before_left && after_right)) {
+			const ConstBitSpan& later = before_left ? left : right;
+			std::vector<std::uint64_t> copy(words);
+			for (std::size_t k = 0; k < words; k++) {
+				copy[k] = _load_word(later, k, _word_len(min_n, k));
+			}
+			const ConstBitSpan copied(copy.data(), min_n);
+			if (before_left)
+				_for_each_word(copied, right, dst, op);
+			else
+				_for_each_word(left, copied, dst, op);
+			return;
+		}
+		const bool reverse = after_left || after_right;
+		for (std::size_t i = 0; i < words; i++) {
+			const std::size_t k = reverse ? words - 1 - i : i;
+			const std::size_t len = _word_len(min_n, k);
+			_store_word(dst, k, len, op(_load_word(left, k, len), _load_word(right, k, len)));
+		}
+	}
+};
+
+_BITUTILS_INLINE void BitUtils::fill(const BitSpan& span, const bool b) {
+	const unsigned char value = b ? (unsigned char)-1 : 0;
+	const std::size_t last = span.shift + span.n; // one past the last bit, relative to page
+	if (last <= CHAR_SIZE) { // everything is in one byte
+		const unsigned char mask = (unsigned char)(span.head_mask & (0xFF >> (CHAR_SIZE - last)));
+		span.page[0] = (unsigned char)((span.page[0] & ~mask) | (value & mask));
+		return;
+	}
+	span.page[0] = (unsigned char)((span.page[0] & ~span.head_mask) | (value & span.head_mask));
+	memset(span.page + 1, value, last / CHAR_SIZE - 1);
+	if (last % CHAR_SIZE) {
+		const unsigned char mask = (unsigned char)(0xFF >> (CHAR_SIZE - last % CHAR_SIZE));
+		unsigned char& tail = span.page[last / CHAR_SIZE];
+		tail = (unsigned char)((tail & ~mask) | (value & mask));
+	}
+}
+
+_BITUTILS_INLINE void BitUtils::copy(const ConstBitSpan& src, const BitSpan& dst) {
+	_for_each_word(src, src, dst, [](const std::uint64_t l, const std::uint64_t) { return l; });
+}
+
+_BITUTILS_INLINE void BitUtils::bitwise_and(const ConstBitSpan& left, const ConstBitSpan& right, const BitSpan& dst) {
+	_for_each_word(left, right, dst, [](const std::uint64_t l, const std::uint64_t r) { return l & r; });
+}
+
+_BITUTILS_INLINE void BitUtils::bitwise_or(const ConstBitSpan& left, const ConstBitSpan& right, const BitSpan& dst) {
+	_for_each_word(left, right, dst, [](const std::uint64_t l, const std::uint64_t r) { return l | r; });
+}
+
+_BITUTILS_INLINE void BitUtils::bitwise_xor(const ConstBitSpan& left, const ConstBitSpan& right, const BitSpan& dst) {
+	_for_each_word(left, right, dst, [](const std::uint64_t l, const std::uint64_t r) { return l ^ r; });
+}
+
+_BITUTILS_INLINE void BitUtils::bitwise_not(const ConstBitSpan& src, const BitSpan& dst) {
+	_for_each_word(src, src, dst, [](const std::uint64_t l, const std::uint64_t) { return ~l; });
+}
+
+_BITUTILS_INLINE void BitUtils::bitwise_not(const BitSpan& span) {
+	bitwise_not(span, span);
+}
+
+_BITUTILS_INLINE bool BitUtils::bool_op(const ConstBitSpan& span) {
+	for (std::size_t k = 0; k < span.words; k++) {
+		if (_load_word(span, k, 64))
+			return true;
+	}
+	return span.tail_mask && _load_word(span, span.words, span.n % 64);
+}
+
+_BITUTILS_INLINE bool BitUtils::all(const ConstBitSpan& span) {
+	for (std::size_t k = 0; k < span.words; k++) {
+		if (~_load_word(span, k, 64))
+			return false;
+	}
+	return !span.tail_mask || _load_word(span, span.words, span.n % 64) == span.tail_mask;
+}
+
+_BITUTILS_INLINE std::size_t BitUtils::count(const ConstBitSpan& span) {
+	std::size_t total = 0;
+	for (std::size_t k = 0; k < span.words; k++) {
+		total += popcount(_load_word(span, k, 64));
+	}
+	if (span.tail_mask)
+		total += popcount(_load_word(span, span.words, span.n % 64));
+	return total;
+}
+
+_BITUTILS_INLINE int BitUtils::compare(const ConstBitSpan& left, const ConstBitSpan& right) {
+	const std::size_t min_n = left.n < right.n ? left.n : right.n;
+	for (std::size_t k = 0; k * 64 < min_n; k++) {
+		const std::size_t len = _word_len(min_n, k);
+		const std::uint64_t l = _load_word(left, k, len);
+		const std::uint64_t diff = l ^ _load_word(right, k, len);
+		if (diff) // the lowest differing bit decides it, just like the bit by bit version
+			return (l >> countr_zero(diff)) & 1 ? 1 : -1;
+	}
+	return 0;
+}
+
+_BITUTILS_INLINE bool BitUtils::equals(const ConstBitSpan& left, const ConstBitSpan& right) {
+	return 0 == compare(left, right);
+}
+
+_BITUTILS_INLINE void BitUtils::shift_left(const BitSpan& span, const std::size_t by) {
+	if (by == 0)
+		return;
+	if (by >= span.n) {
+		fill(span, 0);
+		return;
+	}
+	const BitSpan whole = span;
+	copy(
+		ConstBitSpan(whole.page, whole.shift + by, whole.shift + whole.n),
+		BitSpan(whole.page, whole.shift, whole.shift + whole.n - by)
+	);
+	fill(BitSpan(whole.page, whole.shift + whole.n - by, whole.shift + whole.n), 0);
+}
+
+_BITUTILS_INLINE void BitUtils::shift_right(const BitSpan& span, const std::size_t by) {
+	if (by == 0)
+		return;
+	if (by >= span.n) {
+		fill(span, 0);
+		return;
+	}
+	const BitSpan whole = span;
+	copy(
+		ConstBitSpan(whole.page, whole.shift, whole.shift + whole.n - by),
+		BitSpan(whole.page, whole.shift + by, whole.shift + whole.n)
+	);
+	fill(BitSpan(whole.page, whole.shift, whole.shift + by), 0);
+}
+
+_BITUTILS_INLINE std::string BitUtils::str(const ConstBitSpan& span) {
+	std::string s(span.n, '0');
+	for (std::size_t i = 0; i < span.n; i++) {
+		if (get(span, i))
+			s[i] = '1';
+	}
+	return s;
+}
+
+_BITUTILS_INLINE std::wstring BitUtils::wstr(const ConstBitSpan& span) {
+	std::wstring s(span.n, L'0');
+	for (std::size_t i = 0; i < span.n; i++) {
+		if (get(span, i))
+			s[i] = L'1';
+	}
+	return s;
+}
+
+_BITUTILS_INLINE void BitUtils::from_str(const BitSpan& span, const std::string& s) {
+	const std::size_t min_n = span.n < s.length() ? span.n : s.length();
+	for (std::size_t i = 0; i < min_n; i++) {
+		if (s[i] != '0' && s[i] != '1')
+			throw std::invalid_argument(std::string("unrecognized char: ") + s[i]);
+		set(span, i, s[i] == '1');
+	}
+}
+
+_BITUTILS_INLINE void BitUtils::from_wstr(const BitSpan& span, const std::wstring& s) {
+	const std::size_t min_n = span.n < s.length() ? span.n : s.length();
+	for (std::size_t i = 0; i < min_n; i++) {
+		if (s[i] != L'0' && s[i] != L'1')
+			throw std::invalid_argument("unrecognized wide char");
+		set(span, i, s[i] == L'1');
+	}
+}
+
+// ============ RUNS ============
 
-	for (unsigned char* it = (unsigned char*)(reverse ? end : begin); it != (reverse ? begin : end); it += reverse ? -1 : 1) {
-		f(reverse ? it - 1 : it);
+_BITUTILS_INLINE void BitUtils::from_intervals(void* const block,
+	const std::size_t start_bit,
+	const std::size_t end_bit,
+	const std::pair<std::size_t, std::size_t>* const intervals,
+	const std::size_t count
+) {
+	const BitSpan span(block, start_bit, end_bit);
+	for (std::size_t i = 0; i < count; i++) {
+		if (intervals[i].first > intervals[i].second)
+			throw std::invalid_argument("an interval cannot have first > second");
+		if (intervals[i].second > span.n)
+			throw std::out_of_range("an interval goes past the " + std::to_string(span.n) + " bits there are to work with.");
+	}
+	fill(span, 0);
+	for (std::size_t i = 0; i < count; i++) {
+		if (intervals[i].first != intervals[i].second)
+			fill(BitSpan(block, start_bit + intervals[i].first, start_bit + intervals[i].second), 1);
 	}
 }
 
-template < class UnaryFunction >
-void BitUtils::for_each_bit(const void* const begin, const void* const end, UnaryFunction f) {
-	bool reverse = begin > end;
+_BITUTILS_INLINE void BitUtils::from_intervals(void* const block,
+	const std::size_t n,
+	const std::pair<std::size_t, std::size_t>* const intervals,
+	const std::size_t count
+) {
+	from_intervals(block, 0, n, intervals, count);
+}
+
+_BITUTILS_INLINE std::vector<std::pair<std::size_t, std::size_t>> BitUtils::to_intervals(const void* const block,
+	const std::size_t start_bit,
+	const std::size_t end_bit
+) {
+	std::vector<std::pair<std::size_t, std::size_t>> intervals;
+	for_each_run(ConstBitSpan(block, start_bit, end_bit), [&intervals](const std::size_t begin, const std::size_t end) {
+		intervals.push_back(std::make_pair(begin, end));
+	});
+	return intervals;
+}
+
+_BITUTILS_INLINE std::vector<std::pair<std::size_t, std::size_t>> BitUtils::to_intervals(const void* const block,
+	const std::size_t n
+) {
+	return to_intervals(block, 0, n);
+}
+
+// ============ RUN SEARCH ============
+
+namespace BitUtils {
+	// _load_bits() with a relaxed atomic load of each byte, for searching a map that other threads are claiming bits in (see claim_run()).
+	// Byte loads, since that's the size claim_run() and release_run() write with.
+	inline std::uint64_t _atomic_load_bits(const unsigned char* const page, const std::size_t shift, const std::size_t len) {
+		const std::size_t bytes = (shift + len + CHAR_SIZE - 1) / CHAR_SIZE; // 1 to 9
+		std::uint64_t word = 0;
+		for (std::size_t i = 0; i < bytes && i < sizeof(word); i++) {
+			word |= (std::uint64_t)_atomic_load(page + i, MemoryOrder::RELAXED) << (CHAR_SIZE * i);
+		}
+		word >>= shift;
+		if (bytes > sizeof(word)) // only possible when shift > 0
+			word |= (std::uint64_t)_atomic_load(page + sizeof(word), MemoryOrder::RELAXED) << (64 - shift);
+		return len == 64 ? word : word & (((std::uint64_t)1 << len) - 1);
+	}
+
+	// Word k of the view, with a 1 wherever the bit is equal to b. The bits past the end are always 0.
+	// With _atomic, the bytes are read with relaxed atomic loads.
+	template < bool _atomic >
+	inline std::uint64_t _load_matches(const ConstBitSpan& span, const std::size_t k, const bool b) {
+		const std::size_t len = _word_len(span.n, k);
+		const std::uint64_t w = _atomic
+			? _atomic_load_bits(span.page + k * sizeof(std::uint64_t), span.shift, len)
+			: _load_word(span, k, len);
+		if (b)
+			return w;
+		return len == 64 ? ~w : ~w & (((std::uint64_t)1 << len) - 1);
+	}
+
+	// The index of the first bit at or after from that is equal to b, or span.n if there isn't one.
+	template < bool _atomic >
+	inline std::size_t _find_match(const ConstBitSpan& span, const std::size_t from, const bool b) {
+		const std::size_t words = (span.n + 63) / 64;
+		for (std::size_t k = from / 64; k < words; k++) {
+			std::uint64_t w = _load_matches<_atomic>(span, k, b);
+			if (k == from / 64)
+				w &= ~(std::uint64_t)0 << (from % 64);
+			if (w)
+				return k * 64 + countr_zero(w);
+		}
+		return span.n;
+	}
+
+	inline void _validate_run(const std::size_t k) {
+		if (k == 0)
+			throw std::invalid_argument("k cannot be == 0.");
+	}
+
+	// Sets the bits [start, start + k) if they're all 0. If one of them isn't, then the bytes it already set are put back and it returns false.
+	inline bool _try_claim(const BitSpan& span, const std::size_t start, const std::size_t k) {
+		const std::size_t first = span.shift + start; // relative to span.page
+		const std::size_t last = first + k; // exclusive
+		for (std::size_t byte = first / CHAR_SIZE; byte * CHAR_SIZE < last; byte++) {
+			const std::size_t low = byte * CHAR_SIZE < first ? first % CHAR_SIZE : 0;
+			const std::size_t high = (byte + 1) * CHAR_SIZE > last ? last % CHAR_SIZE : CHAR_SIZE;
+			const unsigned char mask = (unsigned char)((0xFF >> (CHAR_SIZE - (high - low))) << low);
+			unsigned char expected = _atomic_load(span.page + byte);
+			do {
+				if (expected & mask) { // somebody beat us to it
+					for (std::size_t undo = first / CHAR_SIZE; undo < byte; undo++) {
+						const std::size_t undo_low = undo * CHAR_SIZE < first ? first % CHAR_SIZE : 0;
+						_atomic_fetch_and(span.page + undo, (unsigned char)~(0xFF << undo_low));
+					}
+					return false;
+				}
+			} while (!_atomic_compare_exchange(span.page + byte, expected, (unsigned char)(expected | mask)));
+		}
+		return true;
+	}
+
+	// find_first_fit(), reading the bits with relaxed atomic loads if _atomic.
+	template < bool _atomic >
+	std::size_t _find_first_fit(const ConstBitSpan& span, const std::size_t k, const bool b, const std::size_t from) {
+		_validate_run(k);
+		if (from >= span.n || span.n - from < k)
+			return span.n;
+
+		if (k <= 64) {
+			// Folding: after each step, bit j of lo is set if the len bits starting at j (going into hi if they have to) are all set.
+			const std::size_t words = (span.n + 63) / 64;
+			std::uint64_t hi = _load_matches<_atomic>(span, from / 64, b);
+			for (std::size_t q = from / 64; q < words; q++) {
+				std::uint64_t lo = hi;
+				hi = q + 1 < words ? _load_matches<_atomic>(span, q + 1, b) : 0;
+				if (q == from / 64)
+					lo &= ~(std::uint64_t)0 << (from % 64);
+				if (!lo)
+					continue;
+				// hi only has to be right for its low bits (the ones lo borrows), so it's fine that it can't see the word after it.
+				std::uint64_t fold_hi = hi;
+				for (std::size_t len = 1; len < k && lo;) {
+					const std::size_t by = len < k - len ? len : k - len; // 1 to 32
+					lo &= (lo >> by) | (fold_hi << (64 - by));
+					fold_hi &= fold_hi >> by;
+					len += by;
+				}
+				if (lo)
+					return q * 64 + countr_zero(lo);
+			}
+			return span.n;
+		}
 
-	for (unsigned char* it = (unsigned char*)(reverse ? end : begin); it != (reverse ? begin : end); it += reverse ? -1 : 1) {
-		for (unsigned char i = (reverse ? CHAR_SIZE : 0); (reverse ? i > 0 : i < CHAR_SIZE); i += reverse ? -1 : 1) {
-			f(get(it, CHAR_SIZE, (reverse ? i - 1 : i)));
+		// Jumping from run to run. Each step skips over a whole run, no matter how long it is.
+		std::size_t i = from;
+		while (i < span.n) {
+			const std::size_t start = _find_match<_atomic>(span, i, b);
+			if (span.n - start < k) // includes start == span.n
+				return span.n;
+			const std::size_t end = _find_match<_atomic>(span, start, !b);
+			if (end - start >= k)
+				return start;
+			i = end;
 		}
+		return span.n;
 	}
+
+	// find_next_fit(), reading the bits with relaxed atomic loads if _atomic.
+	template < bool _atomic >
+	std::size_t _find_next_fit(const ConstBitSpan& span, const std::size_t k, const bool b, const std::size_t hint) {
+		const std::size_t found = _find_first_fit<_atomic>(span, k, b, hint);
+		if (found != span.n || hint == 0)
+			return found;
+		return _find_first_fit<_atomic>(span, k, b, 0);
+	}
+};
+
+_BITUTILS_INLINE std::size_t BitUtils::find_first_fit(const ConstBitSpan& span, const std::size_t k, const bool b, const std::size_t from) {
+	return _find_first_fit<false>(span, k, b, from);
 }
 
-template<class UnaryFunction>
-void BitUtils::for_each_bit(
-	const void* const begin,
+_BITUTILS_INLINE std::size_t BitUtils::find_first_fit(const void* const block,
 	const std::size_t start_bit,
-	const void* const end,
 	const std::size_t end_bit,
-	UnaryFunction f
+	const std::size_t k,
+	const bool b
 ) {
+	return find_first_fit(ConstBitSpan(block, start_bit, end_bit), k, b, 0);
+}
 
-	// We are going to convert our parameters so we can represent this as one whole range (to make it easier to iterate over)
-	// We accomplish this through a formula I have derived:
-	// n = CHAR_SIZE * (real_end - real_begin) + real_end_bit - real_start_bit
-	// If in the case of a reverse iteration, then we just swap the values of between the start/begin and end values respectively.
+_BITUTILS_INLINE std::size_t BitUtils::find_first_fit(const void* const block,
+	const std::size_t n,
+	const std::size_t k,
+	const bool b
+) {
+	return find_first_fit(ConstBitSpan(block, n), k, b, 0);
+}
 
-	auto real_begin = (unsigned char*)begin + (start_bit / CHAR_SIZE); 
-	auto real_start_bit = start_bit % CHAR_SIZE;
-	auto real_end = (unsigned char*)end + (end_bit / CHAR_SIZE);
-	auto real_end_bit = end_bit % CHAR_SIZE;
+_BITUTILS_INLINE std::size_t BitUtils::find_best_fit(const ConstBitSpan& span, const std::size_t k, const bool b) {
+	_validate_run(k);
+	std::size_t best = span.n;
+	std::size_t best_length = (std::size_t)-1;
+	std::size_t i = 0;
+	while (i < span.n) {
+		const std::size_t start = _find_match<false>(span, i, b);
+		if (start == span.n)
+			break;
+		const std::size_t end = _find_match<false>(span, start, !b);
+		if (end - start >= k && end - start < best_length) {
+			best = start;
+			best_length = end - start;
+			if (best_length == k) // can't do any better than this
+				break;
+		}
+		i = end;
+	}
+	return best;
+}
 
-	if (real_begin == real_end && real_start_bit == real_end_bit)
-		throw std::invalid_argument("start_bit refers to the same bit as end_bit, and that isn't allowed.");
+_BITUTILS_INLINE std::size_t BitUtils::find_next_fit(const ConstBitSpan& span, const std::size_t k, const bool b, const std::size_t hint) {
+	return _find_next_fit<false>(span, k, b, hint);
+}
 
-	bool reverse = real_begin > real_end;
-	auto n = CHAR_SIZE * (reverse ? real_begin - real_end : real_end - real_begin)
-		+ (reverse ? real_start_bit : real_end_bit)
-		- (reverse ? real_end_bit : real_start_bit);
+_BITUTILS_INLINE std::size_t BitUtils::claim_run(const BitSpan& span, const std::size_t k, const std::size_t hint) {
+	// The search only uses relaxed loads, so what it finds is only a guess. _try_claim() is what makes sure nobody else has the bits.
+	std::size_t i = hint;
+	while (true) {
+		const std::size_t start = _find_next_fit<true>(span, k, 0, i);
+		if (start == span.n || _try_claim(span, start, k))
+			return start;
+		i = start + 1; // somebody else got some of it, so look past it
+		if (i >= span.n)
+			i = 0;
+	}
+}
 
-	// the bounds will be as follows:
-	// Not reverse: n, real_start_bit, real_start_bit + n
-	// Reverse:     n, real_end_bit, real_end_bit + n
+_BITUTILS_INLINE void BitUtils::release_run(const BitSpan& span, const std::size_t start, const std::size_t k) {
+	const std::size_t first = span.shift + start;
+	const std::size_t last = first + k;
+	for (std::size_t byte = first / CHAR_SIZE; byte * CHAR_SIZE < last; byte++) {
+		const std::size_t low = byte * CHAR_SIZE < first ? first % CHAR_SIZE : 0;
+		const std::size_t high = (byte + 1) * CHAR_SIZE > last ? last % CHAR_SIZE : CHAR_SIZE;
+		_atomic_fetch_and(span.page + byte, (unsigned char)~((0xFF >> (CHAR_SIZE - (high - low))) << low));
+	}
+}
 
-	for (std::size_t i = (reverse ? n : 0); (reverse ? i > 0 : i < n); i += (reverse ? -1 : 1)) {
-		f(get(
-			reverse ? real_end : real_begin,
-			reverse ? real_end_bit : real_start_bit,
-			(reverse ? real_end_bit : real_start_bit) + n,
-			reverse ? i - 1 : i
-		));
+// ============ ATOMIC BITS ============
+
+namespace BitUtils {
+	// The bits of word k (or byte k, for bytes) that are below n. Bits past n are left alone by everything that works on whole words.
+	inline std::uint64_t _valid_bits(const std::size_t n, const std::size_t k, const std::size_t width) {
+		if ((k + 1) * width <= n)
+			return ~(std::uint64_t)0 >> (64 - width);
+		return ((std::uint64_t)1 << (n - k * width)) - 1;
+	}
+
+	// Sets the bits of the mask in the word to b with a CAS, leaving the rest alone. Doesn't write if they're already b.
+	inline void _atomic_set_masked(std::uint64_t* const word, const std::uint64_t mask, const bool b, const MemoryOrder order) {
+		std::uint64_t expected = _atomic_load(word, order);
+		while (true) {
+			const std::uint64_t desired = b ? expected | mask : expected & ~mask;
+			if (desired == expected || _atomic_compare_exchange(word, expected, desired, order))
+				return;
+		}
+	}
+
+	// dst op= src a word at a time, then a byte at a time past the last whole word.
+	inline void _atomic_bitwise(const void* const src, void* const dst, const std::size_t n, const _AtomicOp op, const MemoryOrder order) {
+		if (n == 0)
+			throw std::invalid_argument("n cannot be == 0.");
+		const std::size_t words = _atomic_words(dst, n);
+		for (std::size_t k = 0; k < words; k++) {
+			std::uint64_t value;
+			memcpy(&value, (const unsigned char*)src + k * sizeof(std::uint64_t), sizeof(std::uint64_t));
+			const std::uint64_t valid = _valid_bits(n, k, 64);
+			std::uint64_t* const word = (std::uint64_t*)dst + k;
+			switch (op) {
+			case _AtomicOp::AND: _atomic_fetch_and(word, value | ~valid, order); break;
+			case _AtomicOp::OR: _atomic_fetch_or(word, value & valid, order); break;
+			default: _atomic_fetch_xor(word, value & valid, order); break;
+			}
+		}
+		for (std::size_t k = words * sizeof(std::uint64_t); k < size(n); k++) {
+			const unsigned char value = ((const unsigned char*)src)[k];
+			const unsigned char valid = (unsigned char)_valid_bits(n, k, CHAR_SIZE);
+			unsigned char* const byte = (unsigned char*)dst + k;
+			switch (op) {
+			case _AtomicOp::AND: _atomic_fetch_and(byte, (unsigned char)(value | ~valid), order); break;
+			case _AtomicOp::OR: _atomic_fetch_or(byte, (unsigned char)(value & valid), order); break;
+			default: _atomic_fetch_xor(byte, (unsigned char)(value & valid), order); break;
+			}
+		}
+	}
+};
+
+_BITUTILS_INLINE void BitUtils::atomic_set_range(void* const block,
+	const std::size_t n,
+	const std::size_t start_bit,
+	const std::size_t end_bit,
+	const bool b,
+	const MemoryOrder order
+) {
+	if (start_bit > end_bit)
+		throw std::invalid_argument("start_bit cannot be > end_bit.");
+	if (end_bit > n)
+		throw std::out_of_range("end_bit is out of range for a memory block with " + std::to_string(n) + " bits to work with.");
+	const std::size_t words = _atomic_words(block, n);
+	std::size_t i = start_bit;
+	while (i < end_bit && i / 64 < words) {
+		const std::size_t shift = i % 64;
+		const std::size_t len = end_bit - i < 64 - shift ? end_bit - i : 64 - shift;
+		std::uint64_t* const word = (std::uint64_t*)block + i / 64;
+		if (len == 64) // nobody else's bits are in it
+			_atomic_store(word, b ? ~(std::uint64_t)0 : 0, order);
+		else
+			_atomic_set_masked(word, (~(std::uint64_t)0 >> (64 - len)) << shift, b, order);
+		i += len;
+	}
+	while (i < end_bit) {
+		const std::size_t shift = i % CHAR_SIZE;
+		const std::size_t len = end_bit - i < CHAR_SIZE - shift ? end_bit - i : CHAR_SIZE - shift;
+		const unsigned char mask = (unsigned char)((0xFF >> (CHAR_SIZE - len)) << shift);
+		unsigned char* const byte = (unsigned char*)block + i / CHAR_SIZE;
+		if (b)
+			_atomic_fetch_or(byte, mask, order);
+		else
+			_atomic_fetch_and(byte, (unsigned char)~mask, order);
+		i += len;
+	}
+}
+
+_BITUTILS_INLINE void BitUtils::atomic_bitwise_and(const void* const src, void* const dst, const std::size_t n, const MemoryOrder order) {
+	_atomic_bitwise(src, dst, n, _AtomicOp::AND, order);
+}
+
+_BITUTILS_INLINE void BitUtils::atomic_bitwise_or(const void* const src, void* const dst, const std::size_t n, const MemoryOrder order) {
+	_atomic_bitwise(src, dst, n, _AtomicOp::OR, order);
+}
+
+_BITUTILS_INLINE void BitUtils::atomic_bitwise_xor(const void* const src, void* const dst, const std::size_t n, const MemoryOrder order) {
+	_atomic_bitwise(src, dst, n, _AtomicOp::XOR, order);
+}
+
+_BITUTILS_INLINE std::size_t BitUtils::atomic_count(const void* const block, const std::size_t n, const MemoryOrder order) {
+	if (n == 0)
+		throw std::invalid_argument("n cannot be == 0.");
+	const std::size_t words = _atomic_words(block, n);
+	std::size_t ones = 0;
+	for (std::size_t k = 0; k < words; k++) {
+		ones += popcount(_atomic_load((const std::uint64_t*)block + k, order) & _valid_bits(n, k, 64));
+	}
+	for (std::size_t k = words * sizeof(std::uint64_t); k < size(n); k++) {
+		ones += popcount((std::uint64_t)(_atomic_load((const unsigned char*)block + k, order) & _valid_bits(n, k, CHAR_SIZE)));
 	}
+	return ones;
+}
+
+// ============ PATTERN SEARCH ============
+
+namespace BitUtils {
+	// The longest pattern (or prefix of one) the shifted copies can hold, since a 64 bit load has to fit it at all 8 bit offsets of its first byte.
+	constexpr const std::size_t _SHORT_PATTERN = 64 - 7;
+	// The number of bits the Horspool skip goes by, and how many places a haystack needs before building the skip table is worth it.
+	constexpr const std::size_t _PATTERN_GRAM = 12;
+	constexpr const std::size_t _PATTERN_SKIP_MIN = (std::size_t)1 << 14;
+
+	inline void _validate_pattern(const std::size_t pattern_bits) {
+		if (pattern_bits == 0)
+			throw std::invalid_argument("pattern_bits cannot be == 0.");
+	}
+
+	// The _PATTERN_GRAM bits of the view that start at i.
+	inline std::uint64_t _load_gram(const ConstBitSpan& span, const std::size_t i) {
+		return _load_bits(span.page + (span.shift + i) / CHAR_SIZE, (span.shift + i) % CHAR_SIZE, _PATTERN_GRAM);
+	}
+
+	// Whether bits [from_bit, pattern.n) of the pattern show up at i + from_bit in the haystack.
+	inline bool _pattern_at(const ConstBitSpan& haystack, const ConstBitSpan& pattern, const std::size_t i, const std::size_t from_bit) {
+		return equals(
+			ConstBitSpan(haystack.page, haystack.shift + i + from_bit, haystack.shift + i + pattern.n),
+			ConstBitSpan(pattern.page, pattern.shift + from_bit, pattern.shift + pattern.n));
+	}
+
+	// Calls f(i) for each i in [from, last] (lowest first) where the first len (1 to _SHORT_PATTERN) bits of the pattern show up in the haystack,
+	// until f returns false. Every byte of the haystack is loaded as a 64 bit word once and compared against the pattern shifted to each of its 8 bit offsets.
+	template < class _F >
+	void _scan_short(const ConstBitSpan& haystack, const ConstBitSpan& pattern, const std::size_t len, const std::size_t from, const std::size_t last, _F&& f) {
+		const std::uint64_t mask = ((std::uint64_t)1 << len) - 1;
+		const std::uint64_t bits = _load_word(pattern, 0, len);
+		std::uint64_t masks[CHAR_SIZE];
+		std::uint64_t copies[CHAR_SIZE];
+		for (std::size_t s = 0; s < CHAR_SIZE; s++) {
+			masks[s] = mask << s;
+			copies[s] = bits << s;
+		}
+#if defined(_BITUTILS_HAS_AVX512)
+		const __m512i masks_v = _mm512_loadu_si512(masks);
+		const __m512i copies_v = _mm512_loadu_si512(copies);
+#elif defined(_BITUTILS_HAS_AVX2)
+		const __m256i masks_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks));
+		const __m256i masks_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + 4));
+		const __m256i copies_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(copies));
+		const __m256i copies_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(copies + 4));
+#endif
+
+		// Relative to haystack.page from here on.
+		const std::size_t first = haystack.shift + from;
+		const std::size_t end = haystack.shift + last + 1;
+		const std::size_t bytes = (haystack.shift + haystack.n + CHAR_SIZE - 1) / CHAR_SIZE; // the bytes the haystack touches
+		for (std::size_t byte = first / CHAR_SIZE; byte * CHAR_SIZE < end; byte++) {
+			std::uint64_t w;
+			if (byte + sizeof(w) <= bytes)
+				memcpy(&w, haystack.page + byte, sizeof(w));
+			else // the matches that could be here end before the haystack does, so the missing bytes don't matter
+				w = _load_bits(haystack.page + byte, 0, (bytes - byte) * CHAR_SIZE);
+
+			// Bit s is set if the pattern shows up s bits into this byte.
+#if defined(_BITUTILS_HAS_AVX512)
+			std::uint64_t hits = _mm512_cmpeq_epi64_mask(_mm512_and_si512(_mm512_set1_epi64((long long)w), masks_v), copies_v);
+#elif defined(_BITUTILS_HAS_AVX2)
+			const __m256i w_v = _mm256_set1_epi64x((long long)w);
+			std::uint64_t hits = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(w_v, masks_lo), copies_lo)))
+				| (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(w_v, masks_hi), copies_hi))) << 4;
+#else
+			std::uint64_t hits = 0;
+			for (std::size_t s = 0; s < CHAR_SIZE; s++) {
+				hits |= (std::uint64_t)((w & masks[s]) == copies[s]) << s;
+			}
+#endif
+			if (!hits)
+				continue;
+			if (byte * CHAR_SIZE < first)
+				hits &= 0xFF << (first % CHAR_SIZE);
+			if ((byte + 1) * CHAR_SIZE > end)
+				hits &= 0xFF >> ((byte + 1) * CHAR_SIZE - end);
+			for (; hits; hits &= hits - 1) {
+				if (!f(byte * CHAR_SIZE + countr_zero(hits) - haystack.shift))
+					return;
+			}
+		}
+	}
+
+	// Same deal as _scan_short(), but for patterns longer than _PATTERN_GRAM, and it skips ahead Horspool style: the window moves so that
+	// its last _PATTERN_GRAM bits line up with the last place they show up in the pattern (not counting the end of the pattern).
+	template < class _F >
+	void _scan_skip(const ConstBitSpan& haystack, const ConstBitSpan& pattern, const std::size_t from, const std::size_t last, _F&& f) {
+		const std::size_t m = pattern.n;
+		std::vector<std::size_t> skip((std::size_t)1 << _PATTERN_GRAM, m - _PATTERN_GRAM + 1);
+		for (std::size_t j = 0; j + _PATTERN_GRAM < m; j++) {
+			skip[(std::size_t)_load_gram(pattern, j)] = m - _PATTERN_GRAM - j;
+		}
+		const std::uint64_t tail = _load_gram(pattern, m - _PATTERN_GRAM);
+
+		for (std::size_t i = from; i <= last;) {
+			const std::uint64_t gram = _load_gram(haystack, i + m - _PATTERN_GRAM);
+			if (gram == tail && _pattern_at(haystack, pattern, i, 0) && !f(i))
+				return;
+			i += skip[(std::size_t)gram];
+		}
+	}
+
+	// Calls f(i) for each place the pattern shows up in the haystack at or after from (lowest first), until f returns false.
+	template < class _F >
+	void _scan_pattern(const ConstBitSpan& haystack, const ConstBitSpan& pattern, const std::size_t from, _F&& f) {
+		if (pattern.n > haystack.n || from > haystack.n - pattern.n)
+			return;
+		const std::size_t last = haystack.n - pattern.n;
+		if (pattern.n <= _SHORT_PATTERN)
+			_scan_short(haystack, pattern, pattern.n, from, last, f);
+		else if (last - from >= _PATTERN_SKIP_MIN)
+			_scan_skip(haystack, pattern, from, last, f);
+		else // the first _SHORT_PATTERN bits are a filter, and the rest only gets looked at when they match
+			_scan_short(haystack, pattern, _SHORT_PATTERN, from, last, [&](const std::size_t i) {
+				return !_pattern_at(haystack, pattern, i, _SHORT_PATTERN) || f(i);
+			});
+	}
+};
+
+_BITUTILS_INLINE std::size_t BitUtils::find_pattern(const ConstBitSpan& haystack, const ConstBitSpan& pattern, const std::size_t from) {
+	std::size_t found = haystack.n;
+	_scan_pattern(haystack, pattern, from, [&found](const std::size_t i) {
+		found = i;
+		return false;
+	});
+	return found;
+}
+
+_BITUTILS_INLINE std::size_t BitUtils::find_pattern(const void* const haystack,
+	const std::size_t start_bit,
+	const std::size_t end_bit,
+	const void* const pattern,
+	const std::size_t pattern_bits
+) {
+	_validate_pattern(pattern_bits);
+	return find_pattern(ConstBitSpan(haystack, start_bit, end_bit), ConstBitSpan(pattern, pattern_bits), 0);
+}
+
+_BITUTILS_INLINE std::vector<std::size_t> BitUtils::find_all_pattern(const ConstBitSpan& haystack, const ConstBitSpan& pattern) {
+	std::vector<std::size_t> found;
+	_scan_pattern(haystack, pattern, 0, [&found](const std::size_t i) {
+		found.push_back(i);
+		return true;
+	});
+	return found;
+}
+
+_BITUTILS_INLINE std::vector<std::size_t> BitUtils::find_all_pattern(const void* const haystack,
+	const std::size_t start_bit,
+	const std::size_t end_bit,
+	const void* const pattern,
+	const std::size_t pattern_bits
+) {
+	_validate_pattern(pattern_bits);
+	return find_all_pattern(ConstBitSpan(haystack, start_bit, end_bit), ConstBitSpan(pattern, pattern_bits));
+}
+
+_BITUTILS_INLINE std::size_t BitUtils::count_pattern(const ConstBitSpan& haystack, const ConstBitSpan& pattern) {
+	std::size_t count = 0;
+	_scan_pattern(haystack, pattern, 0, [&count](const std::size_t) {
+		count++;
+		return true;
+	});
+	return count;
+}
+
+_BITUTILS_INLINE std::size_t BitUtils::count_pattern(const void* const haystack,
+	const std::size_t start_bit,
+	const std::size_t end_bit,
+	const void* const pattern,
+	const std::size_t pattern_bits
+) {
+	_validate_pattern(pattern_bits);
+	return count_pattern(ConstBitSpan(haystack, start_bit, end_bit), ConstBitSpan(pattern, pattern_bits));
 }
 
-#undef _BITUTILS_IS_LITTLE_ENDIAN
 #endif // C++11
\ No newline at end of file
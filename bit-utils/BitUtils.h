@@ -33,9 +33,42 @@
 #include <sstream>
 #include <functional>
 #include <type_traits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+#include <atomic>
 
 #define _BITUTILS_IS_LITTLE_ENDIAN (1 << 1) > 1
 
+// Define BITUTILS_HEADER_ONLY if you'd rather not build BitUtils.cpp. Everything will be pulled into this header and marked inline.
+// Otherwise, only the core functions (the ones you'll be calling bit by bit) are inline and the rest are in BitUtils.cpp.
+#if defined(BITUTILS_HEADER_ONLY)
+#define _BITUTILS_INLINE inline
+#else
+#define _BITUTILS_INLINE
+#endif
+
+// Instruction sets the word kernels are allowed to use. These are decided at compile time (ie -mavx2 or /arch:AVX2).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _BITUTILS_HAS_SSE2 1
+#endif
+#if defined(__AVX2__)
+#define _BITUTILS_HAS_AVX2 1
+#endif
+#if defined(__AVX512F__)
+#define _BITUTILS_HAS_AVX512 1
+#endif
+
+#if defined(_BITUTILS_HAS_SSE2)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #if __cplusplus >= 201100 // C++11
 /* The namespace for the BitUtils library.
 *
@@ -63,6 +96,303 @@ namespace BitUtils {
 	constexpr const std::size_t CHAR_SIZE = 8;
 #endif
 
+	// ============ WORD HELPERS ============
+
+	/* Counts the number of set bits in a 64 bit word.
+	*
+	Parameters
+	* word: the word to count.
+	*
+	Returns the number of bits that are 1.
+	*/
+	inline std::size_t popcount(const std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+		return (std::size_t)__builtin_popcountll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		return (std::size_t)__popcnt64(word);
+#else
+		std::uint64_t w = word - ((word >> 1) & 0x5555555555555555ULL);
+		w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+		w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return (std::size_t)((w * 0x0101010101010101ULL) >> 56);
+#endif
+	}
+
+	/* Counts the 0s below the lowest set bit of a 64 bit word (ie tzcnt).
+	*
+	Parameters
+	* word: the word to look at.
+	*
+	Returns the index of the lowest set bit, or 64 if the word is 0.
+	*/
+	inline std::size_t countr_zero(const std::uint64_t word) {
+		if (word == 0)
+			return 64;
+#if defined(__GNUC__) || defined(__clang__)
+		return (std::size_t)__builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long i;
+		_BitScanForward64(&i, word);
+		return (std::size_t)i;
+#else
+		std::size_t i = 0;
+		while (!((word >> i) & 1))
+			i++;
+		return i;
+#endif
+	}
+
+	/* Counts the 0s above the highest set bit of a 64 bit word (ie lzcnt).
+	*
+	Parameters
+	* word: the word to look at.
+	*
+	Returns 63 minus the index of the highest set bit, or 64 if the word is 0.
+	*/
+	inline std::size_t countl_zero(const std::uint64_t word) {
+		if (word == 0)
+			return 64;
+#if defined(__GNUC__) || defined(__clang__)
+		return (std::size_t)__builtin_clzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long i;
+		_BitScanReverse64(&i, word);
+		return (std::size_t)(63 - i);
+#else
+		std::size_t i = 0;
+		while (!((word << i) & 0x8000000000000000ULL))
+			i++;
+		return i;
+#endif
+	}
+
+	/* The memory orders the atomic functions can be asked to use (see ATOMIC BITS). They mean the same as the std::memory_order ones.
+	* This is its own type because std::memory_order went from an enum to an enum class in C++20, and BitUtils.cpp has to be usable from a different
+	* standard than it was built with.
+	*/
+	enum class MemoryOrder { RELAXED, ACQUIRE, RELEASE, ACQ_REL, SEQ_CST };
+
+	// The orders a load and a store are allowed to use, for when the order was picked for a read-modify-write (ie acq_rel).
+	inline MemoryOrder _load_order(const MemoryOrder order) {
+		return order == MemoryOrder::RELEASE ? MemoryOrder::RELAXED
+			: order == MemoryOrder::ACQ_REL ? MemoryOrder::ACQUIRE
+			: order;
+	}
+
+	inline MemoryOrder _store_order(const MemoryOrder order) {
+		return order == MemoryOrder::ACQUIRE ? MemoryOrder::RELAXED
+			: order == MemoryOrder::ACQ_REL ? MemoryOrder::RELEASE
+			: order;
+	}
+
+#if defined(__cpp_lib_atomic_ref)
+	inline std::memory_order _std_order(const MemoryOrder order) {
+		switch (order) {
+		case MemoryOrder::RELAXED: return std::memory_order_relaxed;
+		case MemoryOrder::ACQUIRE: return std::memory_order_acquire;
+		case MemoryOrder::RELEASE: return std::memory_order_release;
+		case MemoryOrder::ACQ_REL: return std::memory_order_acq_rel;
+		default: return std::memory_order_seq_cst;
+		}
+	}
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	inline int _builtin_order(const MemoryOrder order) {
+		switch (order) {
+		case MemoryOrder::RELAXED: return __ATOMIC_RELAXED;
+		case MemoryOrder::ACQUIRE: return __ATOMIC_ACQUIRE;
+		case MemoryOrder::RELEASE: return __ATOMIC_RELEASE;
+		case MemoryOrder::ACQ_REL: return __ATOMIC_ACQ_REL;
+		default: return __ATOMIC_SEQ_CST;
+		}
+	}
+#endif
+
+	// Atomic read-modify-writes on single bytes of a memory block. They work on plain memory (there's no std::atomic in a void*),
+	// so they go through the compiler's builtins. Bytes are used instead of words so we never touch memory outside of the block.
+
+	inline unsigned char _atomic_load(const unsigned char* const byte, const MemoryOrder order = MemoryOrder::ACQUIRE) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __atomic_load_n(byte, _builtin_order(_load_order(order)));
+#elif defined(_MSC_VER)
+		return (unsigned char)_InterlockedOr8((volatile char*)byte, 0);
+#else
+		return *(volatile const unsigned char*)byte;
+#endif
+	}
+
+	// If *byte == expected, then *byte = desired and returns true. Otherwise expected = *byte and returns false.
+	inline bool _atomic_compare_exchange(unsigned char* const byte, unsigned char& expected, const unsigned char desired) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __atomic_compare_exchange_n(byte, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+		const unsigned char old = (unsigned char)_InterlockedCompareExchange8((volatile char*)byte, (char)desired, (char)expected);
+		const bool exchanged = old == expected;
+		expected = old;
+		return exchanged;
+#else
+		if (*byte != expected) {
+			expected = *byte;
+			return false;
+		}
+		*byte = desired;
+		return true;
+#endif
+	}
+
+	// *byte &= mask and returns what *byte was.
+	inline unsigned char _atomic_fetch_and(unsigned char* const byte, const unsigned char mask, const MemoryOrder order = MemoryOrder::ACQ_REL) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __atomic_fetch_and(byte, mask, _builtin_order(order));
+#elif defined(_MSC_VER)
+		return (unsigned char)_InterlockedAnd8((volatile char*)byte, (char)mask);
+#else
+		const unsigned char old = *byte;
+		*byte &= mask;
+		return old;
+#endif
+	}
+
+	// *byte |= mask and returns what *byte was.
+	inline unsigned char _atomic_fetch_or(unsigned char* const byte, const unsigned char mask, const MemoryOrder order = MemoryOrder::ACQ_REL) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __atomic_fetch_or(byte, mask, _builtin_order(order));
+#elif defined(_MSC_VER)
+		return (unsigned char)_InterlockedOr8((volatile char*)byte, (char)mask);
+#else
+		const unsigned char old = *byte;
+		*byte |= mask;
+		return old;
+#endif
+	}
+
+	// *byte ^= mask and returns what *byte was.
+	inline unsigned char _atomic_fetch_xor(unsigned char* const byte, const unsigned char mask, const MemoryOrder order = MemoryOrder::ACQ_REL) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __atomic_fetch_xor(byte, mask, _builtin_order(order));
+#elif defined(_MSC_VER)
+		return (unsigned char)_InterlockedXor8((volatile char*)byte, (char)mask);
+#else
+		const unsigned char old = *byte;
+		*byte ^= mask;
+		return old;
+#endif
+	}
+
+	// The same for whole 64 bit words, which have to be 8 byte aligned. With C++20 they go through std::atomic_ref.
+
+	inline std::uint64_t _atomic_load(const std::uint64_t* const word, const MemoryOrder order) {
+#if defined(__cpp_lib_atomic_ref)
+		return std::atomic_ref<std::uint64_t>(*const_cast<std::uint64_t*>(word)).load(_std_order(_load_order(order)));
+#elif defined(__GNUC__) || defined(__clang__)
+		return __atomic_load_n(word, _builtin_order(_load_order(order)));
+#elif defined(_MSC_VER)
+		return (std::uint64_t)_InterlockedOr64((volatile long long*)word, 0);
+#else
+		return *(volatile const std::uint64_t*)word;
+#endif
+	}
+
+	inline void _atomic_store(std::uint64_t* const word, const std::uint64_t value, const MemoryOrder order) {
+#if defined(__cpp_lib_atomic_ref)
+		std::atomic_ref<std::uint64_t>(*word).store(value, _std_order(_store_order(order)));
+#elif defined(__GNUC__) || defined(__clang__)
+		__atomic_store_n(word, value, _builtin_order(_store_order(order)));
+#elif defined(_MSC_VER)
+		_InterlockedExchange64((volatile long long*)word, (long long)value);
+#else
+		*(volatile std::uint64_t*)word = value;
+#endif
+	}
+
+	inline std::uint64_t _atomic_fetch_and(std::uint64_t* const word, const std::uint64_t mask, const MemoryOrder order) {
+#if defined(__cpp_lib_atomic_ref)
+		return std::atomic_ref<std::uint64_t>(*word).fetch_and(mask, _std_order(order));
+#elif defined(__GNUC__) || defined(__clang__)
+		return __atomic_fetch_and(word, mask, _builtin_order(order));
+#elif defined(_MSC_VER)
+		return (std::uint64_t)_InterlockedAnd64((volatile long long*)word, (long long)mask);
+#else
+		const std::uint64_t old = *word;
+		*word &= mask;
+		return old;
+#endif
+	}
+
+	inline std::uint64_t _atomic_fetch_or(std::uint64_t* const word, const std::uint64_t mask, const MemoryOrder order) {
+#if defined(__cpp_lib_atomic_ref)
+		return std::atomic_ref<std::uint64_t>(*word).fetch_or(mask, _std_order(order));
+#elif defined(__GNUC__) || defined(__clang__)
+		return __atomic_fetch_or(word, mask, _builtin_order(order));
+#elif defined(_MSC_VER)
+		return (std::uint64_t)_InterlockedOr64((volatile long long*)word, (long long)mask);
+#else
+		const std::uint64_t old = *word;
+		*word |= mask;
+		return old;
+#endif
+	}
+
+	inline std::uint64_t _atomic_fetch_xor(std::uint64_t* const word, const std::uint64_t mask, const MemoryOrder order) {
+#if defined(__cpp_lib_atomic_ref)
+		return std::atomic_ref<std::uint64_t>(*word).fetch_xor(mask, _std_order(order));
+#elif defined(__GNUC__) || defined(__clang__)
+		return __atomic_fetch_xor(word, mask, _builtin_order(order));
+#elif defined(_MSC_VER)
+		return (std::uint64_t)_InterlockedXor64((volatile long long*)word, (long long)mask);
+#else
+		const std::uint64_t old = *word;
+		*word ^= mask;
+		return old;
+#endif
+	}
+
+	// If *word == expected, then *word = desired and returns true. Otherwise expected = *word and returns false.
+	inline bool _atomic_compare_exchange(std::uint64_t* const word, std::uint64_t& expected, const std::uint64_t desired, const MemoryOrder order) {
+#if defined(__cpp_lib_atomic_ref)
+		return std::atomic_ref<std::uint64_t>(*word).compare_exchange_weak(expected, desired, _std_order(order), _std_order(_load_order(order)));
+#elif defined(__GNUC__) || defined(__clang__)
+		return __atomic_compare_exchange_n(word, &expected, desired, true, _builtin_order(order), _builtin_order(_load_order(order)));
+#elif defined(_MSC_VER)
+		const std::uint64_t old = (std::uint64_t)_InterlockedCompareExchange64((volatile long long*)word, (long long)desired, (long long)expected);
+		const bool exchanged = old == expected;
+		expected = old;
+		return exchanged;
+#else
+		if (*word != expected) {
+			expected = *word;
+			return false;
+		}
+		*word = desired;
+		return true;
+#endif
+	}
+
+	// Asks for the cache line that address is in, for loops that know where they're going next.
+	inline void _prefetch(const void* const address) {
+#if defined(_BITUTILS_HAS_SSE2)
+		_mm_prefetch((const char*)address, _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(address);
+#else
+		(void)address;
+#endif
+	}
+
+	// How many keys the batched lookups (ie BlockedBloomFilter::contains()) hash and prefetch before touching any of them, so the cache misses overlap.
+	constexpr const std::size_t _PREFETCH_BATCH = 16;
+
+	// MurmurHash3's finalizer, for keys that are nowhere near random (like IDs). It's a bijection, so different keys never mix to the same value.
+	inline std::uint64_t _mix64(std::uint64_t key) {
+		key ^= key >> 33;
+		key *= 0xFF51AFD7ED558CCDULL;
+		key ^= key >> 33;
+		key *= 0xC4CEB9FE1A85EC53ULL;
+		key ^= key >> 33;
+		return key;
+	}
+
 	/* Calculates the size (in bytes) of a memory block that is of size n (in bits).
 	*
 	Parameters
@@ -70,9 +400,73 @@ namespace BitUtils {
 	*
 	Returns the size of the memory block in bytes.
 	*/
-	inline std::size_t size(const std::size_t n);
-
-	inline std::size_t size(const std::size_t start_bit, const std::size_t end_bit);
+	inline std::size_t size(const std::size_t n) {
+		if (n <= CHAR_SIZE)
+			return 1;
+		return n / CHAR_SIZE + (n % CHAR_SIZE != 0);
+	}
+
+	inline std::size_t size(const std::size_t start_bit, const std::size_t end_bit) {
+		return size(start_bit) + size(end_bit - start_bit);
+	}
+
+	// ============ CORE FUNCTIONS ============
+	// These are defined here so that the compiler can inline them into your loops.
+
+	inline void _validateBounds(const std::size_t start_bit, const std::size_t end_bit, const std::size_t i) {
+		// 0 <= start_bit < end_bit
+		// end_bit - start_bit <= n
+		// i < end_bit - start_bit
+		if (start_bit >= end_bit) // guarantees start_bit < end_bit
+			throw std::invalid_argument("start_bit cannot be >= end_bit");
+
+		// i is the local index for the unbounded/bounded bit array.
+
+		if (i >= end_bit - start_bit)
+			throw std::out_of_range("i is out of range for a bounded memory block with " + std::to_string(end_bit - start_bit) + " bits to work with.");
+	}
+
+	inline void _validateBounds(const std::size_t n, const std::size_t i) {
+		// 0 <= i < n
+		if (n == 0) // guarantees n > 0 (unsigned numbers only)
+			throw std::invalid_argument("n cannot be == 0.");
+		if (i >= n) {
+			if (n != size(n) * CHAR_SIZE)
+				throw std::out_of_range("i is out of range for a soft bounded memory block with " + std::to_string(n) + " bits to work with.");
+			else
+				throw std::out_of_range("i is out of range for an unbounded memory block with " + std::to_string(n) + " bits to work with.");
+		}
+	}
+
+	// Gets the byte that holds the local bit i.
+	inline unsigned char* _getPage(void* const src, const std::size_t start_bit, const std::size_t end_bit, const std::size_t i) {
+		_validateBounds(start_bit, end_bit, i);
+		return (unsigned char*)src + ((i + start_bit) / CHAR_SIZE);
+	}
+
+	inline const unsigned char* _getPage(const void* const src, const std::size_t start_bit, const std::size_t end_bit, const std::size_t i) {
+		_validateBounds(start_bit, end_bit, i);
+		return (const unsigned char*)src + ((i + start_bit) / CHAR_SIZE);
+	}
+
+	inline unsigned char* _getPage(void* const src, const std::size_t n, const std::size_t i) {
+		_validateBounds(n, i);
+		return (unsigned char*)src + (i / CHAR_SIZE);
+	}
+
+	inline const unsigned char* _getPage(const void* const src, const std::size_t n, const std::size_t i) {
+		_validateBounds(n, i);
+		return (const unsigned char*)src + (i / CHAR_SIZE);
+	}
+
+	// The mask for bit i within its byte.
+	inline unsigned char _bitMask(const std::size_t i) {
+#if _BITUTILS_IS_LITTLE_ENDIAN
+		return (unsigned char)(1 << (i % CHAR_SIZE));
+#else
+		return (unsigned char)(0x80 >> (i % CHAR_SIZE));
+#endif
+	}
 
 	/* Allocates a memory block on the heap and guarantees that it is at least of size n (in bits).
 	* The memory block is comprised entirely of 0s (calloc).
@@ -95,11 +489,13 @@ namespace BitUtils {
 	*
 	Returns true if the bit is set, and false if it isn't.
 	*/
-	bool get(const void* const block,
+	inline bool get(const void* const block,
 		const std::size_t start_bit,
 		const std::size_t end_bit,
 		const std::size_t i
-	);
+	) {
+		return *_getPage(block, start_bit, end_bit, i) & _bitMask(i + start_bit);
+	}
 
 	/* Gets the selected bit's state.
 	* 
@@ -108,9 +504,12 @@ namespace BitUtils {
 	* n: the size of the memory block in bits. Doesn't have to be a log of 2.
 	* i: the index of the bit you want to get.
 	*/
-	bool get(const void* const block,
+	inline bool get(const void* const block,
 		const std::size_t n,
-		const std::size_t i);
+		const std::size_t i
+	) {
+		return *_getPage(block, n, i) & _bitMask(i);
+	}
 
 	/* Flips the selected bit from true to false or vice versa.
 	*
@@ -120,10 +519,13 @@ namespace BitUtils {
 	* end_bit: the ending bit of your bounds (exclusive).
 	* i: the local index of the bit you want to flip.
 	*/
-	void flip(void* const block,
+	inline void flip(void* const block,
 		const std::size_t start_bit,
 		const std::size_t end_bit,
-		const std::size_t i);
+		const std::size_t i
+	) {
+		*_getPage(block, start_bit, end_bit, i) ^= _bitMask(i + start_bit);
+	}
 
 	/* Flips the selected bit from true to false or vice versa.
 	* 
@@ -132,9 +534,12 @@ namespace BitUtils {
 	* n: the size of the memory block in bits. Doesn't have to be a log of 2.
 	* i: the index of the bit you want to flip.
 	*/
-	void flip(void* const block,
+	inline void flip(void* const block,
 		const std::size_t n,
-		const std::size_t i);
+		const std::size_t i
+	) {
+		*_getPage(block, n, i) ^= _bitMask(i);
+	}
 
 	/* Sets the selected bit to reflect the given boolean.
 	*
@@ -144,14 +549,19 @@ namespace BitUtils {
 	* end_bit: the ending bit of your bounds (exclusive).
 	* i: the local index of the bit you want to set.
 	* b: the state you want to set the bit to.
-	*
-	For you performance min-maxers, it is worth noting that setting a bit to false is slower than setting it to true. In general, the flip() function is faster than this.
 	*/
-	void set(void* const block,
+	inline void set(void* const block,
 		const std::size_t start_bit,
 		const std::size_t end_bit,
 		const std::size_t i,
-		const bool b);
+		const bool b
+	) {
+		unsigned char* const page = _getPage(block, start_bit, end_bit, i);
+		if (b)
+			*page |= _bitMask(i + start_bit);
+		else
+			*page &= (unsigned char)~_bitMask(i + start_bit);
+	}
 
 	/* Sets the selected bit to reflect the given boolean.
 	*
@@ -160,13 +570,18 @@ namespace BitUtils {
 	* n: the size of the memory block in bits. Doesn't have to be a log of 2.
 	* i: the local index of the bit you want to set.
 	* b: the state you want to set the bit to.
-	*
-	For you performance min-maxers, it is worth noting that setting a bit to false is slower than setting it to true. In general, the flip() function is faster than this.
 	*/
-	void set(void* const block,
+	inline void set(void* const block,
 		const std::size_t n,
 		const std::size_t i,
-		const bool b);
+		const bool b
+	) {
+		unsigned char* const page = _getPage(block, n, i);
+		if (b)
+			*page |= _bitMask(i);
+		else
+			*page &= (unsigned char)~_bitMask(i);
+	}
 
 	/* Fills the memory block with 1s or 0s.
 	*
@@ -812,7 +1227,13 @@ namespace BitUtils {
 	Note that a reverse iteration can be achieved if begin > end.
 	*/
 	template < class UnaryFunction >
-	void for_each_byte(void* const begin, void* const end, UnaryFunction f);
+	void for_each_byte(void* const begin, void* const end, UnaryFunction f) {
+		bool reverse = begin > end;
+
+		for (unsigned char* it = (unsigned char*)(reverse ? end : begin); it != (reverse ? begin : end); it += reverse ? -1 : 1) {
+			f(reverse ? it - 1 : it);
+		}
+	}
 
 	/* For each function that iterates over each bit in a memory block.
 	*
@@ -824,21 +1245,1150 @@ namespace BitUtils {
 	Note that a reverse iteration can be achieved if begin > end.
 	*/
 	template < class UnaryFunction >
-	void for_each_bit(const void* const begin, const void* const end, UnaryFunction f);
+	void for_each_bit(const void* const begin, const void* const end, UnaryFunction f) {
+		bool reverse = begin > end;
+
+		for (unsigned char* it = (unsigned char*)(reverse ? end : begin); it != (reverse ? begin : end); it += reverse ? -1 : 1) {
+			for (unsigned char i = (reverse ? CHAR_SIZE : 0); (reverse ? i > 0 : i < CHAR_SIZE); i += reverse ? -1 : 1) {
+				f(get(it, CHAR_SIZE, (reverse ? i - 1 : i)));
+			}
+		}
+	}
 
 	/* For each function that iterates over each bit in a bounded memory block.
 	*/
-	template < class UnaryFunction >
+	template<class UnaryFunction>
 	void for_each_bit(
 		const void* const begin,
 		const std::size_t start_bit,
 		const void* const end,
 		const std::size_t end_bit,
 		UnaryFunction f
-	);
+	) {
+
+		// We are going to convert our parameters so we can represent this as one whole range (to make it easier to iterate over)
+		// We accomplish this through a formula I have derived:
+		// n = CHAR_SIZE * (real_end - real_begin) + real_end_bit - real_start_bit
+		// If in the case of a reverse iteration, then we just swap the values of between the start/begin and end values respectively.
+
+		auto real_begin = (unsigned char*)begin + (start_bit / CHAR_SIZE); 
+		auto real_start_bit = start_bit % CHAR_SIZE;
+		auto real_end = (unsigned char*)end + (end_bit / CHAR_SIZE);
+		auto real_end_bit = end_bit % CHAR_SIZE;
+
+		if (real_begin == real_end && real_start_bit == real_end_bit)
+			throw std::invalid_argument("start_bit refers to the same bit as end_bit, and that isn't allowed.");
+
+		bool reverse = real_begin > real_end;
+		auto n = CHAR_SIZE * (reverse ? real_begin - real_end : real_end - real_begin)
+			+ (reverse ? real_start_bit : real_end_bit)
+			- (reverse ? real_end_bit : real_start_bit);
+
+		// the bounds will be as follows:
+		// Not reverse: n, real_start_bit, real_start_bit + n
+		// Reverse:     n, real_end_bit, real_end_bit + n
+
+		for (std::size_t i = (reverse ? n : 0); (reverse ? i > 0 : i < n); i += (reverse ? -1 : 1)) {
+			f(get(
+				reverse ? real_end : real_begin,
+				reverse ? real_end_bit : real_start_bit,
+				(reverse ? real_end_bit : real_start_bit) + n,
+				reverse ? i - 1 : i
+			));
+		}
+	}
+
+	// ============ BIT ITERATORS ============
+
+	/* A reference to a single bit, since you can't have a reference to one (same deal as std::vector<bool>::reference).
+	* It reads like a bool and assigning a bool to it sets the bit.
+	*/
+	class bit_reference {
+	public:
+		bit_reference(unsigned char* const page, const unsigned char mask) : page(page), mask(mask) {}
+
+		operator bool() const {
+			return (*page & mask) != 0;
+		}
+
+		bool operator~() const {
+			return (*page & mask) == 0;
+		}
+
+		bit_reference& operator=(const bool b) {
+			if (b)
+				*page |= mask;
+			else
+				*page &= (unsigned char)~mask;
+			return *this;
+		}
+
+		bit_reference& operator=(const bit_reference& other) {
+			return *this = (bool)other;
+		}
+
+		void flip() {
+			*page ^= mask;
+		}
+
+	private:
+		unsigned char* page;
+		unsigned char mask;
+	};
+
+	inline void swap(bit_reference left, bit_reference right) {
+		const bool temp = left;
+		left = (bool)right;
+		right = temp;
+	}
+
+	/* A random access iterator over the bits of a memory block, so they can be used with <algorithm>.
+	* Use bit_iterator and const_bit_iterator instead of this.
+	*
+	* Like std::vector<bool>, dereferencing gives you a proxy (bit_reference) instead of a real reference. find(), count(), fill(), copy()
+	* and equal() are overloaded for these iterators (found through ADL, so call them unqualified) to use the word kernels instead of going bit by bit.
+	*/
+	template < bool _const >
+	class _bit_iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef bool value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef void pointer;
+		typedef typename std::conditional<_const, bool, bit_reference>::type reference;
+		typedef typename std::conditional<_const, const unsigned char*, unsigned char*>::type page_type;
+		typedef typename std::conditional<_const, const void*, void*>::type block_type;
+
+		_bit_iterator() : page(nullptr), offset(0) {}
+
+		/* Makes an iterator that points at bit i of the memory block. */
+		_bit_iterator(const block_type block, const std::size_t i) : page((page_type)block + i / CHAR_SIZE), offset(i % CHAR_SIZE) {}
+
+		// a bit_iterator can always be used as a const_bit_iterator
+		template < bool _other, class = typename std::enable_if<_const && !_other>::type >
+		_bit_iterator(const _bit_iterator<_other>& other) : page(other.page), offset(other.offset) {}
+
+		reference operator*() const {
+			return deref(std::integral_constant<bool, _const>());
+		}
+
+		reference operator[](const difference_type i) const {
+			return *(*this + i);
+		}
+
+		_bit_iterator& operator++() {
+			if (++offset == CHAR_SIZE) {
+				offset = 0;
+				page++;
+			}
+			return *this;
+		}
+
+		_bit_iterator operator++(int) {
+			_bit_iterator temp = *this;
+			++*this;
+			return temp;
+		}
+
+		_bit_iterator& operator--() {
+			if (offset == 0) {
+				offset = CHAR_SIZE;
+				page--;
+			}
+			offset--;
+			return *this;
+		}
+
+		_bit_iterator operator--(int) {
+			_bit_iterator temp = *this;
+			--*this;
+			return temp;
+		}
+
+		_bit_iterator& operator+=(const difference_type by) {
+			const difference_type i = (difference_type)offset + by;
+			// rounding towards negative infinity so that the offset stays in [0, CHAR_SIZE)
+			const difference_type pages = i >= 0 ? i / (difference_type)CHAR_SIZE : -((-i + (difference_type)CHAR_SIZE - 1) / (difference_type)CHAR_SIZE);
+			page += pages;
+			offset = (std::size_t)(i - pages * (difference_type)CHAR_SIZE);
+			return *this;
+		}
+
+		_bit_iterator& operator-=(const difference_type by) {
+			return *this += -by;
+		}
+
+		_bit_iterator operator+(const difference_type by) const {
+			_bit_iterator temp = *this;
+			return temp += by;
+		}
+
+		friend _bit_iterator operator+(const difference_type by, const _bit_iterator& it) {
+			return it + by;
+		}
+
+		_bit_iterator operator-(const difference_type by) const {
+			_bit_iterator temp = *this;
+			return temp -= by;
+		}
+
+		friend difference_type operator-(const _bit_iterator& left, const _bit_iterator& right) {
+			return (left.page - right.page) * (difference_type)CHAR_SIZE + (difference_type)left.offset - (difference_type)right.offset;
+		}
+
+		friend bool operator==(const _bit_iterator& left, const _bit_iterator& right) {
+			return left.page == right.page && left.offset == right.offset;
+		}
+
+		friend bool operator!=(const _bit_iterator& left, const _bit_iterator& right) {
+			return !(left == right);
+		}
+
+		friend bool operator<(const _bit_iterator& left, const _bit_iterator& right) {
+			return left - right < 0;
+		}
+
+		friend bool operator>(const _bit_iterator& left, const _bit_iterator& right) {
+			return right < left;
+		}
+
+		friend bool operator<=(const _bit_iterator& left, const _bit_iterator& right) {
+			return !(right < left);
+		}
+
+		friend bool operator>=(const _bit_iterator& left, const _bit_iterator& right) {
+			return !(left < right);
+		}
+
+		page_type page; // the byte that holds the bit.
+		std::size_t offset; // the index of the bit within page.
+
+	private:
+		bool deref(std::true_type /* const */) const {
+			return (*page >> offset) & 1;
+		}
+
+		bit_reference deref(std::false_type /* not const */) const {
+			return bit_reference(page, (unsigned char)(1 << offset));
+		}
+	};
+
+	typedef _bit_iterator<false> bit_iterator;
+	typedef _bit_iterator<true> const_bit_iterator;
+
+	// ============ BIT SPANS ============
+
+	/* A view of a range of bits in a memory block.
+	* The bounds are validated once when the view is made, and the page (the byte holding the first bit), the shift of the first bit within
+	* that page and the masks for the edges are worked out ahead of time. The functions that take views don't validate anything, they go
+	* straight to the word kernels, so if you're doing a bunch of operations on the same ranges, this is the way to go.
+	*
+	* A view doesn't own its memory block. Copying one is cheap.
+	*/
+	struct BitSpan {
+		unsigned char* page; // the byte that holds the first bit.
+		std::size_t shift; // the index of the first bit within page.
+		std::size_t n; // the number of bits in the view.
+		std::size_t words; // the number of whole 64 bit words in the view.
+		std::uint64_t tail_mask; // the bits of the partial word at the end (if any) that are in the view.
+		unsigned char head_mask; // the bits of page that are in the view.
+
+		/* Makes a view of the bits [start_bit, end_bit) in the memory block.
+		* Throws std::invalid_argument if start_bit >= end_bit.
+		*/
+		BitSpan(void* const block, const std::size_t start_bit, const std::size_t end_bit) {
+			if (start_bit >= end_bit)
+				throw std::invalid_argument("start_bit cannot be >= end_bit");
+			page = (unsigned char*)block + start_bit / CHAR_SIZE;
+			shift = start_bit % CHAR_SIZE;
+			n = end_bit - start_bit;
+			words = n / 64;
+			tail_mask = ((std::uint64_t)1 << (n % 64)) - 1;
+			head_mask = (unsigned char)(0xFF << shift);
+		}
+
+		/* Makes a view of the first n bits in the memory block.
+		* Throws std::invalid_argument if n == 0.
+		*/
+		BitSpan(void* const block, const std::size_t n) : BitSpan(block, 0, n) {}
+
+		bit_iterator begin() const {
+			return bit_iterator(page, shift);
+		}
+
+		bit_iterator end() const {
+			return bit_iterator(page, shift + n);
+		}
+	};
+
+	/* The read only version of BitSpan. Any BitSpan can be used where a ConstBitSpan is expected. */
+	struct ConstBitSpan {
+		const unsigned char* page; // the byte that holds the first bit.
+		std::size_t shift; // the index of the first bit within page.
+		std::size_t n; // the number of bits in the view.
+		std::size_t words; // the number of whole 64 bit words in the view.
+		std::uint64_t tail_mask; // the bits of the partial word at the end (if any) that are in the view.
+		unsigned char head_mask; // the bits of page that are in the view.
+
+		/* Makes a view of the bits [start_bit, end_bit) in the memory block.
+		* Throws std::invalid_argument if start_bit >= end_bit.
+		*/
+		ConstBitSpan(const void* const block, const std::size_t start_bit, const std::size_t end_bit) {
+			if (start_bit >= end_bit)
+				throw std::invalid_argument("start_bit cannot be >= end_bit");
+			page = (const unsigned char*)block + start_bit / CHAR_SIZE;
+			shift = start_bit % CHAR_SIZE;
+			n = end_bit - start_bit;
+			words = n / 64;
+			tail_mask = ((std::uint64_t)1 << (n % 64)) - 1;
+			head_mask = (unsigned char)(0xFF << shift);
+		}
+
+		/* Makes a view of the first n bits in the memory block.
+		* Throws std::invalid_argument if n == 0.
+		*/
+		ConstBitSpan(const void* const block, const std::size_t n) : ConstBitSpan(block, 0, n) {}
+
+		ConstBitSpan(const BitSpan& other) :
+			page(other.page), shift(other.shift), n(other.n), words(other.words), tail_mask(other.tail_mask), head_mask(other.head_mask) {}
+
+		const_bit_iterator begin() const {
+			return const_bit_iterator(page, shift);
+		}
+
+		const_bit_iterator end() const {
+			return const_bit_iterator(page, shift + n);
+		}
+	};
+
+	// The word kernels. A view is treated as a run of 64 bit words that all start `shift` bits into their first byte, where word k is
+	// made of bits [64k, 64k + 64) of the view. Loads and stores only ever touch the bytes that hold the bits they were asked for,
+	// so we never read or write past the ends of a memory block. Like the rest of the library, this assumes a little endian machine.
+
+	// Reads len (1 to 64) bits that start shift bits into page.
+	inline std::uint64_t _load_bits(const unsigned char* const page, const std::size_t shift, const std::size_t len) {
+		const std::size_t bytes = (shift + len + CHAR_SIZE - 1) / CHAR_SIZE; // 1 to 9
+		std::uint64_t word = 0;
+		memcpy(&word, page, bytes < sizeof(word) ? bytes : sizeof(word));
+		word >>= shift;
+		if (bytes > sizeof(word)) // only possible when shift > 0
+			word |= (std::uint64_t)page[sizeof(word)] << (64 - shift);
+		return len == 64 ? word : word & (((std::uint64_t)1 << len) - 1);
+	}
+
+	// Writes the low len (1 to 64) bits of value to the bits that start shift bits into page. The bits around them are left alone.
+	inline void _store_bits(unsigned char* const page, const std::size_t shift, const std::size_t len, std::uint64_t value) {
+		const std::size_t bytes = (shift + len + CHAR_SIZE - 1) / CHAR_SIZE;
+		const std::uint64_t mask = len == 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << len) - 1;
+		value &= mask;
+		std::uint64_t word = 0;
+		memcpy(&word, page, bytes < sizeof(word) ? bytes : sizeof(word));
+		word = (word & ~(mask << shift)) | (value << shift);
+		memcpy(page, &word, bytes < sizeof(word) ? bytes : sizeof(word));
+		if (bytes > sizeof(word)) {
+			const unsigned char high_mask = (unsigned char)(mask >> (64 - shift));
+			page[sizeof(word)] = (unsigned char)((page[sizeof(word)] & ~high_mask) | (unsigned char)(value >> (64 - shift)));
+		}
+	}
+
+	// The number of bits in word k of a view with n bits.
+	inline std::size_t _word_len(const std::size_t n, const std::size_t k) {
+		return n - k * 64 < 64 ? n - k * 64 : 64;
+	}
+
+	inline std::uint64_t _load_word(const ConstBitSpan& span, const std::size_t k, const std::size_t len) {
+		return _load_bits(span.page + k * sizeof(std::uint64_t), span.shift, len);
+	}
+
+	inline void _store_word(const BitSpan& span, const std::size_t k, const std::size_t len, const std::uint64_t value) {
+		_store_bits(span.page + k * sizeof(std::uint64_t), span.shift, len, value);
+	}
+
+	/* Gets the selected bit's state. i is NOT checked against the view's bounds.
+	*
+	Parameters
+	* span: the view of the bits.
+	* i: the index of the bit within the view.
+	*/
+	inline bool get(const ConstBitSpan& span, const std::size_t i) {
+		return (span.page[(span.shift + i) / CHAR_SIZE] >> ((span.shift + i) % CHAR_SIZE)) & 1;
+	}
+
+	/* Flips the selected bit from true to false or vice versa. i is NOT checked against the view's bounds.
+	*
+	Parameters
+	* span: the view of the bits.
+	* i: the index of the bit within the view.
+	*/
+	inline void flip(const BitSpan& span, const std::size_t i) {
+		span.page[(span.shift + i) / CHAR_SIZE] ^= (unsigned char)(1 << ((span.shift + i) % CHAR_SIZE));
+	}
+
+	/* Sets the selected bit to reflect the given boolean. i is NOT checked against the view's bounds.
+	*
+	Parameters
+	* span: the view of the bits.
+	* i: the index of the bit within the view.
+	* b: the state you want to set the bit to.
+	*/
+	inline void set(const BitSpan& span, const std::size_t i, const bool b) {
+		if (b)
+			span.page[(span.shift + i) / CHAR_SIZE] |= (unsigned char)(1 << ((span.shift + i) % CHAR_SIZE));
+		else
+			span.page[(span.shift + i) / CHAR_SIZE] &= (unsigned char)~(1 << ((span.shift + i) % CHAR_SIZE));
+	}
+
+	/* Fills every bit in the view with 1s or 0s.
+	*
+	Parameters
+	* span: the view of the bits.
+	* b: the state you want to set all the bits to (true = 1 and false = 0).
+	*/
+	void fill(const BitSpan& span, const bool b);
+
+	/* Copies the bits from one view to another. Only the first min(src.n, dst.n) bits are copied.
+	* The views can overlap.
+	*/
+	void copy(const ConstBitSpan& src, const BitSpan& dst);
+
+	/* dst = left & right for the first min(left.n, right.n, dst.n) bits. The views can overlap. */
+	void bitwise_and(const ConstBitSpan& left, const ConstBitSpan& right, const BitSpan& dst);
+
+	/* dst = left | right for the first min(left.n, right.n, dst.n) bits. The views can overlap. */
+	void bitwise_or(const ConstBitSpan& left, const ConstBitSpan& right, const BitSpan& dst);
+
+	/* dst = left ^ right for the first min(left.n, right.n, dst.n) bits. The views can overlap. */
+	void bitwise_xor(const ConstBitSpan& left, const ConstBitSpan& right, const BitSpan& dst);
+
+	/* dst = ~src for the first min(src.n, dst.n) bits. The views can overlap. */
+	void bitwise_not(const ConstBitSpan& src, const BitSpan& dst);
+
+	/* span = ~span */
+	void bitwise_not(const BitSpan& span);
+
+	/* Returns false if all the bits in the view are 0 else returns true. */
+	bool bool_op(const ConstBitSpan& span);
+
+	/* Returns true if all the bits in the view are 1 else returns false. */
+	bool all(const ConstBitSpan& span);
+
+	/* Returns the number of bits in the view that are 1. */
+	std::size_t count(const ConstBitSpan& span);
+
+	/* Compares two views like compare() does, looking at the first min(left.n, right.n) bits. */
+	int compare(const ConstBitSpan& left, const ConstBitSpan& right);
+
+	/* Returns true if the first min(left.n, right.n) bits of both views are the same. */
+	bool equals(const ConstBitSpan& left, const ConstBitSpan& right);
+
+	/* Works like the other shift_left(), but on a view. */
+	void shift_left(const BitSpan& span, const std::size_t by);
+
+	/* Works like the other shift_right(), but on a view. */
+	void shift_right(const BitSpan& span, const std::size_t by);
+
+	/* Returns a string representation of the bits in the view. Bit 0 is the left most char. */
+	std::string str(const ConstBitSpan& span);
+
+	/* Returns a wide string representation of the bits in the view. Bit 0 is the left most char. */
+	std::wstring wstr(const ConstBitSpan& span);
+
+	/* Interprets a string made from str() and puts the data into the view.
+	* Throws std::invalid_argument if there's a char other than '0' or '1'.
+	*/
+	void from_str(const BitSpan& span, const std::string& s);
+
+	/* Interprets a wstring made from wstr() and puts the data into the view.
+	* Throws std::invalid_argument if there's a char other than '0' or '1'.
+	*/
+	void from_wstr(const BitSpan& span, const std::wstring& s);
+
+	// ============ SET BIT ITERATION ============
+
+	// Calls f(args...) and tells us whether to keep going. f can return void (always keep going) or something that converts to bool (false = stop).
+	template < class Function, class... Args >
+	inline bool _call(std::true_type /* f returns void */, Function& f, Args&&... args) {
+		f(std::forward<Args>(args)...);
+		return true;
+	}
+
+	template < class Function, class... Args >
+	inline bool _call(std::false_type /* f returns something */, Function& f, Args&&... args) {
+		return f(std::forward<Args>(args)...) ? true : false;
+	}
+
+	template < class Function, class... Args >
+	inline bool _visit(Function& f, Args&&... args) {
+		return _call(typename std::is_void<decltype(f(std::forward<Args>(args)...))>::type(), f, std::forward<Args>(args)...);
+	}
+
+	// Visits the index of every 1 in the view (or every 0 if invert is true), one word at a time.
+	// Words with nothing in them are skipped, tzcnt/lzcnt finds the next bit and w & (w - 1) (blsr) clears it.
+	template < class UnaryFunction >
+	bool _for_each_one(const ConstBitSpan& span, const bool invert, const bool reverse, UnaryFunction& f) {
+		const std::size_t words = (span.n + 63) / 64;
+		for (std::size_t j = 0; j < words; j++) {
+			const std::size_t k = reverse ? words - 1 - j : j;
+			const std::size_t len = _word_len(span.n, k);
+			std::uint64_t w = _load_word(span, k, len);
+			if (invert)
+				w = len == 64 ? ~w : ~w & (((std::uint64_t)1 << len) - 1);
+			while (w) {
+				if (reverse) {
+					const std::size_t bit = 63 - countl_zero(w);
+					if (!_visit(f, k * 64 + bit))
+						return false;
+					w ^= (std::uint64_t)1 << bit;
+				}
+				else {
+					if (!_visit(f, k * 64 + countr_zero(w)))
+						return false;
+					w &= w - 1;
+				}
+			}
+		}
+		return true;
+	}
+
+	/* Calls a function with the index of every bit in the view that is 1, from the lowest index to the highest.
+	* This is a lot faster than for_each_bit() when most of the bits are 0, since it only visits the bits that are set.
+	*
+	Parameters
+	* span: the view of the bits.
+	* f: the function to call. Takes in the local index (std::size_t) of the bit. If it returns something then returning false stops the iteration.
+	*
+	Returns false if f stopped the iteration early else returns true.
+	*/
+	template < class UnaryFunction >
+	bool for_each_set_bit(const ConstBitSpan& span, UnaryFunction f) {
+		return _for_each_one(span, false, false, f);
+	}
+
+	/* Calls a function with the index of every bit in the bounds that is 1, from the lowest index to the highest.
+	*
+	Parameters
+	* block: pointer to the memory block.
+	* start_bit: the starting bit of your bounds (inclusive).
+	* end_bit: the ending bit of your bounds (exclusive).
+	* f: the function to call. Takes in the local index (std::size_t) of the bit. If it returns something then returning false stops the iteration.
+	*
+	Returns false if f stopped the iteration early else returns true.
+	*/
+	template < class UnaryFunction >
+	bool for_each_set_bit(const void* const block, const std::size_t start_bit, const std::size_t end_bit, UnaryFunction f) {
+		return for_each_set_bit(ConstBitSpan(block, start_bit, end_bit), f);
+	}
+
+	/* Calls a function with the index of every bit in the memory block that is 1, from the lowest index to the highest.
+	*
+	Parameters
+	* block: pointer to the memory block.
+	* n: the size of the memory block in bits.
+	* f: the function to call. Takes in the index (std::size_t) of the bit. If it returns something then returning false stops the iteration.
+	*
+	Returns false if f stopped the iteration early else returns true.
+	*/
+	template < class UnaryFunction >
+	bool for_each_set_bit(const void* const block, const std::size_t n, UnaryFunction f) {
+		return for_each_set_bit(ConstBitSpan(block, n), f);
+	}
+
+	/* Works like for_each_set_bit(), but visits the bits that are 0. */
+	template < class UnaryFunction >
+	bool for_each_clear_bit(const ConstBitSpan& span, UnaryFunction f) {
+		return _for_each_one(span, true, false, f);
+	}
+
+	/* Works like for_each_set_bit(), but visits the bits that are 0. */
+	template < class UnaryFunction >
+	bool for_each_clear_bit(const void* const block, const std::size_t start_bit, const std::size_t end_bit, UnaryFunction f) {
+		return for_each_clear_bit(ConstBitSpan(block, start_bit, end_bit), f);
+	}
+
+	/* Works like for_each_set_bit(), but visits the bits that are 0. */
+	template < class UnaryFunction >
+	bool for_each_clear_bit(const void* const block, const std::size_t n, UnaryFunction f) {
+		return for_each_clear_bit(ConstBitSpan(block, n), f);
+	}
+
+	/* Works like for_each_set_bit(), but goes from the highest index to the lowest. */
+	template < class UnaryFunction >
+	bool rfor_each_set_bit(const ConstBitSpan& span, UnaryFunction f) {
+		return _for_each_one(span, false, true, f);
+	}
+
+	/* Works like for_each_set_bit(), but goes from the highest index to the lowest. */
+	template < class UnaryFunction >
+	bool rfor_each_set_bit(const void* const block, const std::size_t start_bit, const std::size_t end_bit, UnaryFunction f) {
+		return rfor_each_set_bit(ConstBitSpan(block, start_bit, end_bit), f);
+	}
+
+	/* Works like for_each_set_bit(), but goes from the highest index to the lowest. */
+	template < class UnaryFunction >
+	bool rfor_each_set_bit(const void* const block, const std::size_t n, UnaryFunction f) {
+		return rfor_each_set_bit(ConstBitSpan(block, n), f);
+	}
+
+	/* Works like for_each_clear_bit(), but goes from the highest index to the lowest. */
+	template < class UnaryFunction >
+	bool rfor_each_clear_bit(const ConstBitSpan& span, UnaryFunction f) {
+		return _for_each_one(span, true, true, f);
+	}
+
+	/* Works like for_each_clear_bit(), but goes from the highest index to the lowest. */
+	template < class UnaryFunction >
+	bool rfor_each_clear_bit(const void* const block, const std::size_t start_bit, const std::size_t end_bit, UnaryFunction f) {
+		return rfor_each_clear_bit(ConstBitSpan(block, start_bit, end_bit), f);
+	}
+
+	/* Works like for_each_clear_bit(), but goes from the highest index to the lowest. */
+	template < class UnaryFunction >
+	bool rfor_each_clear_bit(const void* const block, const std::size_t n, UnaryFunction f) {
+		return rfor_each_clear_bit(ConstBitSpan(block, n), f);
+	}
+
+	// ============ WORD VISITORS ============
+
+	/* Calls a function for every 64 bit word of the view, from the lowest index to the highest, so you can write your own reductions a word at a time.
+	* Word k holds the bits [64k, 64k + 64) of the view, shifted down so that bit 64k is bit 0, no matter where the view starts in its byte.
+	* The bits past the end of the view are 0 in the last word.
+	*
+	Parameters
+	* span: the view of the bits.
+	* f: the function to call. Takes in the word (std::uint64_t), a mask of the bits in the word that are in the view (std::uint64_t) and the local
+	*     index of the word's bit 0 (std::size_t). If it returns something then returning false stops the iteration.
+	*
+	Returns false if f stopped the iteration early else returns true.
+	*/
+	template < class TernaryFunction >
+	bool for_each_word(const ConstBitSpan& span, TernaryFunction f) {
+		const std::size_t words = (span.n + 63) / 64;
+		for (std::size_t k = 0; k < words; k++) {
+			const std::size_t len = _word_len(span.n, k);
+			const std::uint64_t mask = len == 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << len) - 1;
+			if (!_visit(f, _load_word(span, k, len), mask, k * 64))
+				return false;
+		}
+		return true;
+	}
+
+	/* Works like the other for_each_word(), but on the bits [start_bit, end_bit) of a memory block. */
+	template < class TernaryFunction >
+	bool for_each_word(const void* const block, const std::size_t start_bit, const std::size_t end_bit, TernaryFunction f) {
+		return for_each_word(ConstBitSpan(block, start_bit, end_bit), f);
+	}
+
+	/* Works like the other for_each_word(), but on the first n bits of a memory block. */
+	template < class TernaryFunction >
+	bool for_each_word(const void* const block, const std::size_t n, TernaryFunction f) {
+		return for_each_word(ConstBitSpan(block, n), f);
+	}
+
+	/* Works like for_each_word(), but f gets a reference to the word (std::uint64_t&) and whatever it leaves in there is written back to the view.
+	* Only the bits in the mask are written, the bits outside of the view are left alone. The word is still written back if f stops the iteration.
+	*/
+	template < class TernaryFunction >
+	bool for_each_word_mutable(const BitSpan& span, TernaryFunction f) {
+		const std::size_t words = (span.n + 63) / 64;
+		for (std::size_t k = 0; k < words; k++) {
+			const std::size_t len = _word_len(span.n, k);
+			const std::uint64_t mask = len == 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << len) - 1;
+			std::uint64_t word = _load_word(span, k, len);
+			const bool keep_going = _visit(f, word, mask, k * 64);
+			_store_word(span, k, len, word);
+			if (!keep_going)
+				return false;
+		}
+		return true;
+	}
+
+	/* Works like the other for_each_word_mutable(), but on the bits [start_bit, end_bit) of a memory block. */
+	template < class TernaryFunction >
+	bool for_each_word_mutable(void* const block, const std::size_t start_bit, const std::size_t end_bit, TernaryFunction f) {
+		return for_each_word_mutable(BitSpan(block, start_bit, end_bit), f);
+	}
+
+	/* Works like the other for_each_word_mutable(), but on the first n bits of a memory block. */
+	template < class TernaryFunction >
+	bool for_each_word_mutable(void* const block, const std::size_t n, TernaryFunction f) {
+		return for_each_word_mutable(BitSpan(block, n), f);
+	}
+
+	// ============ RUNS ============
+
+	/* Calls a function for every run of 1s in the view (ie every stretch of 1s with a 0 or the edge of the view on both sides),
+	* from the lowest index to the highest. Runs can cross word boundaries, they're found by looking at where neighbouring bits differ
+	* (w ^ (w << 1)), a word at a time.
+	*
+	Parameters
+	* span: the view of the bits.
+	* f: the function to call. Takes in the local index of the first bit of the run (inclusive) and the local index of the end of the run (exclusive).
+	*     If it returns something then returning false stops the iteration.
+	*
+	Returns false if f stopped the iteration early else returns true.
+	*/
+	template < class BinaryFunction >
+	bool for_each_run(const ConstBitSpan& span, BinaryFunction f) {
+		const std::size_t words = (span.n + 63) / 64;
+		std::uint64_t carry = 0; // the last bit of the previous word
+		std::size_t begin = 0;
+		for (std::size_t k = 0; k < words; k++) {
+			const std::size_t len = _word_len(span.n, k);
+			const std::uint64_t w = _load_word(span, k, len);
+			// bit j of t is set when bit j is different from the bit before it. Every one of these starts or ends a run.
+			std::uint64_t t = w ^ ((w << 1) | carry);
+			carry = w >> 63;
+			while (t) {
+				const std::size_t i = k * 64 + countr_zero(t);
+				if ((w >> (i % 64)) & 1) { // going from 0 to 1
+					begin = i;
+				}
+				else if (!_visit(f, begin, i)) {
+					return false;
+				}
+				t &= t - 1;
+			}
+		}
+		// If the last word wasn't full, then a run that reaches the end of the view has already been ended by the 0 above it in w << 1.
+		if (carry)
+			return _visit(f, begin, span.n);
+		return true;
+	}
+
+	/* Calls a function for every run of 1s in the bounds, from the lowest index to the highest.
+	*
+	Parameters
+	* block: pointer to the memory block.
+	* start_bit: the starting bit of your bounds (inclusive).
+	* end_bit: the ending bit of your bounds (exclusive).
+	* f: the function to call. Takes in the local index of the first bit of the run (inclusive) and the local index of the end of the run (exclusive).
+	*     If it returns something then returning false stops the iteration.
+	*
+	Returns false if f stopped the iteration early else returns true.
+	*/
+	template < class BinaryFunction >
+	bool for_each_run(const void* const block, const std::size_t start_bit, const std::size_t end_bit, BinaryFunction f) {
+		return for_each_run(ConstBitSpan(block, start_bit, end_bit), f);
+	}
+
+	/* Calls a function for every run of 1s in the memory block, from the lowest index to the highest.
+	*
+	Parameters
+	* block: pointer to the memory block.
+	* n: the size of the memory block in bits.
+	* f: the function to call. Takes in the index of the first bit of the run (inclusive) and the index of the end of the run (exclusive).
+	*     If it returns something then returning false stops the iteration.
+	*
+	Returns false if f stopped the iteration early else returns true.
+	*/
+	template < class BinaryFunction >
+	bool for_each_run(const void* const block, const std::size_t n, BinaryFunction f) {
+		return for_each_run(ConstBitSpan(block, n), f);
+	}
+
+	/* Makes the bits in the bounds 1 where they're inside one of the intervals and 0 everywhere else. The intervals don't have to be sorted and can overlap.
+	*
+	Parameters
+	* block: pointer to the memory block.
+	* start_bit: the starting bit of your bounds (inclusive).
+	* end_bit: the ending bit of your bounds (exclusive).
+	* intervals: pointer to the intervals. Each one is a pair of local indices [first, second). Empty intervals are ignored.
+	* count: the number of intervals.
+	*
+	Throws std::invalid_argument if an interval has first > second and std::out_of_range if an interval goes past the bounds.
+	Nothing is changed if it throws.
+	*/
+	void from_intervals(void* const block,
+		const std::size_t start_bit,
+		const std::size_t end_bit,
+		const std::pair<std::size_t, std::size_t>* const intervals,
+		const std::size_t count);
+
+	/* Makes the bits in the memory block 1 where they're inside one of the intervals and 0 everywhere else. The intervals don't have to be sorted and can overlap.
+	*
+	Parameters
+	* block: pointer to the memory block.
+	* n: the size of the memory block in bits.
+	* intervals: pointer to the intervals. Each one is a pair of indices [first, second). Empty intervals are ignored.
+	* count: the number of intervals.
+	*
+	Throws std::invalid_argument if an interval has first > second and std::out_of_range if an interval goes past n.
+	Nothing is changed if it throws.
+	*/
+	void from_intervals(void* const block,
+		const std::size_t n,
+		const std::pair<std::size_t, std::size_t>* const intervals,
+		const std::size_t count);
+
+	/* Returns every run of 1s in the bounds as a sorted list of [first, second) local indices. Passing it to from_intervals() gives you the same bits back. */
+	std::vector<std::pair<std::size_t, std::size_t>> to_intervals(const void* const block,
+		const std::size_t start_bit,
+		const std::size_t end_bit);
+
+	/* Returns every run of 1s in the memory block as a sorted list of [first, second) indices. Passing it to from_intervals() gives you the same bits back. */
+	std::vector<std::pair<std::size_t, std::size_t>> to_intervals(const void* const block,
+		const std::size_t n);
+
+	// ============ RUN SEARCH ============
+	// For when a memory block is used as a map of free space, where you need k bits in a row.
+	// Runs of up to 64 bits are found by folding each word onto itself with shifts and ANDs (bit j survives if bits j to j + k - 1 are all set),
+	// which doesn't care how fragmented the map is. Longer runs are found by jumping from one run to the next with tzcnt.
+
+	/* Finds the first run of at least k bits that are all equal to b, starting at or after from.
+	*
+	Parameters
+	* span: the view of the bits.
+	* k: the number of bits the run needs. Throws std::invalid_argument if this is 0.
+	* b: the state the bits in the run need to be.
+	* from: the local index to start looking at.
+	*
+	Returns the local index of the first bit of the run, or span.n if there isn't one.
+	*/
+	std::size_t find_first_fit(const ConstBitSpan& span, const std::size_t k, const bool b, const std::size_t from);
+
+	/* Works like the other find_first_fit(), but looks at the bits [start_bit, end_bit) of a memory block from the beginning. */
+	std::size_t find_first_fit(const void* const block,
+		const std::size_t start_bit,
+		const std::size_t end_bit,
+		const std::size_t k,
+		const bool b);
+
+	/* Works like the other find_first_fit(), but looks at the first n bits of a memory block from the beginning. */
+	std::size_t find_first_fit(const void* const block,
+		const std::size_t n,
+		const std::size_t k,
+		const bool b);
+
+	/* Finds the smallest run of at least k bits that are all equal to b (the first one if there's a tie). This has to look at every run unless there's one that is exactly k long.
+	*
+	Parameters
+	* span: the view of the bits.
+	* k: the number of bits the run needs. Throws std::invalid_argument if this is 0.
+	* b: the state the bits in the run need to be.
+	*
+	Returns the local index of the first bit of the run, or span.n if there isn't one.
+	*/
+	std::size_t find_best_fit(const ConstBitSpan& span, const std::size_t k, const bool b);
+
+	/* Finds the first run of at least k bits that are all equal to b, starting at or after hint and wrapping around to the beginning if there isn't one.
+	* Pass in the end of the last run you found as the hint, and the searches will spread out over the map instead of piling up at the start.
+	*
+	Parameters
+	* span: the view of the bits.
+	* k: the number of bits the run needs. Throws std::invalid_argument if this is 0.
+	* b: the state the bits in the run need to be.
+	* hint: the local index to start looking at.
+	*
+	Returns the local index of the first bit of the run, or span.n if there isn't one.
+	*/
+	std::size_t find_next_fit(const ConstBitSpan& span, const std::size_t k, const bool b, const std::size_t hint);
+
+	/* Finds a run of k bits that are 0 (next fit, starting at hint) and sets them to 1, atomically. It's safe for several threads to claim runs
+	* from the same memory block at once (as long as nothing else writes to it without going through claim_run() or release_run()). Each thread
+	* gets a different run. If another thread takes some of the bits first, then it tries again.
+	* These read and write the block a byte at a time, so don't use them on the same block as the atomic_* functions (ATOMIC BITS), which use whole
+	* words. Mixing atomics of different sizes on the same memory isn't defined.
+	*
+	Parameters
+	* span: the view of the bits.
+	* k: the number of bits to claim. Throws std::invalid_argument if this is 0.
+	* hint: the local index to start looking at.
+	*
+	Returns the local index of the first bit of the run, or span.n if there isn't one.
+	*/
+	std::size_t claim_run(const BitSpan& span, const std::size_t k, const std::size_t hint);
+
+	/* Sets the k bits starting at the local index start back to 0, atomically. Use this to give back what claim_run() gave you. */
+	void release_run(const BitSpan& span, const std::size_t start, const std::size_t k);
+
+	// ============ ATOMIC BITS ============
+	// For memory blocks that several threads change at once without a lock (ie a shared map of visited URLs). Every change is an atomic read-modify-write
+	// on the 64 bit word that has the bit (std::atomic_ref with C++20, the compiler's builtins before that), so nobody loses anybody else's bits.
+	// The bytes after the last whole word of the block get byte atomics instead, so nothing outside of the block is touched.
+	// The memory block has to be 8 byte aligned (create() and malloc() always are). They throw std::invalid_argument if it isn't.
+	//
+	// Each one takes the MemoryOrder to use. ACQ_REL (the default) means that whatever a thread wrote before setting a bit can be seen by a thread that
+	// sees the bit set. RELAXED is enough when the bits themselves are all that's being shared, and it's cheaper on ARM (x86 is the same either way).
+	// Using the plain functions (set(), fill(), etc.) on the same bits at the same time as these is still a data race, and so is using them on the same
+	// block as claim_run() and release_run(), which use byte atomics.
+
+	enum class _AtomicOp { AND, OR, XOR };
+
+	// The number of whole words in the memory block, which are the ones that get word atomics. Throws std::invalid_argument if the block isn't aligned.
+	inline std::size_t _atomic_words(const void* const block, const std::size_t n) {
+		if ((std::uintptr_t)block % sizeof(std::uint64_t) != 0)
+			throw std::invalid_argument("The memory block has to be 8 byte aligned.");
+		return size(n) / sizeof(std::uint64_t);
+	}
+
+	// Does op on bit i (AND clears it, OR sets it and XOR flips it) and returns what it was before.
+	inline bool _atomic_bit(void* const block, const std::size_t n, const std::size_t i, const _AtomicOp op, const MemoryOrder order) {
+		_validateBounds(n, i);
+		if (i / 64 < _atomic_words(block, n)) {
+			std::uint64_t* const word = (std::uint64_t*)block + i / 64;
+			const std::uint64_t bit = (std::uint64_t)1 << (i % 64);
+			switch (op) {
+			case _AtomicOp::AND: return (_atomic_fetch_and(word, ~bit, order) & bit) != 0;
+			case _AtomicOp::OR: return (_atomic_fetch_or(word, bit, order) & bit) != 0;
+			default: return (_atomic_fetch_xor(word, bit, order) & bit) != 0;
+			}
+		}
+		unsigned char* const byte = (unsigned char*)block + i / CHAR_SIZE;
+		const unsigned char bit = _bitMask(i);
+		switch (op) {
+		case _AtomicOp::AND: return (_atomic_fetch_and(byte, (unsigned char)~bit, order) & bit) != 0;
+		case _AtomicOp::OR: return (_atomic_fetch_or(byte, bit, order) & bit) != 0;
+		default: return (_atomic_fetch_xor(byte, bit, order) & bit) != 0;
+		}
+	}
+
+	/* Gets the selected bit's state with an atomic load.
+	*
+	Parameters
+	* block: the pointer to the memory block.
+	* n: the number of bits in the memory block.
+	* i: the index of the bit you want to get.
+	* order: the memory order of the load.
+	*
+	Returns true if the bit is set, and false if it isn't.
+	*/
+	inline bool atomic_get(const void* const block,
+		const std::size_t n,
+		const std::size_t i,
+		const MemoryOrder order = MemoryOrder::ACQUIRE
+	) {
+		_validateBounds(n, i);
+		if (i / 64 < _atomic_words(block, n))
+			return (_atomic_load((const std::uint64_t*)block + i / 64, order) >> (i % 64)) & 1;
+		return (_atomic_load((const unsigned char*)block + i / CHAR_SIZE, order) & _bitMask(i)) != 0;
+	}
+
+	/* Sets the selected bit to 1 and returns what it was before, so false means this thread is the one that set it. If the bit is already 1, it
+	* finds that out with a load and doesn't write, so bits that get tested over and over (ie URLs that were already visited) don't keep bouncing
+	* the cache line between cores.
+	*
+	Parameters
+	* block: the pointer to the memory block.
+	* n: the number of bits in the memory block.
+	* i: the index of the bit.
+	* order: the memory order of the read-modify-write.
+	*/
+	inline bool atomic_test_and_set(void* const block,
+		const std::size_t n,
+		const std::size_t i,
+		const MemoryOrder order = MemoryOrder::ACQ_REL
+	) {
+		return atomic_get(block, n, i, _load_order(order)) || _atomic_bit(block, n, i, _AtomicOp::OR, order);
+	}
+
+	/* Sets the selected bit to 0 and returns what it was before, so true means this thread is the one that cleared it. Like atomic_test_and_set(),
+	* it doesn't write if the bit is already 0.
+	*/
+	inline bool atomic_test_and_clear(void* const block,
+		const std::size_t n,
+		const std::size_t i,
+		const MemoryOrder order = MemoryOrder::ACQ_REL
+	) {
+		return atomic_get(block, n, i, _load_order(order)) && _atomic_bit(block, n, i, _AtomicOp::AND, order);
+	}
+
+	/* Flips the selected bit and returns what it was before. */
+	inline bool atomic_flip(void* const block,
+		const std::size_t n,
+		const std::size_t i,
+		const MemoryOrder order = MemoryOrder::ACQ_REL
+	) {
+		return _atomic_bit(block, n, i, _AtomicOp::XOR, order);
+	}
+
+	/* Sets the selected bit to b. */
+	inline void atomic_set(void* const block,
+		const std::size_t n,
+		const std::size_t i,
+		const bool b,
+		const MemoryOrder order = MemoryOrder::ACQ_REL
+	) {
+		_atomic_bit(block, n, i, b ? _AtomicOp::OR : _AtomicOp::AND, order);
+	}
+
+	/* Sets the bits [start_bit, end_bit) to b. The words in the middle are stored whole, and the ones on the edges (which have bits that aren't in the
+	* range) are changed with a CAS on just the bits in the range, so threads setting ranges that share a word don't undo each other.
+	* The range as a whole isn't atomic: another thread can see some of it set before the rest is.
+	*
+	Parameters
+	* block: the pointer to the memory block.
+	* n: the number of bits in the memory block.
+	* start_bit: the first bit of the range (inclusive).
+	* end_bit: the end of the range (exclusive). Throws std::invalid_argument if it's < start_bit and std::out_of_range if it's > n.
+	* b: the state to set the bits to.
+	* order: the memory order of each store and CAS.
+	*/
+	void atomic_set_range(void* const block,
+		const std::size_t n,
+		const std::size_t start_bit,
+		const std::size_t end_bit,
+		const bool b,
+		const MemoryOrder order = MemoryOrder::ACQ_REL);
+
+	/* dst &= src for the first n bits, one atomic fetch_and per word. src is read normally, so it shouldn't be changing while this runs. */
+	void atomic_bitwise_and(const void* const src,
+		void* const dst,
+		const std::size_t n,
+		const MemoryOrder order = MemoryOrder::ACQ_REL);
+
+	/* dst |= src for the first n bits, one atomic fetch_or per word (this is how to merge a thread's private bitmap into a shared one).
+	* src is read normally, so it shouldn't be changing while this runs.
+	*/
+	void atomic_bitwise_or(const void* const src,
+		void* const dst,
+		const std::size_t n,
+		const MemoryOrder order = MemoryOrder::ACQ_REL);
+
+	/* dst ^= src for the first n bits, one atomic fetch_xor per word. src is read normally, so it shouldn't be changing while this runs. */
+	void atomic_bitwise_xor(const void* const src,
+		void* const dst,
+		const std::size_t n,
+		const MemoryOrder order = MemoryOrder::ACQ_REL);
+
+	/* Counts the 1s in the first n bits with atomic loads, so it can run while other threads are changing them.
+	* Each word is read at a different time, so the count isn't a snapshot of the whole block.
+	*/
+	std::size_t atomic_count(const void* const block,
+		const std::size_t n,
+		const MemoryOrder order = MemoryOrder::ACQUIRE);
+
+	// ============ PATTERN SEARCH ============
+	// Like memmem(), but a match can start at any bit. The pattern is bits [0, pattern.n) of its view, in the same order as everything else.
+	// Patterns of up to 57 bits are compared against every bit offset of each byte at once, with 8 shifted copies of the pattern (4 or 8 to a vector
+	// when AVX2/AVX-512 is enabled). Longer patterns use their first 57 bits as a filter, and on big haystacks they skip ahead Horspool style,
+	// going by the last 12 bits of the window, so the cost per bit goes down as the pattern gets longer.
+	// Matches can overlap (ie 0b11 is found at 0, 1 and 2 in 0b1111).
+
+	/* Finds the first place the pattern shows up in the haystack, starting at or after from.
+	*
+	Parameters
+	* haystack: the view of the bits to search.
+	* pattern: the view of the bits to look for.
+	* from: the local index to start looking at.
+	*
+	Returns the local index of the first bit of the match, or haystack.n if there isn't one.
+	*/
+	std::size_t find_pattern(const ConstBitSpan& haystack, const ConstBitSpan& pattern, const std::size_t from);
+
+	/* Works like the other find_pattern(), but looks at the bits [start_bit, end_bit) of a memory block for the first pattern_bits bits of another one.
+	* Throws std::invalid_argument if pattern_bits == 0.
+	*
+	Returns the index of the first bit of the match relative to start_bit, or end_bit - start_bit if there isn't one.
+	*/
+	std::size_t find_pattern(const void* const haystack,
+		const std::size_t start_bit,
+		const std::size_t end_bit,
+		const void* const pattern,
+		const std::size_t pattern_bits);
+
+	/* Finds every place the pattern shows up in the haystack.
+	*
+	Parameters
+	* haystack: the view of the bits to search.
+	* pattern: the view of the bits to look for.
+	*
+	Returns the local indices of the first bits of the matches, from lowest to highest.
+	*/
+	std::vector<std::size_t> find_all_pattern(const ConstBitSpan& haystack, const ConstBitSpan& pattern);
+
+	/* Works like the other find_all_pattern(), but looks at the bits [start_bit, end_bit) of a memory block for the first pattern_bits bits of another one.
+	* The indices are relative to start_bit. Throws std::invalid_argument if pattern_bits == 0.
+	*/
+	std::vector<std::size_t> find_all_pattern(const void* const haystack,
+		const std::size_t start_bit,
+		const std::size_t end_bit,
+		const void* const pattern,
+		const std::size_t pattern_bits);
+
+	/* Returns the number of places the pattern shows up in the haystack, without keeping track of where. */
+	std::size_t count_pattern(const ConstBitSpan& haystack, const ConstBitSpan& pattern);
+
+	/* Works like the other count_pattern(), but looks at the bits [start_bit, end_bit) of a memory block for the first pattern_bits bits of another one.
+	* Throws std::invalid_argument if pattern_bits == 0.
+	*/
+	std::size_t count_pattern(const void* const haystack,
+		const std::size_t start_bit,
+		const std::size_t end_bit,
+		const void* const pattern,
+		const std::size_t pattern_bits);
+
+	// ============ ALGORITHMS ============
+	// Overloads of the <algorithm> functions for bit iterators that use the word kernels. They're in this namespace (std is off limits),
+	// so call them unqualified (ie using std::find; find(first, last, true);) and ADL will pick them over the generic ones.
+
+	/* Returns the first iterator in [first, last) that points at a bit equal to value, or last if there isn't one. */
+	template < bool _const >
+	_bit_iterator<_const> find(const _bit_iterator<_const> first, const _bit_iterator<_const> last, const bool& value) {
+		if (!(first < last))
+			return last;
+		const ConstBitSpan span(first.page, first.offset, first.offset + (last - first));
+		std::size_t found = span.n;
+		const auto f = [&found](const std::size_t i) {
+			found = i;
+			return false;
+		};
+		if (value)
+			for_each_set_bit(span, f);
+		else
+			for_each_clear_bit(span, f);
+		return first + (std::ptrdiff_t)found;
+	}
+
+	/* Returns the number of bits in [first, last) that are equal to value. */
+	template < bool _const >
+	std::ptrdiff_t count(const _bit_iterator<_const> first, const _bit_iterator<_const> last, const bool& value) {
+		if (!(first < last))
+			return 0;
+		const ConstBitSpan span(first.page, first.offset, first.offset + (last - first));
+		const std::size_t ones = count(span);
+		return (std::ptrdiff_t)(value ? ones : span.n - ones);
+	}
+
+	/* Sets every bit in [first, last) to value. */
+	inline void fill(const bit_iterator first, const bit_iterator last, const bool& value) {
+		if (first < last)
+			fill(BitSpan(first.page, first.offset, first.offset + (last - first)), value);
+	}
+
+	/* Copies the bits in [first, last) to the bits starting at d_first. The ranges can overlap.
+	*
+	Returns an iterator to the bit after the last one copied.
+	*/
+	template < bool _const >
+	bit_iterator copy(const _bit_iterator<_const> first, const _bit_iterator<_const> last, const bit_iterator d_first) {
+		if (!(first < last))
+			return d_first;
+		const std::ptrdiff_t n = last - first;
+		copy(
+			ConstBitSpan(first.page, first.offset, first.offset + n),
+			BitSpan(d_first.page, d_first.offset, d_first.offset + n)
+		);
+		return d_first + n;
+	}
+
+	/* Returns true if the bits in [first1, last1) are the same as the ones starting at first2. */
+	template < bool _const1, bool _const2 >
+	bool equal(const _bit_iterator<_const1> first1, const _bit_iterator<_const1> last1, const _bit_iterator<_const2> first2) {
+		if (!(first1 < last1))
+			return true;
+		const std::ptrdiff_t n = last1 - first1;
+		return equals(
+			ConstBitSpan(first1.page, first1.offset, first1.offset + n),
+			ConstBitSpan(first2.page, first2.offset, first2.offset + n)
+		);
+	}
 };
 #else // C++98 or error
 #error If you're using VC++, use the /Zc:__cplusplus command line argument. Or you could just remove the preprocessor stuff. That works too. All relevant preprocessor stuff should end with (where XX is the version number) // C++XX
 #endif // C++11
 
+#if defined(BITUTILS_HEADER_ONLY)
+#include "BitUtils.cpp"
+#endif // BITUTILS_HEADER_ONLY
+
 #endif // __BITUTILS_H__
\ No newline at end of file
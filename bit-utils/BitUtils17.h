@@ -4,8 +4,278 @@
 
 #if __cplusplus >= 201700 // C++17
 
+#include <utility>
+#include <array>
+#include <string_view>
+
 namespace BitUtils {
 
+	// ========== WIDE KERNELS ==========
+
+	/* Lanes are the registers that the wide kernels work with. Each one knows how to load, store and combine
+	* a register's worth of 64 bit words. The scalar lane is the fallback for when there's no vector ISA available.
+	*/
+	struct Lane64 {
+		typedef std::uint64_t type;
+		constexpr static const std::size_t words = 1;
+
+		static type load(const void* const src) { type v; memcpy(&v, src, sizeof(v)); return v; }
+		static void store(void* const dst, const type v) { memcpy(dst, &v, sizeof(v)); }
+		static type bitwise_and(const type l, const type r) { return l & r; }
+		static type bitwise_or(const type l, const type r) { return l | r; }
+		static type bitwise_xor(const type l, const type r) { return l ^ r; }
+		static type bitwise_not(const type v) { return ~v; }
+		static type zero() { return 0; }
+		static bool is_zero(const type v) { return v == 0; }
+		// One bit per word that isn't 0.
+		static unsigned nonzero_words(const type v) { return v != 0; }
+		static std::size_t count(const type v) { return popcount(v); }
+	};
+
+#if defined(_BITUTILS_HAS_SSE2)
+	struct Lane128 {
+		typedef __m128i type;
+		constexpr static const std::size_t words = 2;
+
+		static type load(const void* const src) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)); }
+		static void store(void* const dst, const type v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v); }
+		static type bitwise_and(const type l, const type r) { return _mm_and_si128(l, r); }
+		static type bitwise_or(const type l, const type r) { return _mm_or_si128(l, r); }
+		static type bitwise_xor(const type l, const type r) { return _mm_xor_si128(l, r); }
+		static type bitwise_not(const type v) { return _mm_xor_si128(v, _mm_set1_epi32(-1)); }
+		static type zero() { return _mm_setzero_si128(); }
+		static bool is_zero(const type v) {
+#if defined(__SSE4_1__)
+			return _mm_testz_si128(v, v);
+#else
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+#endif
+		}
+		static unsigned nonzero_words(const type v) {
+			const int zero_bytes = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+			return ((zero_bytes & 0x00FF) != 0x00FF) | (((zero_bytes & 0xFF00) != 0xFF00) << 1);
+		}
+		static std::size_t count(const type v) {
+			std::uint64_t w[2];
+			store(w, v);
+			return popcount(w[0]) + popcount(w[1]);
+		}
+	};
+#endif // SSE2
+
+#if defined(_BITUTILS_HAS_AVX2)
+	struct Lane256 {
+		typedef __m256i type;
+		constexpr static const std::size_t words = 4;
+
+		static type load(const void* const src) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)); }
+		static void store(void* const dst, const type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), v); }
+		static type bitwise_and(const type l, const type r) { return _mm256_and_si256(l, r); }
+		static type bitwise_or(const type l, const type r) { return _mm256_or_si256(l, r); }
+		static type bitwise_xor(const type l, const type r) { return _mm256_xor_si256(l, r); }
+		static type bitwise_not(const type v) { return _mm256_xor_si256(v, _mm256_set1_epi32(-1)); }
+		static type zero() { return _mm256_setzero_si256(); }
+		static bool is_zero(const type v) { return _mm256_testz_si256(v, v); }
+		static unsigned nonzero_words(const type v) {
+			return ~(unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, _mm256_setzero_si256()))) & 0xF;
+		}
+		static std::size_t count(const type v) {
+			std::uint64_t w[4];
+			store(w, v);
+			return popcount(w[0]) + popcount(w[1]) + popcount(w[2]) + popcount(w[3]);
+		}
+	};
+#endif // AVX2
+
+#if defined(_BITUTILS_HAS_AVX512)
+	struct Lane512 {
+		typedef __m512i type;
+		constexpr static const std::size_t words = 8;
+
+		static type load(const void* const src) { return _mm512_loadu_si512(src); }
+		static void store(void* const dst, const type v) { _mm512_storeu_si512(dst, v); }
+		static type bitwise_and(const type l, const type r) { return _mm512_and_si512(l, r); }
+		static type bitwise_or(const type l, const type r) { return _mm512_or_si512(l, r); }
+		static type bitwise_xor(const type l, const type r) { return _mm512_xor_si512(l, r); }
+		static type bitwise_not(const type v) { return _mm512_ternarylogic_epi64(v, v, v, 0x55); }
+		static type zero() { return _mm512_setzero_si512(); }
+		static bool is_zero(const type v) { return _mm512_test_epi64_mask(v, v) == 0; }
+		static unsigned nonzero_words(const type v) { return _mm512_test_epi64_mask(v, v); }
+		static std::size_t count(const type v) {
+#if defined(__AVX512VPOPCNTDQ__)
+			return (std::size_t)_mm512_reduce_add_epi64(_mm512_popcnt_epi64(v));
+#else
+			std::uint64_t w[8];
+			store(w, v);
+			return popcount(w[0]) + popcount(w[1]) + popcount(w[2]) + popcount(w[3]) +
+				popcount(w[4]) + popcount(w[5]) + popcount(w[6]) + popcount(w[7]);
+#endif
+		}
+	};
+#endif // AVX512
+
+	/* Kernels for unbounded masks that are exactly _words 64 bit words wide (ie 128, 256 and 512 bits).
+	* Every function here is a fixed number of register operations (the index_sequence folds unroll at compile time), so there are no loops.
+	* The widest lane the target supports is picked, so a 512 bit mask is one __m512i, two __m256i, four __m128i or eight std::uint64_t.
+	* Like the rest of the library, bit i lives in byte i / CHAR_SIZE, which means this assumes a little endian machine.
+	*/
+	template <
+		const std::size_t _words,
+		std::enable_if_t < (_words == 2 || _words == 4 || _words == 8), bool > = true
+	>
+		class WideKernels {
+#if defined(_BITUTILS_HAS_AVX512)
+		typedef std::conditional_t < (_words >= 8), Lane512, std::conditional_t < (_words >= 4), Lane256, Lane128 > > Lane;
+#elif defined(_BITUTILS_HAS_AVX2)
+		typedef std::conditional_t < (_words >= 4), Lane256, Lane128 > Lane;
+#elif defined(_BITUTILS_HAS_SSE2)
+		typedef Lane128 Lane;
+#else
+		typedef Lane64 Lane;
+#endif
+		constexpr static const std::size_t lanes = _words / Lane::words;
+		constexpr static const std::size_t lane_size = Lane::words * sizeof(std::uint64_t);
+
+		static const unsigned char* at(const void* const block, const std::size_t lane) {
+			return reinterpret_cast<const unsigned char*>(block) + lane * lane_size;
+		}
+		static unsigned char* at(void* const block, const std::size_t lane) {
+			return reinterpret_cast<unsigned char*>(block) + lane * lane_size;
+		}
+
+		template <class Op, std::size_t... L>
+		static void binary(const void* const left, const void* const right, void* const dst, Op op, std::index_sequence<L...>) {
+			// Loading every lane before storing any of them so left, right and dst can all be the same block.
+			const typename Lane::type result[] = { op(Lane::load(at(left, L)), Lane::load(at(right, L)))... };
+			(Lane::store(at(dst, L), result[L]), ...);
+		}
+
+		template <std::size_t... L>
+		static void bitwise_not(const void* const src, void* const dst, std::index_sequence<L...>) {
+			const typename Lane::type result[] = { Lane::bitwise_not(Lane::load(at(src, L)))... };
+			(Lane::store(at(dst, L), result[L]), ...);
+		}
+
+		template <std::size_t... L>
+		static bool equals(const void* const left, const void* const right, std::index_sequence<L...>) {
+			typename Lane::type diff = Lane::zero();
+			((diff = Lane::bitwise_or(diff, Lane::bitwise_xor(Lane::load(at(left, L)), Lane::load(at(right, L))))), ...);
+			return Lane::is_zero(diff);
+		}
+
+		template <std::size_t... L>
+		static bool bool_op(const void* const block, std::index_sequence<L...>) {
+			typename Lane::type any = Lane::zero();
+			((any = Lane::bitwise_or(any, Lane::load(at(block, L)))), ...);
+			return !Lane::is_zero(any);
+		}
+
+		template <std::size_t... L>
+		static bool all(const void* const block, std::index_sequence<L...>) {
+			typename Lane::type missing = Lane::zero();
+			((missing = Lane::bitwise_or(missing, Lane::bitwise_not(Lane::load(at(block, L))))), ...);
+			return Lane::is_zero(missing);
+		}
+
+		template <std::size_t... L>
+		static std::size_t count(const void* const block, std::index_sequence<L...>) {
+			return (Lane::count(Lane::load(at(block, L))) + ...);
+		}
+
+		template <std::size_t... L>
+		static std::size_t find_first(const void* const block, std::index_sequence<L...>) {
+			const unsigned nonzero = ((Lane::nonzero_words(Lane::load(at(block, L))) << (L * Lane::words)) | ...);
+			if (!nonzero)
+				return _words * 64;
+			const std::size_t word = countr_zero(nonzero);
+			return word * 64 + countr_zero(Lane64::load(reinterpret_cast<const unsigned char*>(block) + word * sizeof(std::uint64_t)));
+		}
+
+		// Shifting is done on the words themselves. The words are padded with 0s on the side we're shifting in from,
+		// which means every output word is the same two loads and shifts no matter how far we shift (no branches).
+		template <std::size_t... W>
+		static void shift_left(void* const block, const std::size_t amount, std::index_sequence<W...>) {
+			std::uint64_t words[_words * 2] = {};
+			memcpy(words, block, _words * sizeof(std::uint64_t));
+			const std::size_t by_words = amount / 64;
+			const std::size_t by_bits = amount % 64;
+			// (x << 1 << (63 - by_bits)) is x << (64 - by_bits) without the undefined behavior when by_bits is 0.
+			const std::uint64_t result[] = {
+				(words[W + by_words] >> by_bits) | (words[W + by_words + 1] << 1 << (63 - by_bits))...
+			};
+			memcpy(block, result, sizeof(result));
+		}
+
+		template <std::size_t... W>
+		static void shift_right(void* const block, const std::size_t amount, std::index_sequence<W...>) {
+			std::uint64_t words[_words * 2] = {};
+			memcpy(words + _words, block, _words * sizeof(std::uint64_t));
+			const std::size_t by_words = amount / 64;
+			const std::size_t by_bits = amount % 64;
+			const std::uint64_t result[] = {
+				(words[_words + W - by_words] << by_bits) | (words[_words + W - by_words - 1] >> 1 >> (63 - by_bits))...
+			};
+			memcpy(block, result, sizeof(result));
+		}
+
+		public:
+			static void bitwise_and(const void* const left, const void* const right, void* const dst) {
+				binary(left, right, dst, Lane::bitwise_and, std::make_index_sequence<lanes>());
+			}
+			static void bitwise_or(const void* const left, const void* const right, void* const dst) {
+				binary(left, right, dst, Lane::bitwise_or, std::make_index_sequence<lanes>());
+			}
+			static void bitwise_xor(const void* const left, const void* const right, void* const dst) {
+				binary(left, right, dst, Lane::bitwise_xor, std::make_index_sequence<lanes>());
+			}
+			static void bitwise_not(const void* const src, void* const dst) {
+				bitwise_not(src, dst, std::make_index_sequence<lanes>());
+			}
+			static bool equals(const void* const left, const void* const right) {
+				return equals(left, right, std::make_index_sequence<lanes>());
+			}
+			static bool bool_op(const void* const block) {
+				return bool_op(block, std::make_index_sequence<lanes>());
+			}
+			static bool all(const void* const block) {
+				return all(block, std::make_index_sequence<lanes>());
+			}
+			static std::size_t count(const void* const block) {
+				return count(block, std::make_index_sequence<lanes>());
+			}
+			/* Returns the index of the lowest set bit, or _words * 64 if there isn't one. */
+			static std::size_t find_first(const void* const block) {
+				return find_first(block, std::make_index_sequence<lanes>());
+			}
+			/* amount must be < _words * 64. */
+			static void shift_left(void* const block, const std::size_t amount) {
+				shift_left(block, amount, std::make_index_sequence<_words>());
+			}
+			/* amount must be < _words * 64. */
+			static void shift_right(void* const block, const std::size_t amount) {
+				shift_right(block, amount, std::make_index_sequence<_words>());
+			}
+	};
+
+	// ========== CONSTEXPR STORAGE ==========
+
+	/* A fixed size memory block that can be used in constant expressions, so lookup tables can be computed at compile time
+	* and end up in read only memory instead of being built at startup.
+	* The bytes are laid out exactly like a memory block from create(), so data() can be handed to any of the void* functions.
+	*/
+	template <
+		const std::size_t _n,
+		std::enable_if_t < (_n > 0), bool > = true
+	>
+		struct BitStorage {
+		constexpr static const std::size_t n = _n; // The number of bits in the memory block.
+
+		std::array<unsigned char, (_n + CHAR_SIZE - 1) / CHAR_SIZE> bytes{};
+
+		constexpr unsigned char* data() { return bytes.data(); }
+		constexpr const unsigned char* data() const { return bytes.data(); }
+	};
+
 	template <
 		const std::size_t _n,
 		const std::size_t _start_bit = 0,
@@ -50,11 +320,16 @@ namespace BitUtils {
 
 		public:
 			constexpr static const std::size_t n = _end_bit - _start_bit; // The number of bits we're working with.
-			constexpr static const std::size_t size = floorlog2(_n); // The number of bytes that would be allocated.
+			constexpr static const std::size_t size = (_n + CHAR_SIZE - 1) / CHAR_SIZE; // The number of bytes that would be allocated.
 			constexpr static const std::size_t start_bit = _start_bit; // The index of the bit to start on (inclusive).
 			constexpr static const std::size_t end_bit = _end_bit; // The index of the bit to end on (exclusive).
 			constexpr static const bool is_bounded = start_bit != 0 || end_bit != _n;
 			constexpr static const bool is_soft_bounded = !is_bounded && size * CHAR_SIZE != _n;
+			constexpr static const bool is_wide = !is_bounded && (_n == 128 || _n == 256 || _n == 512); // Whether the WideKernels can be used.
+
+			/* Whether this and all the given BitUtils classes are wide and of the same width, meaning the WideKernels can be used for all of them. */
+			template <class... Others>
+			constexpr static const bool all_wide = is_wide && ((Others::is_wide && Others::n == n) && ...);
 
 			// ========== TYPE DEFS ==========
 
@@ -91,6 +366,9 @@ namespace BitUtils {
 			>
 				using of = BitUtils<sizeof(Type)* CHAR_SIZE>;
 
+			/* The constexpr memory block type that goes with this BitUtils class. Bounds don't change the storage, they only change which bits get touched. */
+			typedef BitStorage<_n> storage;
+
 			// ========== CORE FUNCTIONS ==========
 
 			static unsigned char* const getPage(void* const block, const std::size_t i) {
@@ -152,6 +430,174 @@ namespace BitUtils {
 					flip(src, i);
 			}
 
+			// ========== CONSTEXPR FUNCTIONS ==========
+			// These mirror the void* functions, but work on a storage object so they can be evaluated at compile time.
+
+		private:
+			// Whether we're running for real (as opposed to being evaluated by the compiler), in which case the void* functions are faster.
+			// There's no way to tell before C++20, so we always take the constexpr path.
+			constexpr static bool is_runtime() {
+#if defined(__cpp_lib_is_constant_evaluated)
+				return !std::is_constant_evaluated();
+#else
+				return false;
+#endif
+			}
+
+		public:
+			constexpr static bool get(const storage& block, const std::size_t i) {
+				return (block.bytes[(i + start_bit) / CHAR_SIZE] >> ((i + start_bit) % CHAR_SIZE)) & 1;
+			}
+
+			constexpr static void flip(storage& block, const std::size_t i) {
+				block.bytes[(i + start_bit) / CHAR_SIZE] ^= (unsigned char)(1u << ((i + start_bit) % CHAR_SIZE));
+			}
+
+			constexpr static void set(storage& block, const std::size_t i, const bool b) {
+				if (b)
+					block.bytes[(i + start_bit) / CHAR_SIZE] |= (unsigned char)(1u << ((i + start_bit) % CHAR_SIZE));
+				else
+					block.bytes[(i + start_bit) / CHAR_SIZE] &= (unsigned char)~(1u << ((i + start_bit) % CHAR_SIZE));
+			}
+
+			constexpr static void fill(storage& block, const bool b) {
+				if constexpr (is_bounded) {
+					for (std::size_t i = 0; i < n; i++) {
+						set(block, i, b);
+					}
+				}
+				else {
+					for (std::size_t i = 0; i < size; i++) {
+						block.bytes[i] = b ? (unsigned char)-1 : 0;
+					}
+				}
+			}
+
+			constexpr static void bitwise_and(const storage& left, const storage& right, storage& dst) {
+				if (is_runtime())
+					return bitwise_and(left.data(), right.data(), dst.data());
+				if constexpr (is_bounded) {
+					for (std::size_t i = 0; i < n; i++) {
+						set(dst, i, get(left, i) & get(right, i));
+					}
+				}
+				else {
+					for (std::size_t i = 0; i < size; i++) {
+						dst.bytes[i] = left.bytes[i] & right.bytes[i];
+					}
+				}
+			}
+
+			constexpr static void bitwise_or(const storage& left, const storage& right, storage& dst) {
+				if (is_runtime())
+					return bitwise_or(left.data(), right.data(), dst.data());
+				if constexpr (is_bounded) {
+					for (std::size_t i = 0; i < n; i++) {
+						set(dst, i, get(left, i) | get(right, i));
+					}
+				}
+				else {
+					for (std::size_t i = 0; i < size; i++) {
+						dst.bytes[i] = left.bytes[i] | right.bytes[i];
+					}
+				}
+			}
+
+			constexpr static void bitwise_xor(const storage& left, const storage& right, storage& dst) {
+				if (is_runtime())
+					return bitwise_xor(left.data(), right.data(), dst.data());
+				if constexpr (is_bounded) {
+					for (std::size_t i = 0; i < n; i++) {
+						set(dst, i, get(left, i) ^ get(right, i));
+					}
+				}
+				else {
+					for (std::size_t i = 0; i < size; i++) {
+						dst.bytes[i] = left.bytes[i] ^ right.bytes[i];
+					}
+				}
+			}
+
+			constexpr static void bitwise_not(const storage& src, storage& dst) {
+				if constexpr (is_bounded) {
+					for (std::size_t i = 0; i < n; i++) {
+						set(dst, i, !get(src, i));
+					}
+				}
+				else {
+					for (std::size_t i = 0; i < size; i++) {
+						dst.bytes[i] = (unsigned char)~src.bytes[i];
+					}
+				}
+			}
+
+			constexpr static void bitwise_not(storage& block) {
+				bitwise_not(block, block);
+			}
+
+			constexpr static void shift_left(storage& block, const std::size_t amount) {
+				if (is_runtime())
+					return shift_left(block.data(), amount);
+				for (std::size_t i = 0; i < n; i++) {
+					set(block, i, i + amount < n && get(block, i + amount));
+				}
+			}
+
+			constexpr static void shift_right(storage& block, const std::size_t amount) {
+				if (is_runtime())
+					return shift_right(block.data(), amount);
+				for (std::size_t i = n; i > 0; i--) {
+					set(block, i - 1, i - 1 >= amount && get(block, i - 1 - amount));
+				}
+			}
+
+			constexpr static bool equals(const storage& left, const storage& right) {
+				for (std::size_t i = 0; i < n; i++) {
+					if (get(left, i) != get(right, i))
+						return false;
+				}
+				return true;
+			}
+
+			constexpr static std::size_t count(const storage& block) {
+				if (is_runtime())
+					return count(block.data());
+				std::size_t total = 0;
+				for (std::size_t i = 0; i < n; i++) {
+					total += get(block, i);
+				}
+				return total;
+			}
+
+			constexpr static std::size_t find_first(const storage& block) {
+				for (std::size_t i = 0; i < n; i++) {
+					if (get(block, i))
+						return i;
+				}
+				return n;
+			}
+
+			/// <summary>
+			/// Interprets a string made from str() and puts the data into the storage. If this is evaluated at compile time, an unrecognized char is a compile error.
+			/// </summary>
+			/// <param name="block">the storage to write to.</param>
+			/// <param name="s">the string to interpret. Only the first n chars are used.</param>
+			constexpr static void from_str(storage& block, const std::string_view s) {
+				const std::size_t min_n = n < s.length() ? n : s.length();
+				for (std::size_t i = 0; i < min_n; i++) {
+					switch (s[i]) {
+					case '0':
+						set(block, i, 0);
+						break;
+					case '1':
+						set(block, i, 1);
+						break;
+					default:
+						throw std::invalid_argument("unrecognized char in bit string");
+					}
+				}
+			}
+
 			// ========== FUNCTIONS ==========
 
 			/// <summary>
@@ -259,7 +705,9 @@ namespace BitUtils {
 				std::enable_if_t < std::is_convertible_v<BitUtils, BitUtils_dst>, bool > = true
 			>
 				static void bitwise_and(const void* const left, const void* const right, void* const dst) {
-				if constexpr (BitUtils_left::is_bounded || BitUtils_right::is_bounded || BitUtils_dst::is_bounded) {
+				if constexpr (all_wide<BitUtils_left, BitUtils_right, BitUtils_dst>)
+					WideKernels<n / 64>::bitwise_and(left, right, dst);
+				else if constexpr (BitUtils_left::is_bounded || BitUtils_right::is_bounded || BitUtils_dst::is_bounded) {
 					if constexpr (
 						BitUtils_left::n == BitUtils_right::n &&
 						BitUtils_left::start_bit == BitUtils_right::start_bit &&
@@ -341,6 +789,10 @@ namespace BitUtils {
 				std::enable_if_t < std::is_convertible_v<BitUtils, BitUtils_dst>, bool > = true
 			>
 				static void bitwise_or(const void* const left, const void* const right, void* const dst) {
+				if constexpr (all_wide<BitUtils_left, BitUtils_right, BitUtils_dst>) {
+					WideKernels<n / 64>::bitwise_or(left, right, dst);
+					return;
+				}
 				if (left == right) {
 					if (left == dst)
 						return;
@@ -396,7 +848,9 @@ namespace BitUtils {
 				std::enable_if_t < std::is_convertible_v<BitUtils, BitUtils_dst>, bool > = true
 			>
 				static void bitwise_xor(const void* const left, const void* const right, void* const dst) {
-				if constexpr (BitUtils_left::is_bounded || BitUtils_right::is_bounded || BitUtils_dst::is_bounded) {
+				if constexpr (all_wide<BitUtils_left, BitUtils_right, BitUtils_dst>)
+					WideKernels<n / 64>::bitwise_xor(left, right, dst);
+				else if constexpr (BitUtils_left::is_bounded || BitUtils_right::is_bounded || BitUtils_dst::is_bounded) {
 					constexpr const std::size_t min_n = _BITUTILS_MIN(_BITUTILS_MIN(BitUtils_left::n, BitUtils_right::n), BitUtils_dst::n);
 
 					std::size_t i = 0;
@@ -460,7 +914,9 @@ namespace BitUtils {
 				std::enable_if_t < std::is_convertible_v<BitUtils, BitUtils_dst>, bool > = true
 			>
 				static void bitwise_not(const void* const src, void* const dst) {
-				if constexpr (BitUtils_src::is_bounded || BitUtils_dst::is_bounded) {
+				if constexpr (all_wide<BitUtils_src, BitUtils_dst>)
+					WideKernels<n / 64>::bitwise_not(src, dst);
+				else if constexpr (BitUtils_src::is_bounded || BitUtils_dst::is_bounded) {
 					if constexpr (do_bounds_overlap<BitUtils_src, BitUtils_dst>(src, dst)) {
 
 						constexpr std::size_t min_n = _BITUTILS_MIN(BitUtils_src::n, BitUtils_dst::n);
@@ -506,11 +962,17 @@ namespace BitUtils {
 					return;
 				}
 
-				copy<
-					BitUtils<n, start_bit + amount, end_bit>,
-					BitUtils<n, start_bit, end_bit - amount>
-				>(block, block);
-				BitUtils<n, end_bit - amount, end_bit>::fill(block, 0);
+				if constexpr (is_wide)
+					WideKernels<n / 64>::shift_left(block, amount);
+				else {
+					// amount isn't known at compile time, so we can't make bounded BitUtils classes out of it.
+					for (std::size_t i = 0; i < n - amount; i++) {
+						set(block, i, get(block, i + amount));
+					}
+					for (std::size_t i = n - amount; i < n; i++) {
+						set(block, i, 0);
+					}
+				}
 			}
 
 			static void shift_right(void* const block, const std::size_t amount) {
@@ -521,11 +983,16 @@ namespace BitUtils {
 					return;
 				}
 
-				copy<
-					BitUtils<n, start_bit, end_bit - amount>,
-					BitUtils<n, start_bit + amount, end_bit>
-				>(block, block);
-				BitUtils<n, start_bit, start_bit + amount>::fill(block, 0);
+				if constexpr (is_wide)
+					WideKernels<n / 64>::shift_right(block, amount);
+				else {
+					for (std::size_t i = n; i > amount; i--) {
+						set(block, i - 1, get(block, i - 1 - amount));
+					}
+					for (std::size_t i = 0; i < amount; i++) {
+						set(block, i, 0);
+					}
+				}
 			}
 
 			/// <summary>
@@ -534,7 +1001,9 @@ namespace BitUtils {
 			/// <param name="src">the pointer to the source memory block.</param>
 			/// <returns>true if any of the bits are 1 and false if all the bits are 0.</returns>
 			static bool bool_op(const void* const block) {
-				if constexpr (is_bounded) {
+				if constexpr (is_wide)
+					return WideKernels<n / 64>::bool_op(block);
+				else if constexpr (is_bounded) {
 					for (std::size_t i = 0; i < n; i++) {
 						if (get(block, i))
 							return true;
@@ -557,7 +1026,9 @@ namespace BitUtils {
 				std::enable_if_t < std::is_convertible_v<BitUtils, BitUtils_right>, bool > = true
 			>
 				static bool equals(const void* const left, const void* const right) {
-				if constexpr (BitUtils_left::is_bounded || BitUtils_right::is_bounded)
+				if constexpr (all_wide<BitUtils_left, BitUtils_right>)
+					return WideKernels<n / 64>::equals(left, right);
+				else if constexpr (BitUtils_left::is_bounded || BitUtils_right::is_bounded)
 					return 0 == compare<BitUtils_left, BitUtils_right>(left, right);
 				else { // unbounded
 					for (std::size_t i = 0; i < size; i++) {
@@ -592,7 +1063,9 @@ namespace BitUtils {
 			}
 
 			static bool all(const void* const block) {
-				if constexpr (is_bounded) {
+				if constexpr (is_wide)
+					return WideKernels<n / 64>::all(block);
+				else if constexpr (is_bounded) {
 					for (std::size_t i = 0; i < n; i++) {
 						if (!get(block, i))
 							return false;
@@ -608,6 +1081,59 @@ namespace BitUtils {
 				}
 			}
 
+			/// <summary>
+			/// Counts the bits that are set to 1.
+			/// </summary>
+			/// <param name="block">the pointer to the memory block.</param>
+			/// <returns>the number of set bits.</returns>
+			static std::size_t count(const void* const block) {
+				if constexpr (is_wide)
+					return WideKernels<n / 64>::count(block);
+				else if constexpr (is_bounded) {
+					std::size_t total = 0;
+					for (std::size_t i = 0; i < n; i++) {
+						total += get(block, i);
+					}
+					return total;
+				}
+				else { // unbounded
+					std::size_t total = 0;
+					for (std::size_t i = 0; i < n / CHAR_SIZE; i++) {
+						total += popcount(*BitUtils::getPage(block, i * CHAR_SIZE));
+					}
+					if constexpr (n % CHAR_SIZE != 0)
+						total += popcount(*BitUtils::getPage(block, n - 1) & ((1u << (n % CHAR_SIZE)) - 1));
+					return total;
+				}
+			}
+
+			/// <summary>
+			/// Finds the lowest bit that is set to 1.
+			/// </summary>
+			/// <param name="block">the pointer to the memory block.</param>
+			/// <returns>the index of the first set bit, or n if none of the bits are set.</returns>
+			static std::size_t find_first(const void* const block) {
+				if constexpr (is_wide)
+					return WideKernels<n / 64>::find_first(block);
+				else if constexpr (is_bounded) {
+					for (std::size_t i = 0; i < n; i++) {
+						if (get(block, i))
+							return i;
+					}
+					return n;
+				}
+				else { // unbounded
+					for (std::size_t i = 0; i < size; i++) {
+						const unsigned char page = *BitUtils::getPage(block, i * CHAR_SIZE);
+						if (page) {
+							const std::size_t found = i * CHAR_SIZE + countr_zero(page);
+							return found < n ? found : n;
+						}
+					}
+					return n;
+				}
+			}
+
 			static void str(const void* const arr_ptr, char* const buf) {
 				if (!strlen(buf))
 					return;
@@ -781,6 +1307,129 @@ namespace BitUtils {
 				return BitUtils<other_n, other_start_bit, other_end_bit>();
 			}
 	};
+
+	// ========== LITERALS ==========
+
+	/* Parses the text of a _bits literal at compile time. The text follows the same rules as from_str() (bit 0 is the left most char), except that:
+	* a 0b prefix is allowed (and ignored).
+	* a 0x prefix makes every digit after it a hex digit that stands for 4 bits, most significant first (ie 0xA is the same as 1010).
+	* digit separators (') are ignored.
+	*/
+	class BitLiteral {
+		constexpr static bool has_prefix(const std::string_view s, const char lower) {
+			return s.length() > 2 && s[0] == '0' && (s[1] == lower || s[1] == lower - ('a' - 'A'));
+		}
+
+		constexpr static int digit(const char c) {
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F')
+				return c - 'A' + 10;
+			return -1;
+		}
+
+		constexpr static std::size_t prefix(const std::string_view s) {
+			return (is_hex(s) || has_prefix(s, 'b')) ? 2 : 0;
+		}
+
+		constexpr static std::size_t digits(const std::string_view s) {
+			std::size_t total = 0;
+			for (std::size_t i = prefix(s); i < s.length(); i++) {
+				total += s[i] != '\'';
+			}
+			return total;
+		}
+
+	public:
+		constexpr static bool is_hex(const std::string_view s) {
+			return has_prefix(s, 'x');
+		}
+
+		/* Whether the text only has digits that are allowed (and has at least one of them). */
+		constexpr static bool is_valid(const std::string_view s) {
+			for (std::size_t i = prefix(s); i < s.length(); i++) {
+				if (s[i] == '\'')
+					continue;
+				const int d = digit(s[i]);
+				if (is_hex(s) ? d < 0 : (d != 0 && d != 1))
+					return false;
+			}
+			return digits(s) > 0;
+		}
+
+		/* The number of bits the text stands for. This is never 0 so that an invalid literal only trips the static_assert. */
+		constexpr static std::size_t n(const std::string_view s) {
+			const std::size_t bits = digits(s) * (is_hex(s) ? 4 : 1);
+			return bits ? bits : 1;
+		}
+
+		template <const std::size_t _n>
+		constexpr static BitStorage<_n> parse(const std::string_view s) {
+			BitStorage<_n> block{};
+			std::size_t bit = 0;
+			for (std::size_t i = prefix(s); i < s.length(); i++) {
+				if (s[i] == '\'')
+					continue;
+				const int d = digit(s[i]);
+				if (is_hex(s)) {
+					for (int j = 3; j >= 0; j--) {
+						BitUtils<_n>::set(block, bit++, (d >> j) & 1);
+					}
+				}
+				else
+					BitUtils<_n>::set(block, bit++, d);
+			}
+			return block;
+		}
+	};
+
+	template <char... _chars>
+	constexpr const char bit_literal_chars[] = { _chars... };
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L // C++20
+	/* Holds the text of a string literal so it can be used as a template argument. */
+	template <const std::size_t _length>
+	struct BitString {
+		char chars[_length] = {};
+
+		constexpr BitString(const char(&s)[_length]) {
+			for (std::size_t i = 0; i < _length; i++) {
+				chars[i] = s[i];
+			}
+		}
+
+		constexpr std::string_view view() const {
+			return std::string_view(chars, _length - 1); // minus the null terminator
+		}
+	};
+#endif // C++20
+
+	/* User defined literals for making BitStorage objects at compile time. Use them with: using namespace BitUtils::literals;
+	*
+	* 0101_bits is a BitStorage<4> where bit 1 and bit 3 are set.
+	* 0xF0_bits is a BitStorage<8> where bits 0 through 3 are set.
+	* "0101"_bits does the same as 0101_bits (C++20 only).
+	*
+	* Anything other than 0s and 1s (or hex digits after 0x) is a compile error.
+	*/
+	namespace literals {
+		template <char... _chars>
+		constexpr BitStorage<BitLiteral::n(std::string_view(bit_literal_chars<_chars...>, sizeof...(_chars)))> operator""_bits() {
+			constexpr std::string_view s(bit_literal_chars<_chars...>, sizeof...(_chars));
+			static_assert(BitLiteral::is_valid(s), "a _bits literal can only have 0s and 1s (or hex digits after 0x) in it");
+			return BitLiteral::parse<BitLiteral::n(s)>(s);
+		}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L // C++20
+		template <BitString _s>
+		constexpr BitStorage<BitLiteral::n(_s.view())> operator""_bits() {
+			static_assert(BitLiteral::is_valid(_s.view()), "a _bits literal can only have 0s and 1s (or hex digits after 0x) in it");
+			return BitLiteral::parse<BitLiteral::n(_s.view())>(_s.view());
+		}
+#endif // C++20
+	}
 }
 #undef _BITUTILS_MIN
 #endif // C++17
@@ -0,0 +1,322 @@
+/* BitUtils20.h
+* Author: Grayson Spidle
+*
+* This file defines C++20 ranges views over the bits of a memory block (or a BitStorage from BitUtils17.h).
+* They're lazy: nothing is read until you iterate, and the iterators move a word at a time, so something like
+*
+*     span | BitUtils::views::set_positions | std::views::filter(...) | std::views::take(100)
+*
+* stops reading memory as soon as it has its 100 results.
+*
+* The bare minimum language standard for this file is C++20
+*/
+
+#ifndef __BITUTILS20_H__
+#define __BITUTILS20_H__
+
+#include "BitUtils.h"
+#include "BitUtils17.h"
+
+#if __cplusplus >= 202002L && __has_include(<ranges>) // C++20
+#include <ranges>
+#include <iterator>
+#endif // C++20
+
+#if defined(__cpp_lib_ranges) // C++20
+namespace BitUtils {
+	namespace views {
+		// Where the words come from. Iterators keep a copy of this instead of pointing at their view,
+		// so they stay valid after the view is gone (as long as the memory block is still around).
+		struct _Words {
+			const unsigned char* page = nullptr; // the byte that holds the first bit.
+			std::size_t shift = 0; // the index of the first bit within page.
+			std::size_t n = 0; // the number of bits.
+
+			_Words() = default;
+			_Words(const ConstBitSpan& span) : page(span.page), shift(span.shift), n(span.n) {}
+
+			// The number of words, counting the partial one at the end.
+			std::size_t count() const {
+				return (n + 63) / 64;
+			}
+
+			// Word k, where the bits past the end are 0.
+			std::uint64_t load(const std::size_t k) const {
+				return _load_bits(page + k * sizeof(std::uint64_t), shift, _word_len(n, k));
+			}
+
+			// The bits of word k that are actually in the view.
+			std::uint64_t mask(const std::size_t k) const {
+				const std::size_t len = _word_len(n, k);
+				return len == 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << len) - 1;
+			}
+
+			// The index of the first bit at or after from that is equal to value, or n if there isn't one.
+			std::size_t find_next(const std::size_t from, const bool value) const {
+				for (std::size_t k = from / 64; k < count(); k++) {
+					std::uint64_t w = value ? load(k) : ~load(k) & mask(k);
+					if (k == from / 64)
+						w &= ~(std::uint64_t)0 << (from % 64);
+					if (w)
+						return k * 64 + countr_zero(w);
+				}
+				return n;
+			}
+		};
+
+		/* The indices of the bits that are 1 (or 0 if _invert is true), from lowest to highest.
+		* Zero words are skipped and the next index comes from tzcnt, so this costs one step per word plus one per result.
+		*/
+		template < bool _invert >
+		class PositionView : public std::ranges::view_interface<PositionView<_invert>> {
+		public:
+			class iterator {
+			public:
+				using value_type = std::size_t;
+				using difference_type = std::ptrdiff_t;
+				using iterator_concept = std::forward_iterator_tag;
+				using iterator_category = std::input_iterator_tag; // the reference isn't a real reference
+
+				iterator() = default;
+				explicit iterator(const _Words& words) : words(words) {
+					fetch();
+				}
+
+				std::size_t operator*() const {
+					return k * 64 + countr_zero(w);
+				}
+
+				iterator& operator++() {
+					w &= w - 1;
+					if (!w) {
+						k++;
+						fetch();
+					}
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator temp = *this;
+					++*this;
+					return temp;
+				}
+
+				friend bool operator==(const iterator& left, const iterator& right) {
+					return left.k == right.k && left.w == right.w;
+				}
+
+				friend bool operator==(const iterator& it, std::default_sentinel_t) {
+					return it.k >= it.words.count();
+				}
+
+			private:
+				// Moves k to the next word that has something in it (starting at k).
+				void fetch() {
+					for (; k < words.count(); k++) {
+						w = _invert ? ~words.load(k) & words.mask(k) : words.load(k);
+						if (w)
+							return;
+					}
+					w = 0;
+				}
+
+				_Words words;
+				std::size_t k = 0; // the word we're in.
+				std::uint64_t w = 0; // the bits of word k we haven't visited yet.
+			};
+
+			PositionView() = default;
+			explicit PositionView(const ConstBitSpan& span) : words(span) {}
+
+			iterator begin() const {
+				return iterator(words);
+			}
+
+			std::default_sentinel_t end() const {
+				return std::default_sentinel;
+			}
+
+		private:
+			_Words words;
+		};
+
+		/* The runs of 1s as [first, second) pairs of indices, from lowest to highest.
+		* Each step is two word scans: one for the next 1 and one for the 0 after it.
+		*/
+		class RunView : public std::ranges::view_interface<RunView> {
+		public:
+			class iterator {
+			public:
+				using value_type = std::pair<std::size_t, std::size_t>;
+				using difference_type = std::ptrdiff_t;
+				using iterator_concept = std::forward_iterator_tag;
+				using iterator_category = std::input_iterator_tag;
+
+				iterator() = default;
+				explicit iterator(const _Words& words) : words(words) {
+					find(0);
+				}
+
+				std::pair<std::size_t, std::size_t> operator*() const {
+					return run;
+				}
+
+				iterator& operator++() {
+					find(run.second);
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator temp = *this;
+					++*this;
+					return temp;
+				}
+
+				friend bool operator==(const iterator& left, const iterator& right) {
+					return left.run == right.run;
+				}
+
+				friend bool operator==(const iterator& it, std::default_sentinel_t) {
+					return it.run.first >= it.words.n;
+				}
+
+			private:
+				// Finds the first run at or after from.
+				void find(const std::size_t from) {
+					run.first = from < words.n ? words.find_next(from, true) : words.n;
+					run.second = run.first < words.n ? words.find_next(run.first, false) : words.n;
+				}
+
+				_Words words;
+				std::pair<std::size_t, std::size_t> run;
+			};
+
+			RunView() = default;
+			explicit RunView(const ConstBitSpan& span) : words(span) {}
+
+			iterator begin() const {
+				return iterator(words);
+			}
+
+			std::default_sentinel_t end() const {
+				return std::default_sentinel;
+			}
+
+		private:
+			_Words words;
+		};
+
+		/* The bits as 64 bit words. Word k holds bits [64k, 64k + 64), bit 0 being the lowest, and the bits past the end of the last word are 0. */
+		class WordView : public std::ranges::view_interface<WordView> {
+		public:
+			class iterator {
+			public:
+				using value_type = std::uint64_t;
+				using difference_type = std::ptrdiff_t;
+				using iterator_concept = std::forward_iterator_tag;
+				using iterator_category = std::input_iterator_tag;
+
+				iterator() = default;
+				explicit iterator(const _Words& words) : words(words) {}
+
+				std::uint64_t operator*() const {
+					return words.load(k);
+				}
+
+				iterator& operator++() {
+					k++;
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator temp = *this;
+					++*this;
+					return temp;
+				}
+
+				friend bool operator==(const iterator& left, const iterator& right) {
+					return left.k == right.k;
+				}
+
+				friend bool operator==(const iterator& it, std::default_sentinel_t) {
+					return it.k >= it.words.count();
+				}
+
+			private:
+				_Words words;
+				std::size_t k = 0;
+			};
+
+			WordView() = default;
+			explicit WordView(const ConstBitSpan& span) : words(span) {}
+
+			iterator begin() const {
+				return iterator(words);
+			}
+
+			std::default_sentinel_t end() const {
+				return std::default_sentinel;
+			}
+
+			std::size_t size() const {
+				return words.count();
+			}
+
+		private:
+			_Words words;
+		};
+
+		// Makes a view out of a ConstBitSpan (or anything that turns into one, like a BitSpan) or a BitStorage.
+		// It can be called like a function or used at the start of a pipeline.
+		template < class _View >
+		struct _ViewAdaptor {
+			_View operator()(const ConstBitSpan& bits) const {
+				return _View(bits);
+			}
+
+			template < std::size_t _n >
+			_View operator()(const BitStorage<_n>& bits) const {
+				return _View(ConstBitSpan(bits.data(), _n));
+			}
+
+			// The view would point into a temporary.
+			template < std::size_t _n >
+			_View operator()(const BitStorage<_n>&& bits) const = delete;
+
+			friend _View operator|(const ConstBitSpan& bits, const _ViewAdaptor& adaptor) {
+				return adaptor(bits);
+			}
+
+			template < std::size_t _n >
+			friend _View operator|(const BitStorage<_n>& bits, const _ViewAdaptor& adaptor) {
+				return adaptor(bits);
+			}
+
+			template < std::size_t _n >
+			friend _View operator|(const BitStorage<_n>&& bits, const _ViewAdaptor& adaptor) = delete;
+		};
+
+		/* The indices of the bits that are 1. */
+		inline constexpr _ViewAdaptor<PositionView<false>> set_positions{};
+
+		/* The indices of the bits that are 0. */
+		inline constexpr _ViewAdaptor<PositionView<true>> clear_positions{};
+
+		/* The runs of 1s as [first, second) pairs of indices. */
+		inline constexpr _ViewAdaptor<RunView> runs{};
+
+		/* The bits as 64 bit words. */
+		inline constexpr _ViewAdaptor<WordView> words{};
+	}
+}
+
+// The iterators don't point into their views, so it's fine for them to outlive the views.
+template < bool _invert >
+inline constexpr bool std::ranges::enable_borrowed_range<BitUtils::views::PositionView<_invert>> = true;
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<BitUtils::views::RunView> = true;
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<BitUtils::views::WordView> = true;
+#endif // C++20
+
+#endif // __BITUTILS20_H__
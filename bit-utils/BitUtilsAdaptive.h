@@ -0,0 +1,396 @@
+/* BitUtilsAdaptive.h
+* Author: Grayson Spidle
+*
+* This file defines AdaptiveBitset, a bit array of up to 2^32 bits that keeps itself as a sorted array of the indices of its 1s while it's sparse
+* and as a memory block once it's dense, switching on its own as the number of 1s goes up and down.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_ADAPTIVE_H__
+#define __BITUTILS_ADAPTIVE_H__
+
+#include "BitUtils.h"
+#include <algorithm>
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	/* A bit array that is a sorted array of 32 bit indices while fewer than n / 32 of its bits are 1 (ie while that's smaller than the memory block)
+	* and a memory block after that. It only goes back to an array once fewer than n / 64 of its bits are 1, so a set that hovers around the line
+	* doesn't keep converting back and forth.
+	*
+	* The set operations are done differently for each pair of representations:
+	* array & array: the smaller one is looked up in the bigger one, which is galloped through 8 indices at a time and then checked with a vector compare.
+	* array & memory block: each index in the array is looked up in the memory block.
+	* memory block & memory block: the word kernels (bitwise_and() and friends).
+	* The result picks its representation by how many 1s it ended up with.
+	*/
+	class AdaptiveBitset {
+	public:
+		/* Makes a bit array of n bits that are all 0. Throws std::invalid_argument if n == 0 or n > 2^32. */
+		explicit AdaptiveBitset(const std::size_t n) : n(n) {
+			_validateBounds(n, 0);
+			if ((std::uint64_t)n > ((std::uint64_t)1 << 32))
+				throw std::invalid_argument("n cannot be > 2^32.");
+		}
+
+		/* Makes a bit array out of the bits in the view. Throws std::invalid_argument if the view has more than 2^32 bits. */
+		explicit AdaptiveBitset(const ConstBitSpan& bits) : AdaptiveBitset(bits.n) {
+			std::vector<std::uint64_t> block((n + 63) / 64);
+			BitUtils::copy(bits, BitSpan(block.data(), n));
+			adopt(std::move(block));
+		}
+
+		/* Returns the number of bits. */
+		std::size_t size() const {
+			return n;
+		}
+
+		/* Returns the number of bits that are 1. */
+		std::size_t count() const {
+			return ones;
+		}
+
+		/* Returns true if it's a memory block right now, false if it's an array. */
+		bool is_dense() const {
+			return dense;
+		}
+
+		/* Gets the selected bit's state. Throws std::out_of_range if i >= n. */
+		bool get(const std::size_t i) const {
+			if (dense)
+				return BitUtils::get(words.data(), n, i);
+			_validateBounds(n, i);
+			return std::binary_search(values.begin(), values.end(), (std::uint32_t)i);
+		}
+
+		/* Sets the selected bit to reflect the given boolean. Throws std::out_of_range if i >= n. */
+		void set(const std::size_t i, const bool b) {
+			if (dense) {
+				if (BitUtils::get(words.data(), n, i) == b)
+					return;
+				BitUtils::flip(words.data(), n, i);
+				if (b)
+					ones++;
+				else if (--ones < n / 64)
+					to_array();
+				return;
+			}
+			_validateBounds(n, i);
+			const auto it = std::lower_bound(values.begin(), values.end(), (std::uint32_t)i);
+			if ((it != values.end() && *it == i) == b)
+				return;
+			if (b) {
+				values.insert(it, (std::uint32_t)i);
+				if (++ones > n / 32)
+					to_block();
+			}
+			else {
+				values.erase(it);
+				ones--;
+			}
+		}
+
+		/* Calls f(i) for each bit that is 1, from lowest to highest.
+		* If f returns something then returning false stops the iteration. Returns false if f stopped the iteration early else returns true.
+		*/
+		template < class _F >
+		bool for_each(_F&& f) const {
+			if (dense)
+				return for_each_set_bit(ConstBitSpan(words.data(), n), f);
+			for (const std::uint32_t i : values) {
+				if (!_visit(f, (std::size_t)i))
+					return false;
+			}
+			return true;
+		}
+
+		/* Writes the bits to a view. Bit i of the view gets bit i of the bit array, and the bits past the end of the bit array get 0. */
+		void copy_to(const BitSpan& span) const {
+			if (dense) {
+				BitUtils::copy(ConstBitSpan(words.data(), n), span);
+				if (span.n > n)
+					BitUtils::fill(BitSpan(span.page, span.shift + n, span.shift + span.n), false);
+				return;
+			}
+			BitUtils::fill(span, false);
+			for (const std::uint32_t i : values) {
+				if (i >= span.n)
+					break;
+				BitUtils::set(span, i, true);
+			}
+		}
+
+		/* Writes the bits to the first n bits of a memory block. */
+		void copy_to(void* const block, const std::size_t n) const {
+			copy_to(BitSpan(block, n));
+		}
+
+		/* Writes the bits to the bits [start_bit, end_bit) of a memory block. */
+		void copy_to(void* const block, const std::size_t start_bit, const std::size_t end_bit) const {
+			copy_to(BitSpan(block, start_bit, end_bit));
+		}
+
+		/* Throws std::invalid_argument if the sizes aren't the same (for all of the set operations). */
+		friend AdaptiveBitset operator&(const AdaptiveBitset& left, const AdaptiveBitset& right) {
+			return combine(left, right, _AND);
+		}
+
+		friend AdaptiveBitset operator|(const AdaptiveBitset& left, const AdaptiveBitset& right) {
+			return combine(left, right, _OR);
+		}
+
+		friend AdaptiveBitset operator^(const AdaptiveBitset& left, const AdaptiveBitset& right) {
+			return combine(left, right, _XOR);
+		}
+
+		/* The bits that are 1 in left and 0 in right (and not). */
+		friend AdaptiveBitset operator-(const AdaptiveBitset& left, const AdaptiveBitset& right) {
+			return combine(left, right, _ANDNOT);
+		}
+
+		AdaptiveBitset& operator&=(const AdaptiveBitset& other) {
+			return *this = *this & other;
+		}
+
+		AdaptiveBitset& operator|=(const AdaptiveBitset& other) {
+			return *this = *this | other;
+		}
+
+		AdaptiveBitset& operator^=(const AdaptiveBitset& other) {
+			return *this = *this ^ other;
+		}
+
+		AdaptiveBitset& operator-=(const AdaptiveBitset& other) {
+			return *this = *this - other;
+		}
+
+		/* Two bit arrays are equal if they have the same size and the same bits, no matter how they're stored. */
+		friend bool operator==(const AdaptiveBitset& left, const AdaptiveBitset& right) {
+			if (left.n != right.n || left.ones != right.ones)
+				return false;
+			if (left.dense && right.dense)
+				return left.words == right.words;
+			if (!left.dense && !right.dense)
+				return left.values == right.values;
+			const AdaptiveBitset& array = left.dense ? right : left;
+			const AdaptiveBitset& block = left.dense ? left : right;
+			for (const std::uint32_t i : array.values) {
+				if (!BitUtils::get(block.words.data(), block.n, i))
+					return false;
+			}
+			return true;
+		}
+
+		friend bool operator!=(const AdaptiveBitset& left, const AdaptiveBitset& right) {
+			return !(left == right);
+		}
+
+	private:
+		enum Op { _AND, _OR, _XOR, _ANDNOT };
+
+		// Takes a memory block of n bits (with 0s past n) as the contents, and keeps it if it's dense enough.
+		void adopt(std::vector<std::uint64_t>&& block) {
+			ones = BitUtils::count(ConstBitSpan(block.data(), n));
+			values.clear();
+			if (ones > n / 32) {
+				dense = true;
+				words = std::move(block);
+				return;
+			}
+			dense = false;
+			words.clear();
+			values.reserve(ones);
+			for_each_set_bit(ConstBitSpan(block.data(), n), [this](const std::size_t i) {
+				values.push_back((std::uint32_t)i);
+			});
+		}
+
+		// Takes sorted indices as the contents.
+		void adopt(std::vector<std::uint32_t>&& indices) {
+			ones = indices.size();
+			words.clear();
+			if (ones > n / 32) {
+				values.clear();
+				dense = true;
+				words = block_of(indices);
+				return;
+			}
+			dense = false;
+			values = std::move(indices);
+		}
+
+		std::vector<std::uint64_t> block_of(const std::vector<std::uint32_t>& indices) const {
+			std::vector<std::uint64_t> block((n + 63) / 64, 0);
+			for (const std::uint32_t i : indices) {
+				BitUtils::set(block.data(), n, i, true);
+			}
+			return block;
+		}
+
+		void to_block() {
+			words = block_of(values);
+			values.clear();
+			values.shrink_to_fit();
+			dense = true;
+		}
+
+		void to_array() {
+			values.reserve(ones);
+			for_each_set_bit(ConstBitSpan(words.data(), n), [this](const std::size_t i) {
+				values.push_back((std::uint32_t)i);
+			});
+			words.clear();
+			words.shrink_to_fit();
+			dense = false;
+		}
+
+		// Whether x is in the sorted array big, starting at block (a multiple of 8 past where it started). block moves up to the 8 indices x would be in,
+		// going 1, 2, 4, ... blocks at a time and then binary searching, so the next (bigger) x can start there.
+		static bool find_block(const std::uint32_t* const big, const std::size_t size, std::size_t& block, const std::uint32_t x) {
+			if (block + 8 <= size && big[block + 7] < x) {
+				std::size_t low = block + 8, high = low, step = 8; // the blocks before low all end before x
+				while (high + 8 <= size && big[high + 7] < x) {
+					low = high + 8;
+					high += step;
+					step *= 2;
+				}
+				std::size_t first = (low - block) / 8;
+				std::size_t last = (std::min(high, size - 1) - block) / 8;
+				while (first < last) {
+					const std::size_t mid = (first + last) / 2;
+					const std::size_t start = block + mid * 8;
+					if (start + 8 <= size && big[start + 7] < x)
+						first = mid + 1;
+					else
+						last = mid;
+				}
+				block += first * 8;
+			}
+			if (block + 8 > size) {
+				for (std::size_t j = block; j < size; j++) {
+					if (big[j] == x)
+						return true;
+				}
+				return false;
+			}
+#if defined(_BITUTILS_HAS_AVX2)
+			const __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(big + block));
+			return _mm256_movemask_epi8(_mm256_cmpeq_epi32(lanes, _mm256_set1_epi32((int)x))) != 0;
+#elif defined(_BITUTILS_HAS_SSE2)
+			const __m128i needle = _mm_set1_epi32((int)x);
+			const __m128i low = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(big + block)), needle);
+			const __m128i high = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(big + block + 4)), needle);
+			return _mm_movemask_epi8(_mm_or_si128(low, high)) != 0;
+#else
+			for (std::size_t j = block; j < block + 8; j++) {
+				if (big[j] == x)
+					return true;
+			}
+			return false;
+#endif
+		}
+
+		static std::vector<std::uint32_t> intersect_arrays(const std::vector<std::uint32_t>& left, const std::vector<std::uint32_t>& right) {
+			const std::vector<std::uint32_t>& small = left.size() < right.size() ? left : right;
+			const std::vector<std::uint32_t>& big = left.size() < right.size() ? right : left;
+			std::vector<std::uint32_t> out;
+			if (big.empty())
+				return out;
+			std::size_t block = 0;
+			for (const std::uint32_t x : small) {
+				if (big.back() < x)
+					break;
+				if (find_block(big.data(), big.size(), block, x))
+					out.push_back(x);
+			}
+			return out;
+		}
+
+		static std::vector<std::uint32_t> merge_arrays(const std::vector<std::uint32_t>& left, const std::vector<std::uint32_t>& right, const Op op) {
+			std::vector<std::uint32_t> out;
+			out.reserve(op == _ANDNOT ? left.size() : left.size() + right.size());
+			std::size_t i = 0, j = 0;
+			while (i < left.size() && j < right.size()) {
+				if (left[i] < right[j]) {
+					out.push_back(left[i++]);
+				}
+				else if (right[j] < left[i]) {
+					if (op != _ANDNOT)
+						out.push_back(right[j]);
+					j++;
+				}
+				else {
+					if (op == _OR)
+						out.push_back(left[i]);
+					i++;
+					j++;
+				}
+			}
+			out.insert(out.end(), left.begin() + i, left.end());
+			if (op != _ANDNOT)
+				out.insert(out.end(), right.begin() + j, right.end());
+			return out;
+		}
+
+		static AdaptiveBitset combine(const AdaptiveBitset& left, const AdaptiveBitset& right, const Op op) {
+			if (left.n != right.n)
+				throw std::invalid_argument("The sizes cannot be different.");
+			AdaptiveBitset out(left.n);
+			if (!left.dense && !right.dense) {
+				out.adopt(op == _AND ? intersect_arrays(left.values, right.values) : merge_arrays(left.values, right.values, op));
+				return out;
+			}
+			// An array on the left only needs its indices looked up for these.
+			if ((op == _AND || op == _ANDNOT) && !left.dense) {
+				out.adopt(probe(left, right, op == _AND));
+				return out;
+			}
+			if (op == _AND && !right.dense) {
+				out.adopt(probe(right, left, true));
+				return out;
+			}
+
+			std::vector<std::uint64_t> block = left.dense ? left.words : left.block_of(left.values);
+			const std::vector<std::uint64_t> temp = right.dense ? std::vector<std::uint64_t>() : right.block_of(right.values);
+			const void* const other = right.dense ? right.words.data() : temp.data();
+			switch (op) {
+			case _AND:
+				bitwise_and(block.data(), other, block.data(), left.n);
+				break;
+			case _OR:
+				bitwise_or(block.data(), other, block.data(), left.n);
+				break;
+			case _XOR:
+				bitwise_xor(block.data(), other, block.data(), left.n);
+				break;
+			case _ANDNOT:
+				for (std::size_t k = 0; k < block.size(); k++) {
+					block[k] &= ~((const std::uint64_t*)other)[k];
+				}
+				break;
+			}
+			out.adopt(std::move(block));
+			return out;
+		}
+
+		// The indices of an array that are (or aren't) 1 in the other bit array.
+		static std::vector<std::uint32_t> probe(const AdaptiveBitset& array, const AdaptiveBitset& other, const bool keep) {
+			std::vector<std::uint32_t> out;
+			for (const std::uint32_t i : array.values) {
+				if (other.get(i) == keep)
+					out.push_back(i);
+			}
+			return out;
+		}
+
+		std::size_t n;
+		std::size_t ones = 0;
+		bool dense = false;
+		std::vector<std::uint32_t> values; // while it's sparse
+		std::vector<std::uint64_t> words; // while it's dense
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_ADAPTIVE_H__
@@ -0,0 +1,221 @@
+/* BitUtilsBitap.h
+* Author: Grayson Spidle
+*
+* This file defines Bitap, a bit parallel (Shift-Or, with Wu and Manber's extension for errors) approximate string matcher.
+* Every prefix of the pattern gets a bit, and each character of the text is one shift and a few ANDs/ORs per word of state,
+* so the text is read once no matter how many places a match could start.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_BITAP_H__
+#define __BITUTILS_BITAP_H__
+
+#include "BitUtils.h"
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	/* Finds the places a pattern shows up in a text with at most k errors, where an error is a character that was inserted, deleted or swapped for another
+	* (ie the Levenshtein distance between the pattern and the matching part of the text is at most k). Patterns can be any length; the state is
+	* (k + 1) rows of ceil(m / 64) words that get shifted with the carries going from word to word.
+	*
+	* A match is reported at the index of its last character along with the number of errors, which is the fewest it can be done with.
+	* Matches that end at the same index only get reported once.
+	*/
+	class Bitap {
+	public:
+		/* Makes a matcher for the first m chars of pattern.
+		* Throws std::invalid_argument if m == 0 or k >= m (everything would match).
+		*/
+		Bitap(const char* const pattern, const std::size_t m, const std::size_t k) : m(m), k(k), words((m + 63) / 64) {
+			if (m == 0)
+				throw std::invalid_argument("m cannot be == 0.");
+			if (k >= m)
+				throw std::invalid_argument("k cannot be >= m.");
+			// Shift-Or has it backwards: a 0 is a match. Bit j of char c's mask is 0 if pattern[j] == c.
+			masks.assign(256 * words, ~(std::uint64_t)0);
+			for (std::size_t j = 0; j < m; j++) {
+				masks[(unsigned char)pattern[j] * words + j / 64] &= ~((std::uint64_t)1 << (j % 64));
+			}
+		}
+
+		Bitap(const std::string& pattern, const std::size_t k) : Bitap(pattern.data(), pattern.size(), k) {}
+
+		/* Returns the length of the pattern. */
+		std::size_t size() const {
+			return m;
+		}
+
+		/* Returns the most errors a match can have. */
+		std::size_t errors() const {
+			return k;
+		}
+
+		/* Calls f(i, e) for each index i of the text where a match ends, with e being the number of errors, from lowest to highest.
+		* If f returns something then returning false stops the search. Returns false if f stopped the search early else returns true.
+		*/
+		template < class _F >
+		bool for_each_match(const char* const text, const std::size_t len, _F&& f) const {
+			std::vector<std::uint64_t> scratch;
+			return search(text, len, scratch, f);
+		}
+
+		/* Returns the index where the first match ends, or len if there isn't one. */
+		std::size_t find(const char* const text, const std::size_t len) const {
+			std::size_t found = len;
+			for_each_match(text, len, [&found](const std::size_t i, const std::size_t) {
+				found = i;
+				return false;
+			});
+			return found;
+		}
+
+		std::size_t find(const std::string& text) const {
+			return find(text.data(), text.size());
+		}
+
+		/* Returns every index where a match ends, from lowest to highest. */
+		std::vector<std::size_t> find_all(const char* const text, const std::size_t len) const {
+			std::vector<std::size_t> found;
+			for_each_match(text, len, [&found](const std::size_t i, const std::size_t) {
+				found.push_back(i);
+			});
+			return found;
+		}
+
+		std::vector<std::size_t> find_all(const std::string& text) const {
+			return find_all(text.data(), text.size());
+		}
+
+		/* Returns the number of indices where a match ends. */
+		std::size_t count(const char* const text, const std::size_t len) const {
+			std::size_t found = 0;
+			for_each_match(text, len, [&found](const std::size_t, const std::size_t) {
+				found++;
+			});
+			return found;
+		}
+
+		/* Calls f(t, i, e) for each match in each of the texts, where t is the index of the text. It goes through the texts in order and works like
+		* for_each_match() for each one, except that the state is only allocated once. Returning false from f stops everything.
+		*/
+		template < class _F >
+		bool for_each_match(const std::vector<std::string>& texts, _F&& f) const {
+			std::vector<std::uint64_t> scratch;
+			for (std::size_t t = 0; t < texts.size(); t++) {
+				const bool going = search(texts[t].data(), texts[t].size(), scratch, [&f, t](const std::size_t i, const std::size_t e) {
+					return _visit(f, t, i, e);
+				});
+				if (!going)
+					return false;
+			}
+			return true;
+		}
+
+		/* Returns where the first match ends in each of the texts (or the length of the text if there isn't one). */
+		std::vector<std::size_t> find(const std::vector<std::string>& texts) const {
+			std::vector<std::size_t> found(texts.size());
+			std::vector<std::uint64_t> scratch;
+			for (std::size_t t = 0; t < texts.size(); t++) {
+				found[t] = texts[t].size();
+				search(texts[t].data(), texts[t].size(), scratch, [&found, t](const std::size_t i, const std::size_t) {
+					found[t] = i;
+					return false;
+				});
+			}
+			return found;
+		}
+
+	private:
+		// Runs the text through the state, which lives in scratch so that it can be reused.
+		template < class _F >
+		bool search(const char* const text, const std::size_t len, std::vector<std::uint64_t>& scratch, _F&& f) const {
+			if (words == 1)
+				return search_word(text, len, scratch, f);
+			// rows[d] is the state for d errors and saved holds the row above it from before this char. Both are words long.
+			scratch.assign((k + 2) * words, ~(std::uint64_t)0);
+			std::uint64_t* const rows = scratch.data();
+			std::uint64_t* const saved = rows + (k + 1) * words;
+			for (std::size_t d = 1; d <= k; d++) { // the first d chars of the pattern can be deleted before the text even starts
+				for (std::size_t j = 0; j < d; j++) {
+					rows[d * words + j / 64] &= ~((std::uint64_t)1 << (j % 64));
+				}
+			}
+			const std::size_t top = words - 1;
+			const std::uint64_t last = (std::uint64_t)1 << ((m - 1) % 64);
+
+			for (std::size_t i = 0; i < len; i++) {
+				const std::uint64_t* const mask = masks.data() + (unsigned char)text[i] * words;
+				std::uint64_t* row = rows;
+				// No errors: R = (R << 1) | mask
+				std::uint64_t carry = 0;
+				for (std::size_t w = 0; w < words; w++) {
+					const std::uint64_t old = row[w];
+					saved[w] = old;
+					row[w] = (old << 1 | carry) | mask[w];
+					carry = old >> 63;
+				}
+				// d errors: the same, AND a match with d - 1 errors with one char inserted (above before), deleted (above after, shifted) or swapped (above before, shifted).
+				for (std::size_t d = 1; d <= k; d++) {
+					const std::uint64_t* const above = row;
+					row += words;
+					std::uint64_t carry_row = 0, carry_before = 0, carry_after = 0;
+					for (std::size_t w = 0; w < words; w++) {
+						const std::uint64_t old = row[w];
+						const std::uint64_t before = saved[w];
+						const std::uint64_t after = above[w];
+						saved[w] = old;
+						row[w] = ((old << 1 | carry_row) | mask[w]) & before & (before << 1 | carry_before) & (after << 1 | carry_after);
+						carry_row = old >> 63;
+						carry_before = before >> 63;
+						carry_after = after >> 63;
+					}
+				}
+				for (std::size_t d = 0; d <= k; d++) {
+					if (!(rows[d * words + top] & last)) {
+						if (!_visit(f, i, d))
+							return false;
+						break;
+					}
+				}
+			}
+			return true;
+		}
+
+		// search() for patterns that fit in a word, so there are no carries and the rows don't need to be saved.
+		template < class _F >
+		bool search_word(const char* const text, const std::size_t len, std::vector<std::uint64_t>& scratch, _F&& f) const {
+			scratch.resize(k + 1);
+			std::uint64_t* const rows = scratch.data();
+			for (std::size_t d = 0; d <= k; d++) {
+				rows[d] = ~(std::uint64_t)0 << d;
+			}
+			const std::uint64_t last = (std::uint64_t)1 << (m - 1);
+
+			for (std::size_t i = 0; i < len; i++) {
+				const std::uint64_t mask = masks[(unsigned char)text[i]];
+				std::uint64_t before = rows[0];
+				rows[0] = before << 1 | mask;
+				std::size_t found = (rows[0] & last) ? k + 1 : 0;
+				for (std::size_t d = 1; d <= k; d++) {
+					const std::uint64_t old = rows[d];
+					rows[d] = (old << 1 | mask) & before & (before << 1) & (rows[d - 1] << 1);
+					before = old;
+					if (found > k && !(rows[d] & last))
+						found = d;
+				}
+				if (found <= k && !_visit(f, i, found))
+					return false;
+			}
+			return true;
+		}
+
+		std::size_t m;
+		std::size_t k;
+		std::size_t words; // per row of state
+		std::vector<std::uint64_t> masks; // 256 masks of words words each
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_BITAP_H__
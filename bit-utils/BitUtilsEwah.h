@@ -0,0 +1,411 @@
+/* BitUtilsEwah.h
+* Author: Grayson Spidle
+*
+* This file defines EwahBitmap, a bit array compressed with EWAH (Enhanced Word-Aligned Hybrid) using 64 bit words.
+* The words are either stored as they are (literal words) or, if they're all 0s or all 1s (clean words), counted.
+* Each marker word says how many clean words come next and how many literal words come after those:
+*
+*     bit 0: the state of the clean words
+*     bits 1 to 32: the number of clean words
+*     bits 33 to 63: the number of literal words that follow the marker
+*
+* This is the same layout as the other 64 bit EWAH libraries. A bitmap is built by appending to the end, and the bitwise operations
+* work on the compressed words directly: a run of clean words against anything is handled all at once.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_EWAH_H__
+#define __BITUTILS_EWAH_H__
+
+#include "BitUtils.h"
+#include <algorithm>
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	/* A bit array compressed with EWAH. See the top of this file.
+	*
+	* Bits can only be appended (append(), add()), which suits indexes that only grow. The bitwise operations make new bitmaps
+	* without decompressing either side. Bitmaps of different sizes are treated as if the short one had 0s at the end.
+	*/
+	class EwahBitmap {
+	public:
+		/* Makes an empty bitmap (0 bits). */
+		EwahBitmap() : buffer(1, 0) {}
+
+		/* Makes a bitmap out of the bits in the view. */
+		explicit EwahBitmap(const ConstBitSpan& bits) : EwahBitmap() {
+			append(bits);
+		}
+
+		/* Makes a bitmap out of the first n bits of a memory block. */
+		EwahBitmap(const void* const block, const std::size_t n) : EwahBitmap(ConstBitSpan(block, n)) {}
+
+		/* Makes a bitmap out of the bits [start_bit, end_bit) of a memory block. */
+		EwahBitmap(const void* const block, const std::size_t start_bit, const std::size_t end_bit) : EwahBitmap(ConstBitSpan(block, start_bit, end_bit)) {}
+
+		/* Returns the number of bits. */
+		std::size_t size() const {
+			return n;
+		}
+
+		/* Returns the number of 64 bit words the compressed bitmap takes up (markers included). */
+		std::size_t compressed_words() const {
+			return buffer.size();
+		}
+
+		/* Returns the compressed words. */
+		const std::vector<std::uint64_t>& data() const {
+			return buffer;
+		}
+
+		/* Appends the bits in the view, a word at a time. */
+		void append(const ConstBitSpan& bits) {
+			const std::size_t words = (bits.n + 63) / 64;
+			for (std::size_t k = 0; k < words; k++) {
+				const std::size_t len = _word_len(bits.n, k);
+				push_bits(_load_word(bits, k, len), len);
+			}
+		}
+
+		/* Appends count bits that are all b. Whole clean words are only counted, no matter how many there are. */
+		void append(const bool b, std::size_t count) {
+			const std::uint64_t fill = b ? ~(std::uint64_t)0 : 0;
+			if (n % 64 && count) { // finishing the partial word first
+				const std::size_t len = std::min(count, 64 - n % 64);
+				push_bits(fill, len);
+				count -= len;
+			}
+			add_run(b, count / 64);
+			n += count / 64 * 64;
+			if (count % 64)
+				push_bits(fill, count % 64);
+		}
+
+		/* Appends 0s up to bit i and then sets bit i to 1. Throws std::invalid_argument if i < size() (the bits can't be changed once they're in). */
+		void add(const std::size_t i) {
+			if (i < n)
+				throw std::invalid_argument("i cannot be < size().");
+			append(false, i - n);
+			push_bits(1, 1);
+		}
+
+		/* Returns the number of bits that are 1. */
+		std::size_t count() const {
+			std::size_t total = 0;
+			for (Cursor c(buffer); !c.done();) {
+				if (c.run) {
+					total += c.bit ? c.run * 64 : 0;
+					c.skip_run(c.run);
+				}
+				else {
+					total += popcount(c.next_literal());
+				}
+			}
+			return total;
+		}
+
+		/* Calls f(start, end) for each run of 1s [start, end), from lowest to highest. Runs that go across words (or a clean run) are only reported once.
+		* If f returns something then returning false stops the iteration. Returns false if f stopped the iteration early else returns true.
+		*/
+		template < class _F >
+		bool for_each_run(_F&& f) const {
+			std::size_t begin = 0, end = 0; // the run we're in the middle of, which could keep going
+			const auto add = [&f, &begin, &end](const std::size_t start, const std::size_t stop) {
+				if (start == end && end != begin) {
+					end = stop;
+					return true;
+				}
+				const bool going = end == begin || _visit(f, begin, end);
+				begin = start;
+				end = stop;
+				return going;
+			};
+			std::size_t word = 0;
+			for (Cursor c(buffer); !c.done();) {
+				if (c.run) {
+					if (c.bit && !add(word * 64, (word + c.run) * 64))
+						return false;
+					word += c.run;
+					c.skip_run(c.run);
+				}
+				else {
+					// The literal words are next to each other, so they're a memory block of their own.
+					const std::size_t literals = c.literals;
+					const bool going = BitUtils::for_each_run(ConstBitSpan(buffer.data() + c.literal, literals * 64), [&add, word](const std::size_t start, const std::size_t stop) {
+						return add(word * 64 + start, word * 64 + stop);
+					});
+					if (!going)
+						return false;
+					word += literals;
+					c.skip_literals(literals);
+				}
+			}
+			return end == begin || _visit(f, begin, end);
+		}
+
+		/* Calls f(i) for each bit that is 1, from lowest to highest. f can return a bool like for_each_run(). */
+		template < class _F >
+		bool for_each_set_bit(_F&& f) const {
+			return for_each_run([&f](const std::size_t start, const std::size_t end) {
+				for (std::size_t i = start; i < end; i++) {
+					if (!_visit(f, i))
+						return false;
+				}
+				return true;
+			});
+		}
+
+		/* Writes the bitmap to a view. Bit i of the view gets bit i of the bitmap, and the bits past the end of the bitmap get 0. */
+		void copy_to(const BitSpan& span) const {
+			const std::size_t words = (span.n + 63) / 64;
+			std::size_t word = 0;
+			for (Cursor c(buffer); !c.done() && word < words;) {
+				if (c.run) {
+					const std::size_t run = std::min<std::size_t>(c.run, words - word);
+					BitUtils::fill(BitSpan(span.page, span.shift + word * 64, span.shift + std::min((word + run) * 64, span.n)), c.bit);
+					word += run;
+					c.skip_run(run);
+				}
+				else {
+					_store_word(span, word, _word_len(span.n, word), c.next_literal());
+					word++;
+				}
+			}
+			if (word < words)
+				BitUtils::fill(BitSpan(span.page, span.shift + word * 64, span.shift + span.n), false);
+		}
+
+		/* Writes the bitmap to the first n bits of a memory block. */
+		void copy_to(void* const block, const std::size_t n) const {
+			copy_to(BitSpan(block, n));
+		}
+
+		/* Writes the bitmap to the bits [start_bit, end_bit) of a memory block. */
+		void copy_to(void* const block, const std::size_t start_bit, const std::size_t end_bit) const {
+			copy_to(BitSpan(block, start_bit, end_bit));
+		}
+
+		friend EwahBitmap operator&(const EwahBitmap& left, const EwahBitmap& right) {
+			return combine(left, right, _AND);
+		}
+
+		friend EwahBitmap operator|(const EwahBitmap& left, const EwahBitmap& right) {
+			return combine(left, right, _OR);
+		}
+
+		friend EwahBitmap operator^(const EwahBitmap& left, const EwahBitmap& right) {
+			return combine(left, right, _XOR);
+		}
+
+		/* Two bitmaps are equal if they have the same size and the same bits. The same bits always compress the same way, unless a bitwise operation
+		* left a literal word that's clean, so this compares the bits and not the words.
+		*/
+		friend bool operator==(const EwahBitmap& left, const EwahBitmap& right) {
+			if (left.n != right.n)
+				return false;
+			const EwahBitmap diff = left ^ right;
+			for (Cursor c(diff.buffer); !c.done();) {
+				if (c.run ? c.bit : c.next_literal() != 0)
+					return false;
+				c.skip_run(c.run);
+			}
+			return true;
+		}
+
+		friend bool operator!=(const EwahBitmap& left, const EwahBitmap& right) {
+			return !(left == right);
+		}
+
+	private:
+		enum Op { _AND, _OR, _XOR };
+
+		constexpr static const std::uint64_t _MAX_RUN = ((std::uint64_t)1 << 32) - 1;
+		constexpr static const std::uint64_t _MAX_LITERALS = ((std::uint64_t)1 << 31) - 1;
+
+		static bool running_bit(const std::uint64_t marker) {
+			return marker & 1;
+		}
+
+		static std::uint64_t run_length(const std::uint64_t marker) {
+			return (marker >> 1) & _MAX_RUN;
+		}
+
+		static std::uint64_t literal_count(const std::uint64_t marker) {
+			return marker >> 33;
+		}
+
+		static std::uint64_t make_marker(const bool bit, const std::uint64_t run, const std::uint64_t literals) {
+			return (std::uint64_t)bit | run << 1 | literals << 33;
+		}
+
+		// Reads the words back out: a clean run (run words of bit) or one literal at a time.
+		struct Cursor {
+			const std::vector<std::uint64_t>& buffer;
+			bool bit = false;
+			std::uint64_t run = 0; // clean words left
+			std::uint64_t literals = 0; // literal words left after them
+			std::size_t literal = 0; // the index of the next literal word (or the next marker once they're used up)
+
+			explicit Cursor(const std::vector<std::uint64_t>& buffer) : buffer(buffer) {
+				next_marker();
+			}
+
+			bool done() const {
+				return !run && !literals;
+			}
+
+			void skip_run(const std::uint64_t words) {
+				run -= words;
+				next_marker();
+			}
+
+			void skip_literals(const std::uint64_t words) {
+				literals -= words;
+				literal += (std::size_t)words;
+				next_marker();
+			}
+
+			std::uint64_t next_literal() {
+				const std::uint64_t word = buffer[literal];
+				skip_literals(1);
+				return word;
+			}
+
+			// Moves past the markers that have nothing left (including empty ones) to one that does.
+			void next_marker() {
+				while (!run && !literals && literal < buffer.size()) {
+					const std::uint64_t marker = buffer[literal++];
+					bit = running_bit(marker);
+					run = run_length(marker);
+					literals = literal_count(marker);
+				}
+			}
+		};
+
+		// Appends words clean words of bit. n isn't changed.
+		void add_run(const bool bit, std::uint64_t words) {
+			while (words) {
+				std::uint64_t& marker = buffer[last];
+				if (!literal_count(marker) && (!run_length(marker) || running_bit(marker) == bit) && run_length(marker) < _MAX_RUN) {
+					const std::uint64_t add = std::min(words, _MAX_RUN - run_length(marker));
+					marker = make_marker(bit, run_length(marker) + add, 0);
+					words -= add;
+				}
+				else {
+					last = buffer.size();
+					buffer.push_back(make_marker(bit, 0, 0));
+				}
+			}
+		}
+
+		// Appends a literal word. n isn't changed.
+		void add_literal(const std::uint64_t word) {
+			if (literal_count(buffer[last]) == _MAX_LITERALS) {
+				last = buffer.size();
+				buffer.push_back(0);
+			}
+			buffer[last] += (std::uint64_t)1 << 33;
+			buffer.push_back(word);
+		}
+
+		// Appends a whole word, which is counted if it's clean. n isn't changed.
+		void add_word(const std::uint64_t word) {
+			if (word == 0 || word == ~(std::uint64_t)0)
+				add_run(word != 0, 1);
+			else
+				add_literal(word);
+		}
+
+		// Appends the low len (1 to 64) bits of value. A partial word at the end is always kept as a literal, so it can be added to.
+		void push_bits(std::uint64_t value, std::size_t len) {
+			if (len < 64)
+				value &= ((std::uint64_t)1 << len) - 1;
+			const std::size_t used = n % 64;
+			if (!used) {
+				if (len == 64)
+					add_word(value);
+				else
+					add_literal(value);
+				n += len;
+				return;
+			}
+
+			if (!literal_count(buffer[last])) {
+				// A bitwise operation ended on a partial word that came out as 0s, so it got counted instead. It goes back to being a literal.
+				buffer[last] = make_marker(running_bit(buffer[last]), run_length(buffer[last]) - 1, 0);
+				add_literal(0);
+			}
+			const std::size_t take = std::min(len, 64 - used);
+			buffer.back() |= value << used;
+			n += take;
+			if (n % 64 == 0) { // the word is whole now, so it might be clean
+				const std::uint64_t word = buffer.back();
+				buffer.pop_back();
+				buffer[last] -= (std::uint64_t)1 << 33;
+				add_word(word);
+			}
+			if (take < len)
+				push_bits(value >> take, len - take);
+		}
+
+		static std::uint64_t apply(const Op op, const std::uint64_t left, const std::uint64_t right) {
+			return op == _AND ? left & right : op == _OR ? left | right : left ^ right;
+		}
+
+		static EwahBitmap combine(const EwahBitmap& left, const EwahBitmap& right, const Op op) {
+			EwahBitmap out;
+			Cursor a(left.buffer), b(right.buffer);
+			// Once a side runs out, it's a run of 0s that never ends.
+			const std::uint64_t forever = ~(std::uint64_t)0;
+			while (!a.done() || !b.done()) {
+				const std::uint64_t a_run = a.done() ? forever : a.run;
+				const std::uint64_t b_run = b.done() ? forever : b.run;
+				const bool a_bit = !a.done() && a.bit;
+				const bool b_bit = !b.done() && b.bit;
+				if (a_run && b_run) {
+					const std::uint64_t words = std::min(a_run, b_run);
+					out.add_run(apply(op, a_bit, b_bit) != 0, words);
+					if (!a.done())
+						a.skip_run(words);
+					if (!b.done())
+						b.skip_run(words);
+				}
+				else if (a_run || b_run) {
+					// A clean run against literals: the run either decides the result (0 & x, 1 | x) or the literals go through as they are (or flipped).
+					Cursor& run = a_run ? a : b;
+					Cursor& literals = a_run ? b : a;
+					const bool bit = a_run ? a_bit : b_bit;
+					const std::uint64_t words = std::min(a_run ? a_run : b_run, literals.literals);
+					if ((op == _AND && !bit) || (op == _OR && bit)) {
+						out.add_run(bit, words);
+						literals.skip_literals(words);
+					}
+					else {
+						const std::uint64_t flip = op == _XOR && bit ? ~(std::uint64_t)0 : 0;
+						for (std::uint64_t w = 0; w < words; w++) {
+							out.add_word(literals.next_literal() ^ flip);
+						}
+					}
+					if (!run.done())
+						run.skip_run(words);
+				}
+				else {
+					const std::uint64_t words = std::min(a.literals, b.literals);
+					for (std::uint64_t w = 0; w < words; w++) {
+						out.add_word(apply(op, a.next_literal(), b.next_literal()));
+					}
+				}
+			}
+			out.n = std::max(left.n, right.n);
+			return out;
+		}
+
+		std::vector<std::uint64_t> buffer; // markers and literal words
+		std::size_t last = 0; // the index of the last marker
+		std::size_t n = 0;
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_EWAH_H__
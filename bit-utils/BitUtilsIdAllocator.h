@@ -0,0 +1,188 @@
+/* BitUtilsIdAllocator.h
+* Author: Grayson Spidle
+*
+* This file defines IdAllocator, a lock-free allocator of small integer IDs (connection IDs, slot numbers, etc.) that any number of threads can use at once.
+* The IDs are bits in a memory block (1 is taken), a free one is found with tzcnt on the inverted word, and it's claimed with a CAS on that word.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_ID_ALLOCATOR_H__
+#define __BITUTILS_ID_ALLOCATOR_H__
+
+#include "BitUtils.h"
+#include <atomic>
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	// A small number for the calling thread, handed out in the order threads first ask for one.
+	inline std::size_t _thread_number() {
+		static std::atomic<std::size_t> next(0);
+		static thread_local const std::size_t number = next.fetch_add(1, std::memory_order_relaxed);
+		return number;
+	}
+
+	/* Hands out the IDs [0, n) without a lock. Each thread starts looking at its own spot in the map (a hint, spread out over the map at first and
+	* then wherever it last got or gave back an ID), so threads mostly CAS different words and don't fight over cache lines.
+	*
+	* There's a summary with one bit per word of the map that's set when the word is full, so when a thread's word fills up it skips ahead to the next
+	* word with room, 64 words at a time, instead of walking through full ones.
+	*
+	* acquire() only comes back empty handed when every word it looked at was full. If IDs are being given back while it looks, it can miss one.
+	*/
+	class IdAllocator {
+	public:
+		/* Makes an allocator for the IDs [0, n), all free. Throws std::invalid_argument if n == 0. */
+		explicit IdAllocator(const std::size_t n) : n(n) {
+			if (n == 0)
+				throw std::invalid_argument("n cannot be == 0.");
+			words = (n + 63) / 64;
+			summaries = (words + 63) / 64;
+			bits.assign(words, 0);
+			summary.assign(summaries, 0);
+			// The bits past n are taken for good, and so are the summary bits past the last word.
+			if (n % 64 != 0)
+				bits[words - 1] = ~(std::uint64_t)0 << (n % 64);
+			if (words % 64 != 0)
+				summary[summaries - 1] = ~(std::uint64_t)0 << (words % 64);
+			hints.assign(_SLOTS * _STRIDE, 0);
+			for (std::size_t s = 0; s < _SLOTS; s++) {
+				hints[s * _STRIDE] = s * words / _SLOTS;
+			}
+		}
+
+		IdAllocator(const IdAllocator&) = delete;
+		IdAllocator& operator=(const IdAllocator&) = delete;
+
+		/* Returns the number of IDs (n). */
+		std::size_t capacity() const {
+			return n;
+		}
+
+		/* Takes a free ID and returns it, or returns capacity() if they're all taken. */
+		std::size_t acquire() {
+			std::size_t id;
+			return acquire(&id, 1) == 1 ? id : n;
+		}
+
+		/* Takes up to count free IDs and puts them in ids. The ones in the same word are claimed with one CAS.
+		* Returns the number it got, which is less than count only if it ran out. The ones it got are still taken either way.
+		*/
+		std::size_t acquire(std::size_t* const ids, const std::size_t count) {
+			std::uint64_t* const hint = hints.data() + (_thread_number() % _SLOTS) * _STRIDE;
+			std::size_t w = (std::size_t)_atomic_load(hint, MemoryOrder::RELAXED);
+			std::size_t got = 0;
+			while (got < count) {
+				got += claim(w, ids + got, count - got);
+				if (got == count)
+					break;
+				w = next_open(w + 1);
+				if (w == words)
+					return got;
+			}
+			_atomic_store(hint, w, MemoryOrder::RELAXED);
+			return got;
+		}
+
+		std::vector<std::size_t> acquire(const std::size_t count) {
+			std::vector<std::size_t> ids(count);
+			ids.resize(acquire(ids.data(), count));
+			return ids;
+		}
+
+		/* Gives back an ID so it can be handed out again. The thread's next acquire() starts looking in its word, since it's likely still in cache.
+		* Throws std::out_of_range if id >= capacity() and std::invalid_argument if it isn't taken (ie it was given back twice).
+		*/
+		void release(const std::size_t id) {
+			_validateBounds(n, id);
+			const std::size_t w = id / 64;
+			const std::uint64_t bit = (std::uint64_t)1 << (id % 64);
+			const std::uint64_t old = _atomic_fetch_and(bits.data() + w, ~bit, MemoryOrder::SEQ_CST);
+			if (!(old & bit))
+				throw std::invalid_argument("That ID isn't taken.");
+			if (old == ~(std::uint64_t)0)
+				_atomic_fetch_and(summary.data() + w / 64, ~((std::uint64_t)1 << (w % 64)), MemoryOrder::SEQ_CST);
+			_atomic_store(hints.data() + (_thread_number() % _SLOTS) * _STRIDE, w, MemoryOrder::RELAXED);
+		}
+
+		/* Returns true if the ID is taken. Throws std::out_of_range if id >= capacity(). */
+		bool taken(const std::size_t id) const {
+			_validateBounds(n, id);
+			return (_atomic_load(bits.data() + id / 64, MemoryOrder::ACQUIRE) >> (id % 64)) & 1;
+		}
+
+		/* Returns the number of IDs that are taken. Each word is read at a different time, so it can be off while other threads are using it. */
+		std::size_t count() const {
+			std::size_t ones = 0;
+			for (std::size_t w = 0; w < words; w++) {
+				ones += popcount(_atomic_load(bits.data() + w, MemoryOrder::RELAXED));
+			}
+			return ones - (words * 64 - n);
+		}
+
+	private:
+		constexpr static const std::size_t _SLOTS = 64; // hints, picked by thread
+		constexpr static const std::size_t _STRIDE = 8; // words between hints, so each one has its own cache line
+
+		// Takes up to count of the free bits of word w (the lowest ones) into ids with one CAS. Returns how many it got (0 if the word is full).
+		std::size_t claim(const std::size_t w, std::size_t* const ids, const std::size_t count) {
+			std::uint64_t* const word = bits.data() + w;
+			std::uint64_t expected = _atomic_load(word, MemoryOrder::RELAXED);
+			while (expected != ~(std::uint64_t)0) {
+				std::uint64_t take = 0;
+				std::uint64_t free = ~expected;
+				for (std::size_t j = 0; j < count && free; j++) {
+					take |= free & (0 - free);
+					free &= free - 1;
+				}
+				if (_atomic_compare_exchange(word, expected, expected | take, MemoryOrder::ACQ_REL)) {
+					if ((expected | take) == ~(std::uint64_t)0)
+						mark_full(w);
+					std::size_t got = 0;
+					while (take) {
+						ids[got++] = w * 64 + countr_zero(take);
+						take &= take - 1;
+					}
+					return got;
+				}
+			}
+			// The summary might not know yet (or a mark_full() might have been undone by mistake), and it's cheap to fix it here.
+			mark_full(w);
+			return 0;
+		}
+
+		// Marks word w as full in the summary, then takes the mark back if an ID in it was given back in the meantime. Everything here and in
+		// release() is seq_cst, so either release() sees the mark and clears it, or this sees the release.
+		void mark_full(const std::size_t w) {
+			const std::uint64_t bit = (std::uint64_t)1 << (w % 64);
+			_atomic_fetch_or(summary.data() + w / 64, bit, MemoryOrder::SEQ_CST);
+			if (_atomic_load(bits.data() + w, MemoryOrder::SEQ_CST) != ~(std::uint64_t)0)
+				_atomic_fetch_and(summary.data() + w / 64, ~bit, MemoryOrder::SEQ_CST);
+		}
+
+		// Finds the next word at or after from that the summary says has room, wrapping around to the beginning. Returns words if there isn't one.
+		std::size_t next_open(std::size_t from) const {
+			if (from >= words)
+				from = 0;
+			for (std::size_t j = 0; j <= summaries; j++) { // the first summary word gets looked at twice, for the bits below from
+				const std::size_t s = (from / 64 + j) % summaries;
+				std::uint64_t open = ~_atomic_load(summary.data() + s, MemoryOrder::RELAXED);
+				if (j == 0)
+					open &= ~(std::uint64_t)0 << (from % 64);
+				if (open != 0)
+					return s * 64 + countr_zero(open);
+			}
+			return words;
+		}
+
+		std::size_t n;
+		std::size_t words;
+		std::size_t summaries;
+		std::vector<std::uint64_t> bits; // bit i is ID i, 1 if taken
+		std::vector<std::uint64_t> summary; // bit w is 1 if word w of bits is full
+		std::vector<std::uint64_t> hints; // the word each slot starts looking at, _STRIDE apart
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_ID_ALLOCATOR_H__
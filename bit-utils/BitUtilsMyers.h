@@ -0,0 +1,184 @@
+/* BitUtilsMyers.h
+* Author: Grayson Spidle
+*
+* This file defines Myers, which works out Levenshtein distances with Myers' bit vector algorithm (Hyyro's version for patterns longer than a word).
+* A column of the edit distance table is kept as two bit vectors of +1/-1 steps going down it, so each character of the text only costs a handful
+* of word operations per 64 characters of the pattern instead of a row of the table.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_MYERS_H__
+#define __BITUTILS_MYERS_H__
+
+#include "BitUtils.h"
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	/* The Levenshtein distance from a pattern to other strings, either all of the other string (distance()) or the part of it that's closest (search()).
+	*
+	* The pattern is split into blocks of 64 characters. The additions that would carry from one block into the next are passed along as the
+	* difference between two cells of the table (-1, 0 or +1) instead. When there's a max_k, only the blocks that can still have a cell <= max_k
+	* are worked out (Ukkonen's cut off), so a tight max_k skips most of a long pattern, and banded_distance() gives up as soon as it can't be <= max_k.
+	*/
+	class Myers {
+	public:
+		/* Makes a matcher for the first m chars of pattern. Throws std::invalid_argument if m == 0. */
+		Myers(const char* const pattern, const std::size_t m) : m(m), blocks((m + 63) / 64) {
+			if (m == 0)
+				throw std::invalid_argument("m cannot be == 0.");
+			// Bit j of char c's mask is 1 if pattern[j] == c.
+			masks.assign(256 * blocks, 0);
+			for (std::size_t j = 0; j < m; j++) {
+				masks[(unsigned char)pattern[j] * blocks + j / 64] |= (std::uint64_t)1 << (j % 64);
+			}
+		}
+
+		Myers(const std::string& pattern) : Myers(pattern.data(), pattern.size()) {}
+
+		/* Returns the length of the pattern. */
+		std::size_t size() const {
+			return m;
+		}
+
+		/* Returns the Levenshtein distance between the pattern and the text. */
+		std::size_t distance(const char* const text, const std::size_t len) const {
+			return run(text, len, m > len ? m : len, true).first;
+		}
+
+		/* Returns the Levenshtein distance between the pattern and the text if it's <= max_k, else returns max_k + 1. */
+		std::size_t banded_distance(const char* const text, const std::size_t len, const std::size_t max_k) const {
+			return run(text, len, max_k, true).first;
+		}
+
+		std::size_t distance(const std::string& text) const {
+			return distance(text.data(), text.size());
+		}
+
+		std::size_t banded_distance(const std::string& text, const std::size_t max_k) const {
+			return banded_distance(text.data(), text.size(), max_k);
+		}
+
+		/* Finds the part of the text that is closest to the pattern.
+		*
+		Returns the distance and the index of the last char of the first part of the text that is that close,
+		or (m, len) if the text is empty.
+		*/
+		std::pair<std::size_t, std::size_t> search(const char* const text, const std::size_t len) const {
+			return run(text, len, m, false);
+		}
+
+		/* Works like the other search(), but only cares about distances <= max_k. Returns (max_k + 1, len) if nothing is that close. */
+		std::pair<std::size_t, std::size_t> banded_search(const char* const text, const std::size_t len, const std::size_t max_k) const {
+			return run(text, len, max_k, false);
+		}
+
+		std::pair<std::size_t, std::size_t> search(const std::string& text) const {
+			return search(text.data(), text.size());
+		}
+
+		std::pair<std::size_t, std::size_t> banded_search(const std::string& text, const std::size_t max_k) const {
+			return banded_search(text.data(), text.size(), max_k);
+		}
+
+	private:
+		// A block of 64 rows in the current column. Bit t of P (M) is set if the cell t rows into the block is 1 more (less) than the cell above it.
+		struct Block {
+			std::uint64_t P;
+			std::uint64_t M;
+			std::ptrdiff_t score; // the cell in the block's last row
+		};
+
+		// The number of rows in a block.
+		std::size_t rows(const std::size_t b) const {
+			return b + 1 == blocks ? m - b * 64 : 64;
+		}
+
+		// Moves a block one column to the right. eq is the mask for the block and hin is the step from the cell above the block to the right one (-1, 0 or +1).
+		// Returns the step along the block's last row.
+		static int step(Block& block, std::uint64_t eq, const int hin, const std::size_t last_bit) {
+			const std::uint64_t P = block.P;
+			const std::uint64_t M = block.M;
+			const std::uint64_t hin_negative = hin < 0 ? 1 : 0;
+			const std::uint64_t xv = eq | M;
+			eq |= hin_negative;
+			const std::uint64_t xh = (((eq & P) + P) ^ P) | eq;
+			std::uint64_t ph = M | ~(xh | P);
+			std::uint64_t mh = P & xh;
+			const int hout = (int)((ph >> last_bit) & 1) - (int)((mh >> last_bit) & 1);
+			ph = ph << 1 | (hin > 0 ? 1 : 0);
+			mh = mh << 1 | hin_negative;
+			block.P = mh | ~(xv | ph);
+			block.M = ph & xv;
+			block.score += hout;
+			return hout;
+		}
+
+		// The global (whole text) or semi global (best part of the text) distance, if it's <= max_k.
+		std::pair<std::size_t, std::size_t> run(const char* const text, const std::size_t len, const std::size_t max_k, const bool global) const {
+			const std::pair<std::size_t, std::size_t> none(max_k + 1, len);
+			if (len == 0)
+				return m <= max_k ? std::make_pair(m, len) : none;
+			if (global && (m > len ? m - len : len - m) > max_k) // at least that many inserts/deletes
+				return none;
+
+			// Only the first block when the pattern fits in a word, so nothing to allocate.
+			Block one;
+			std::vector<Block> many;
+			Block* const state = blocks == 1 ? &one : (many.resize(blocks), many.data());
+			std::ptrdiff_t k = (std::ptrdiff_t)max_k;
+			// The first column is the distance from each prefix of the pattern to nothing.
+			std::ptrdiff_t y = (std::ptrdiff_t)(max_k / 64 < blocks - 1 ? max_k / 64 : blocks - 1); // the last block worked out
+			for (std::ptrdiff_t b = 0; b <= y; b++) {
+				state[b].P = ~(std::uint64_t)0;
+				state[b].M = 0;
+				state[b].score = (std::ptrdiff_t)(b * 64 + rows(b));
+			}
+
+			std::pair<std::size_t, std::size_t> best = none;
+			const int top = global ? 1 : 0; // the step along the top row (the empty prefix of the pattern)
+			for (std::size_t i = 0; i < len; i++) {
+				const std::uint64_t* const eq = masks.data() + (unsigned char)text[i] * blocks;
+				int hout = top;
+				for (std::ptrdiff_t b = 0; b <= y; b++) {
+					hout = step(state[b], eq[b], hout, rows(b) - 1);
+				}
+
+				// The block below can have cells <= k now if the block above ended <= k and the step into it could go down.
+				if (y + 1 < (std::ptrdiff_t)blocks && state[y].score - hout <= k && ((eq[y + 1] & 1) || hout < 0)) {
+					y++;
+					state[y].P = ~(std::uint64_t)0;
+					state[y].M = 0;
+					state[y].score = state[y - 1].score - hout + (std::ptrdiff_t)rows(y);
+					step(state[y], eq[y], hout, rows(y) - 1);
+				}
+				else {
+					// Every cell in a block is within 63 of its last one.
+					while (y > (global ? -1 : 0) && state[y].score >= k + 64) {
+						y--;
+					}
+					if (y < 0)
+						return none;
+				}
+
+				if (!global && y + 1 == (std::ptrdiff_t)blocks && state[y].score <= k && (std::size_t)state[y].score < best.first) {
+					best = std::make_pair((std::size_t)state[y].score, i);
+					if (best.first == 0)
+						break;
+					k = state[y].score; // only something closer is interesting now
+				}
+			}
+
+			if (global)
+				return y + 1 == (std::ptrdiff_t)blocks && state[y].score <= k ? std::make_pair((std::size_t)state[y].score, len - 1) : none;
+			return best;
+		}
+
+		std::size_t m;
+		std::size_t blocks;
+		std::vector<std::uint64_t> masks; // 256 masks of blocks words each
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_MYERS_H__
@@ -0,0 +1,834 @@
+/* BitUtilsRoaring.h
+* Author: Grayson Spidle
+*
+* This file defines RoaringBitmap, a compressed set of 32 bit unsigned ints (ie the indices of the set bits in a memory block of up to 2^32 bits).
+* The values are split into chunks of 2^16 by their high 16 bits, and each chunk is kept as whichever is smallest: a sorted array of the low 16 bits,
+* a 2^16 bit memory block, or a list of runs. A sparse or clustered bitmap ends up a lot smaller than its memory block, and the set operations
+* only have to look at the chunks both sides have.
+*
+* serialize() and deserialize() use the portable Roaring format (https://github.com/RoaringBitmap/RoaringFormatSpec), so the bitmaps can be
+* exchanged with the other Roaring libraries.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_ROARING_H__
+#define __BITUTILS_ROARING_H__
+
+#include "BitUtils.h"
+#include <algorithm>
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	/* A compressed set of 32 bit unsigned ints. See the top of this file.
+	*
+	* Each chunk's container is picked again after a set operation or a conversion, but add() and remove() only switch between an array and
+	* a memory block when they have to (at 4096 values). Call optimize() after a lot of them to get the runs back.
+	*/
+	class RoaringBitmap {
+	public:
+		RoaringBitmap() = default;
+
+		/* Makes a bitmap of the indices of the bits in the view that are 1. It goes a 64 bit word at a time, not a bit at a time.
+		* Throws std::invalid_argument if the view has more than 2^32 bits.
+		*/
+		explicit RoaringBitmap(const ConstBitSpan& bits) {
+			if ((std::uint64_t)bits.n > ((std::uint64_t)1 << 32))
+				throw std::invalid_argument("The view cannot have more than 2^32 bits.");
+			const std::size_t words = (bits.n + 63) / 64;
+			std::vector<std::uint64_t> chunk(_CHUNK_WORDS);
+			for (std::size_t first = 0; first < words; first += _CHUNK_WORDS) {
+				bool empty = true;
+				for (std::size_t k = 0; k < _CHUNK_WORDS; k++) {
+					chunk[k] = first + k < words ? _load_word(bits, first + k, _word_len(bits.n, first + k)) : 0;
+					empty = empty && !chunk[k];
+				}
+				if (!empty) {
+					keys.push_back((std::uint16_t)(first / _CHUNK_WORDS));
+					containers.push_back(Container::from_words(chunk.data()));
+				}
+			}
+		}
+
+		/* Makes a bitmap of the indices of the bits in the first n bits of the memory block that are 1. */
+		RoaringBitmap(const void* const block, const std::size_t n) : RoaringBitmap(ConstBitSpan(block, n)) {}
+
+		/* Makes a bitmap of the indices (relative to start_bit) of the bits in [start_bit, end_bit) of the memory block that are 1. */
+		RoaringBitmap(const void* const block, const std::size_t start_bit, const std::size_t end_bit) : RoaringBitmap(ConstBitSpan(block, start_bit, end_bit)) {}
+
+		/* Returns the number of values. */
+		std::uint64_t count() const {
+			std::uint64_t total = 0;
+			for (const Container& container : containers) {
+				total += container.card;
+			}
+			return total;
+		}
+
+		/* Returns true if there aren't any values. */
+		bool empty() const {
+			return containers.empty();
+		}
+
+		/* Returns true if x is in the bitmap. */
+		bool contains(const std::uint32_t x) const {
+			const std::size_t i = find(high(x));
+			return i < keys.size() && keys[i] == high(x) && containers[i].contains(low(x));
+		}
+
+		/* Returns the number of values that are <= x. */
+		std::uint64_t rank(const std::uint32_t x) const {
+			std::uint64_t total = 0;
+			for (std::size_t i = 0; i < keys.size() && keys[i] <= high(x); i++) {
+				total += keys[i] < high(x) ? containers[i].card : containers[i].rank(low(x));
+			}
+			return total;
+		}
+
+		/* Puts x in the bitmap. */
+		void add(const std::uint32_t x) {
+			const std::size_t i = find(high(x));
+			if (i == keys.size() || keys[i] != high(x)) {
+				keys.insert(keys.begin() + i, high(x));
+				containers.insert(containers.begin() + i, Container());
+			}
+			containers[i].add(low(x));
+		}
+
+		/* Takes x out of the bitmap. */
+		void remove(const std::uint32_t x) {
+			const std::size_t i = find(high(x));
+			if (i == keys.size() || keys[i] != high(x))
+				return;
+			containers[i].remove(low(x));
+			if (!containers[i].card) {
+				keys.erase(keys.begin() + i);
+				containers.erase(containers.begin() + i);
+			}
+		}
+
+		/* Puts every value in [start, end) in the bitmap. Throws std::invalid_argument if start > end or end > 2^32. */
+		void add_range(const std::uint64_t start, const std::uint64_t end) {
+			if (start > end || end > ((std::uint64_t)1 << 32))
+				throw std::invalid_argument("The range has to be within [0, 2^32] and start cannot be > end.");
+			std::vector<std::uint64_t> chunk(_CHUNK_WORDS);
+			for (std::uint64_t first = start; first < end;) {
+				const std::uint16_t key = (std::uint16_t)(first >> 16);
+				const std::uint64_t last = std::min(end, ((std::uint64_t)key + 1) << 16); // exclusive
+				const std::size_t i = find(key);
+				if (i == keys.size() || keys[i] != key) {
+					keys.insert(keys.begin() + i, key);
+					containers.insert(containers.begin() + i, Container());
+				}
+				containers[i].to_words(chunk.data());
+				fill(BitSpan(chunk.data(), (std::size_t)(first & 0xFFFF), (std::size_t)(last - ((std::uint64_t)key << 16))), true);
+				containers[i] = Container::from_words(chunk.data());
+				first = last;
+			}
+		}
+
+		/* Picks the smallest container for every chunk again. */
+		void optimize() {
+			std::vector<std::uint64_t> chunk(_CHUNK_WORDS);
+			for (Container& container : containers) {
+				container.to_words(chunk.data());
+				container = Container::from_words(chunk.data());
+			}
+		}
+
+		/* Calls f(x) for each value from lowest to highest.
+		* If f returns something then returning false stops the iteration. Returns false if f stopped the iteration early else returns true.
+		*/
+		template < class _F >
+		bool for_each(_F&& f) const {
+			for (std::size_t i = 0; i < keys.size(); i++) {
+				const std::uint32_t base = (std::uint32_t)keys[i] << 16;
+				const bool going = containers[i].for_each([&f, base](const std::uint32_t x) {
+					return _visit(f, base | x);
+				});
+				if (!going)
+					return false;
+			}
+			return true;
+		}
+
+		/* Writes the bitmap to a view: bit x is 1 if x is in the bitmap, for every x < span.n. Values past the end of the view are left out. */
+		void copy_to(const BitSpan& span) const {
+			BitUtils::fill(span, false);
+			for (std::size_t i = 0; i < keys.size(); i++) {
+				const std::size_t base = (std::size_t)keys[i] << 16;
+				if (base >= span.n)
+					break;
+				const Container& container = containers[i];
+				if (container.kind == Container::BITMAP) {
+					for (std::size_t k = 0; k < _CHUNK_WORDS && base + k * 64 < span.n; k++) {
+						const std::size_t word = base / 64 + k;
+						_store_word(span, word, _word_len(span.n, word), container.words[k]);
+					}
+				}
+				else if (container.kind == Container::RUN) {
+					for (std::size_t r = 0; r < container.data.size(); r += 2) {
+						const std::size_t start = base + container.data[r];
+						const std::size_t end = std::min(start + container.data[r + 1] + 1, span.n);
+						if (start >= end)
+							break;
+						BitUtils::fill(BitSpan(span.page, span.shift + start, span.shift + end), true);
+					}
+				}
+				else {
+					for (const std::uint16_t x : container.data) {
+						if (base + x >= span.n)
+							break;
+						BitUtils::set(span, base + x, true);
+					}
+				}
+			}
+		}
+
+		/* Writes the bitmap to the first n bits of a memory block. */
+		void copy_to(void* const block, const std::size_t n) const {
+			copy_to(BitSpan(block, n));
+		}
+
+		/* Writes the bitmap to the bits [start_bit, end_bit) of a memory block, where value x goes to start_bit + x. */
+		void copy_to(void* const block, const std::size_t start_bit, const std::size_t end_bit) const {
+			copy_to(BitSpan(block, start_bit, end_bit));
+		}
+
+		friend RoaringBitmap operator&(const RoaringBitmap& left, const RoaringBitmap& right) {
+			return combine(left, right, _AND);
+		}
+
+		friend RoaringBitmap operator|(const RoaringBitmap& left, const RoaringBitmap& right) {
+			return combine(left, right, _OR);
+		}
+
+		friend RoaringBitmap operator^(const RoaringBitmap& left, const RoaringBitmap& right) {
+			return combine(left, right, _XOR);
+		}
+
+		/* The values in left that aren't in right (and not). */
+		friend RoaringBitmap operator-(const RoaringBitmap& left, const RoaringBitmap& right) {
+			return combine(left, right, _ANDNOT);
+		}
+
+		RoaringBitmap& operator&=(const RoaringBitmap& other) {
+			return *this = *this & other;
+		}
+
+		RoaringBitmap& operator|=(const RoaringBitmap& other) {
+			return *this = *this | other;
+		}
+
+		RoaringBitmap& operator^=(const RoaringBitmap& other) {
+			return *this = *this ^ other;
+		}
+
+		RoaringBitmap& operator-=(const RoaringBitmap& other) {
+			return *this = *this - other;
+		}
+
+		/* Two bitmaps are equal if they have the same values, no matter which containers they use. */
+		friend bool operator==(const RoaringBitmap& left, const RoaringBitmap& right) {
+			if (left.keys != right.keys)
+				return false;
+			for (std::size_t i = 0; i < left.keys.size(); i++) {
+				if (!Container::equals(left.containers[i], right.containers[i]))
+					return false;
+			}
+			return true;
+		}
+
+		friend bool operator!=(const RoaringBitmap& left, const RoaringBitmap& right) {
+			return !(left == right);
+		}
+
+		/* Returns the number of bytes serialize() makes. */
+		std::size_t serialized_size() const {
+			const bool runs = has_runs();
+			std::size_t size = runs ? 4 + (keys.size() + 7) / 8 : 8;
+			size += keys.size() * 4; // key and cardinality - 1
+			if (!runs || keys.size() >= _NO_OFFSET_THRESHOLD)
+				size += keys.size() * 4;
+			for (const Container& container : containers) {
+				size += container.serialized_size();
+			}
+			return size;
+		}
+
+		/* Writes the bitmap in the portable Roaring format (little endian no matter the machine). */
+		std::vector<unsigned char> serialize() const {
+			std::vector<unsigned char> out;
+			out.reserve(serialized_size());
+			const bool runs = has_runs();
+			if (runs) {
+				put32(out, _COOKIE | (std::uint32_t)(keys.size() - 1) << 16);
+				std::vector<unsigned char> run_bits((keys.size() + 7) / 8, 0);
+				for (std::size_t i = 0; i < keys.size(); i++) {
+					if (containers[i].kind == Container::RUN)
+						run_bits[i / 8] |= (unsigned char)(1 << (i % 8));
+				}
+				out.insert(out.end(), run_bits.begin(), run_bits.end());
+			}
+			else {
+				put32(out, _COOKIE_NO_RUNS);
+				put32(out, (std::uint32_t)keys.size());
+			}
+			for (std::size_t i = 0; i < keys.size(); i++) {
+				put16(out, keys[i]);
+				put16(out, (std::uint16_t)(containers[i].card - 1));
+			}
+			if (!runs || keys.size() >= _NO_OFFSET_THRESHOLD) {
+				std::uint32_t offset = (std::uint32_t)(out.size() + keys.size() * 4);
+				for (const Container& container : containers) {
+					put32(out, offset);
+					offset += (std::uint32_t)container.serialized_size();
+				}
+			}
+			for (const Container& container : containers) {
+				container.serialize(out);
+			}
+			return out;
+		}
+
+		/* Reads a bitmap in the portable Roaring format. Throws std::invalid_argument if the bytes aren't one. */
+		static RoaringBitmap deserialize(const void* const data, const std::size_t size) {
+			Reader in((const unsigned char*)data, size);
+			const std::uint32_t cookie = in.get32();
+			std::size_t count = 0;
+			std::vector<unsigned char> run_bits;
+			if ((cookie & 0xFFFF) == _COOKIE) {
+				count = (cookie >> 16) + 1;
+				run_bits.resize((count + 7) / 8);
+				for (unsigned char& byte : run_bits) {
+					byte = in.get8();
+				}
+			}
+			else if (cookie == _COOKIE_NO_RUNS) {
+				count = in.get32();
+				if (count > _KEYS)
+					throw std::invalid_argument("The bitmap cannot have more than 2^16 containers.");
+			}
+			else {
+				throw std::invalid_argument("That isn't a serialized Roaring bitmap.");
+			}
+
+			RoaringBitmap bitmap;
+			std::vector<std::uint32_t> cards(count);
+			for (std::size_t i = 0; i < count; i++) {
+				const std::uint16_t key = in.get16();
+				if (i > 0 && key <= bitmap.keys.back())
+					throw std::invalid_argument("The keys have to go up.");
+				bitmap.keys.push_back(key);
+				cards[i] = (std::uint32_t)in.get16() + 1;
+			}
+			if (run_bits.empty() || count >= _NO_OFFSET_THRESHOLD)
+				in.skip(count * 4); // the offsets, which we don't need since we read it all in order
+			for (std::size_t i = 0; i < count; i++) {
+				const bool run = !run_bits.empty() && (run_bits[i / 8] >> (i % 8)) & 1;
+				bitmap.containers.push_back(Container::deserialize(in, run, cards[i]));
+			}
+			return bitmap;
+		}
+
+		/* Reads a bitmap in the portable Roaring format. Throws std::invalid_argument if the bytes aren't one. */
+		static RoaringBitmap deserialize(const std::vector<unsigned char>& data) {
+			return deserialize(data.data(), data.size());
+		}
+
+	private:
+		enum Op { _AND, _OR, _XOR, _ANDNOT };
+
+		constexpr static const std::size_t _CHUNK_WORDS = 1024; // 2^16 bits
+		constexpr static const std::uint32_t _MAX_ARRAY = 4096; // past this an array is bigger than a memory block
+		constexpr static const std::size_t _KEYS = (std::size_t)1 << 16;
+		constexpr static const std::uint32_t _COOKIE = 12347;
+		constexpr static const std::uint32_t _COOKIE_NO_RUNS = 12346;
+		constexpr static const std::size_t _NO_OFFSET_THRESHOLD = 4;
+
+		// Reads little endian ints and throws if it runs out of bytes.
+		struct Reader {
+			const unsigned char* data;
+			std::size_t size;
+			std::size_t at = 0;
+
+			Reader(const unsigned char* const data, const std::size_t size) : data(data), size(size) {}
+
+			void skip(const std::size_t bytes) {
+				if (size - at < bytes)
+					throw std::invalid_argument("The serialized bitmap is cut off.");
+				at += bytes;
+			}
+
+			std::uint64_t get(const std::size_t bytes) {
+				skip(bytes);
+				std::uint64_t value = 0;
+				for (std::size_t b = 0; b < bytes; b++) {
+					value |= (std::uint64_t)data[at - bytes + b] << (8 * b);
+				}
+				return value;
+			}
+
+			unsigned char get8() {
+				return (unsigned char)get(1);
+			}
+
+			std::uint16_t get16() {
+				return (std::uint16_t)get(2);
+			}
+
+			std::uint32_t get32() {
+				return (std::uint32_t)get(4);
+			}
+		};
+
+		static void put16(std::vector<unsigned char>& out, const std::uint16_t value) {
+			out.push_back((unsigned char)value);
+			out.push_back((unsigned char)(value >> 8));
+		}
+
+		static void put32(std::vector<unsigned char>& out, const std::uint32_t value) {
+			put16(out, (std::uint16_t)value);
+			put16(out, (std::uint16_t)(value >> 16));
+		}
+
+		// The values of one chunk, as the low 16 bits.
+		struct Container {
+			enum Kind { ARRAY, BITMAP, RUN };
+
+			Kind kind = ARRAY;
+			std::uint32_t card = 0;
+			std::vector<std::uint16_t> data; // ARRAY: the values, sorted. RUN: (start, length - 1) pairs, sorted and not touching.
+			std::vector<std::uint64_t> words; // BITMAP: the memory block
+
+			bool contains(const std::uint16_t x) const {
+				if (kind == BITMAP)
+					return (words[x / 64] >> (x % 64)) & 1;
+				if (kind == ARRAY)
+					return std::binary_search(data.begin(), data.end(), x);
+				const std::size_t r = run_at(x);
+				return r != npos && x - data[r] <= data[r + 1];
+			}
+
+			// The number of values <= x.
+			std::uint32_t rank(const std::uint16_t x) const {
+				if (kind == BITMAP) {
+					std::uint32_t total = 0;
+					for (std::size_t k = 0; k < x / 64; k++) {
+						total += (std::uint32_t)popcount(words[k]);
+					}
+					const std::size_t bit = x % 64;
+					return total + (std::uint32_t)popcount(words[x / 64] & (bit == 63 ? ~(std::uint64_t)0 : ((std::uint64_t)2 << bit) - 1));
+				}
+				if (kind == ARRAY)
+					return (std::uint32_t)(std::upper_bound(data.begin(), data.end(), x) - data.begin());
+				std::uint32_t total = 0;
+				for (std::size_t r = 0; r < data.size() && data[r] <= x; r += 2) {
+					total += std::min<std::uint32_t>(data[r + 1], x - data[r]) + 1;
+				}
+				return total;
+			}
+
+			void add(const std::uint16_t x) {
+				if (kind == RUN) {
+					if (contains(x))
+						return;
+					become_words();
+				}
+				if (kind == BITMAP) {
+					std::uint64_t& word = words[x / 64];
+					card += (std::uint32_t)!((word >> (x % 64)) & 1);
+					word |= (std::uint64_t)1 << (x % 64);
+					if (card <= _MAX_ARRAY) // it was a run container with room to spare
+						become_array();
+					return;
+				}
+				const auto it = std::lower_bound(data.begin(), data.end(), x);
+				if (it != data.end() && *it == x)
+					return;
+				data.insert(it, x);
+				card++;
+				if (card > _MAX_ARRAY)
+					become_words();
+			}
+
+			void remove(const std::uint16_t x) {
+				if (kind == RUN) {
+					if (!contains(x))
+						return;
+					become_words();
+				}
+				if (kind == BITMAP) {
+					std::uint64_t& word = words[x / 64];
+					card -= (std::uint32_t)((word >> (x % 64)) & 1);
+					word &= ~((std::uint64_t)1 << (x % 64));
+					if (card <= _MAX_ARRAY)
+						become_array();
+					return;
+				}
+				const auto it = std::lower_bound(data.begin(), data.end(), x);
+				if (it != data.end() && *it == x) {
+					data.erase(it);
+					card--;
+				}
+			}
+
+			// Calls f(x) for each value from lowest to highest, until f returns false.
+			template < class _F >
+			bool for_each(_F&& f) const {
+				if (kind == BITMAP)
+					return for_each_set_bit(ConstBitSpan(words.data(), _KEYS), [&f](const std::size_t x) {
+						return f((std::uint32_t)x);
+					});
+				if (kind == ARRAY) {
+					for (const std::uint16_t x : data) {
+						if (!f((std::uint32_t)x))
+							return false;
+					}
+					return true;
+				}
+				for (std::size_t r = 0; r < data.size(); r += 2) {
+					for (std::uint32_t x = data[r]; x <= (std::uint32_t)data[r] + data[r + 1]; x++) {
+						if (!f(x))
+							return false;
+					}
+				}
+				return true;
+			}
+
+			// Writes the values to a 2^16 bit memory block.
+			void to_words(std::uint64_t* const out) const {
+				if (kind == BITMAP) {
+					std::copy(words.begin(), words.end(), out);
+					return;
+				}
+				std::fill(out, out + _CHUNK_WORDS, 0);
+				if (kind == ARRAY) {
+					for (const std::uint16_t x : data) {
+						out[x / 64] |= (std::uint64_t)1 << (x % 64);
+					}
+					return;
+				}
+				for (std::size_t r = 0; r < data.size(); r += 2) {
+					BitUtils::fill(BitSpan(out, data[r], (std::size_t)data[r] + data[r + 1] + 1), true);
+				}
+			}
+
+			// Makes the smallest container for a 2^16 bit memory block (run containers only when they're strictly smaller, like the other libraries).
+			static Container from_words(const std::uint64_t* const in) {
+				Container container;
+				std::size_t runs = 0;
+				std::uint64_t carry = 0; // the top bit of the word before
+				for (std::size_t k = 0; k < _CHUNK_WORDS; k++) {
+					container.card += (std::uint32_t)popcount(in[k]);
+					runs += popcount(in[k] & ~(in[k] << 1 | carry)); // the bits that start a run
+					carry = in[k] >> 63;
+				}
+				const std::size_t run_bytes = 2 + 4 * runs;
+				const std::size_t other_bytes = container.card <= _MAX_ARRAY ? 2 * container.card : _CHUNK_WORDS * 8;
+				const ConstBitSpan bits(in, _KEYS);
+				if (run_bytes < other_bytes) {
+					container.kind = RUN;
+					container.data.reserve(2 * runs);
+					for_each_run(bits, [&container](const std::size_t start, const std::size_t end) {
+						container.data.push_back((std::uint16_t)start);
+						container.data.push_back((std::uint16_t)(end - start - 1));
+					});
+				}
+				else if (container.card <= _MAX_ARRAY) {
+					container.data.reserve(container.card);
+					for_each_set_bit(bits, [&container](const std::size_t x) {
+						container.data.push_back((std::uint16_t)x);
+					});
+				}
+				else {
+					container.kind = BITMAP;
+					container.words.assign(in, in + _CHUNK_WORDS);
+				}
+				return container;
+			}
+
+			// Makes the smallest container for sorted values.
+			static Container from_array(std::vector<std::uint16_t>&& values) {
+				std::size_t runs = 0;
+				for (std::size_t i = 0; i < values.size(); i++) {
+					runs += i == 0 || values[i] != values[i - 1] + 1;
+				}
+				if (values.size() <= _MAX_ARRAY && 2 * values.size() <= 2 + 4 * runs) {
+					Container container;
+					container.card = (std::uint32_t)values.size();
+					container.data = std::move(values);
+					return container;
+				}
+				std::vector<std::uint64_t> chunk(_CHUNK_WORDS, 0);
+				for (const std::uint16_t x : values) {
+					chunk[x / 64] |= (std::uint64_t)1 << (x % 64);
+				}
+				return from_words(chunk.data());
+			}
+
+			static bool equals(const Container& left, const Container& right) {
+				if (left.card != right.card)
+					return false;
+				if (left.kind == right.kind)
+					return left.data == right.data && left.words == right.words;
+				std::vector<std::uint64_t> l(_CHUNK_WORDS), r(_CHUNK_WORDS);
+				left.to_words(l.data());
+				right.to_words(r.data());
+				return l == r;
+			}
+
+			static Container combine(const Container& left, const Container& right, const Op op) {
+				if (left.kind == ARRAY && right.kind == ARRAY)
+					return from_array(combine_arrays(left.data, right.data, op));
+				// An array on the left only needs to be checked against the other side for these, whatever it is.
+				if ((op == _AND || op == _ANDNOT) && left.kind == ARRAY)
+					return filter(left, right, op == _AND);
+				if (op == _AND && right.kind == ARRAY)
+					return filter(right, left, true);
+
+				std::vector<std::uint64_t> l(_CHUNK_WORDS), r(_CHUNK_WORDS);
+				left.to_words(l.data());
+				right.to_words(r.data());
+				for (std::size_t k = 0; k < _CHUNK_WORDS; k++) {
+					switch (op) {
+					case _AND: l[k] &= r[k]; break;
+					case _OR: l[k] |= r[k]; break;
+					case _XOR: l[k] ^= r[k]; break;
+					case _ANDNOT: l[k] &= ~r[k]; break;
+					}
+				}
+				return from_words(l.data());
+			}
+
+			// Other than run containers, the format goes by the cardinality to tell an array from a bitmap, so that's what picks the body here too.
+			std::size_t serialized_size() const {
+				if (kind == RUN)
+					return 2 + 2 * data.size();
+				return card <= _MAX_ARRAY ? 2 * card : _CHUNK_WORDS * 8;
+			}
+
+			void serialize(std::vector<unsigned char>& out) const {
+				if (kind == RUN) {
+					put16(out, (std::uint16_t)(data.size() / 2));
+					for (const std::uint16_t x : data) {
+						put16(out, x);
+					}
+				}
+				else if (card <= _MAX_ARRAY) {
+					for_each([&out](const std::uint32_t x) {
+						put16(out, (std::uint16_t)x);
+						return true;
+					});
+				}
+				else {
+					std::vector<std::uint64_t> chunk(_CHUNK_WORDS);
+					to_words(chunk.data());
+					for (const std::uint64_t word : chunk) {
+						put32(out, (std::uint32_t)word);
+						put32(out, (std::uint32_t)(word >> 32));
+					}
+				}
+			}
+
+			static Container deserialize(Reader& in, const bool run, const std::uint32_t card) {
+				Container container;
+				container.card = card;
+				if (run) {
+					container.kind = RUN;
+					const std::size_t runs = in.get16();
+					std::uint32_t total = 0;
+					std::int64_t end = -2; // the last value of the run before
+					for (std::size_t r = 0; r < runs; r++) {
+						const std::uint16_t start = in.get16();
+						const std::uint16_t length = in.get16();
+						if ((std::int64_t)start <= end + 1 || (std::uint32_t)start + length > 0xFFFF)
+							throw std::invalid_argument("The runs have to be in order, apart, and inside the container.");
+						container.data.push_back(start);
+						container.data.push_back(length);
+						total += (std::uint32_t)length + 1;
+						end = (std::int64_t)start + length;
+					}
+					if (total != card)
+						throw std::invalid_argument("The runs don't add up to the cardinality.");
+				}
+				else if (card <= _MAX_ARRAY) {
+					for (std::uint32_t i = 0; i < card; i++) {
+						container.data.push_back(in.get16());
+						if (i > 0 && container.data[i] <= container.data[i - 1])
+							throw std::invalid_argument("The array has to go up.");
+					}
+				}
+				else {
+					container.kind = BITMAP;
+					std::uint32_t total = 0;
+					for (std::size_t k = 0; k < _CHUNK_WORDS; k++) {
+						container.words.push_back(in.get(8));
+						total += (std::uint32_t)popcount(container.words.back());
+					}
+					if (total != card)
+						throw std::invalid_argument("The bitmap doesn't add up to the cardinality.");
+				}
+				return container;
+			}
+
+		private:
+			constexpr static const std::size_t npos = (std::size_t)-1;
+
+			// The index in data of the last run that starts at or before x, or npos.
+			std::size_t run_at(const std::uint16_t x) const {
+				std::size_t low = 0, high = data.size() / 2; // in runs
+				while (low < high) {
+					const std::size_t mid = (low + high) / 2;
+					if (data[2 * mid] <= x)
+						low = mid + 1;
+					else
+						high = mid;
+				}
+				return low == 0 ? npos : 2 * (low - 1);
+			}
+
+			void become_words() {
+				std::vector<std::uint64_t> chunk(_CHUNK_WORDS);
+				to_words(chunk.data());
+				kind = BITMAP;
+				words = std::move(chunk);
+				data.clear();
+			}
+
+			void become_array() {
+				std::vector<std::uint16_t> values;
+				values.reserve(card);
+				for_each([&values](const std::uint32_t x) {
+					values.push_back((std::uint16_t)x);
+					return true;
+				});
+				kind = ARRAY;
+				data = std::move(values);
+				words.clear();
+			}
+
+			// The values of an array that are (or aren't) in the other container.
+			static Container filter(const Container& array, const Container& other, const bool keep) {
+				std::vector<std::uint16_t> values;
+				for (const std::uint16_t x : array.data) {
+					if (other.contains(x) == keep)
+						values.push_back(x);
+				}
+				return from_array(std::move(values));
+			}
+
+			// The index of the first value in [from, values.size()) that is >= x, going 1, 2, 4, ... ahead and then binary searching.
+			static std::size_t gallop(const std::vector<std::uint16_t>& values, std::size_t from, const std::uint16_t x) {
+				std::size_t step = 1;
+				std::size_t high = from;
+				while (high < values.size() && values[high] < x) {
+					from = high + 1;
+					high += step;
+					step *= 2;
+				}
+				return std::lower_bound(values.begin() + from, values.begin() + std::min(high, values.size()), x) - values.begin();
+			}
+
+			static std::vector<std::uint16_t> combine_arrays(const std::vector<std::uint16_t>& left, const std::vector<std::uint16_t>& right, const Op op) {
+				std::vector<std::uint16_t> out;
+				if (op == _AND && (left.size() * 64 < right.size() || right.size() * 64 < left.size())) {
+					// Galloping: the small one is looked up in the big one, which skips most of it.
+					const std::vector<std::uint16_t>& small = left.size() < right.size() ? left : right;
+					const std::vector<std::uint16_t>& big = left.size() < right.size() ? right : left;
+					std::size_t j = 0;
+					for (const std::uint16_t x : small) {
+						j = gallop(big, j, x);
+						if (j == big.size())
+							break;
+						if (big[j] == x)
+							out.push_back(x);
+					}
+					return out;
+				}
+				out.reserve(op == _AND ? std::min(left.size(), right.size()) : op == _ANDNOT ? left.size() : left.size() + right.size());
+				std::size_t i = 0, j = 0;
+				while (i < left.size() && j < right.size()) {
+					if (left[i] < right[j]) {
+						if (op != _AND)
+							out.push_back(left[i]);
+						i++;
+					}
+					else if (right[j] < left[i]) {
+						if (op == _OR || op == _XOR)
+							out.push_back(right[j]);
+						j++;
+					}
+					else {
+						if (op == _AND || op == _OR)
+							out.push_back(left[i]);
+						i++;
+						j++;
+					}
+				}
+				if (op != _AND)
+					out.insert(out.end(), left.begin() + i, left.end());
+				if (op == _OR || op == _XOR)
+					out.insert(out.end(), right.begin() + j, right.end());
+				return out;
+			}
+		};
+
+		static std::uint16_t high(const std::uint32_t x) {
+			return (std::uint16_t)(x >> 16);
+		}
+
+		static std::uint16_t low(const std::uint32_t x) {
+			return (std::uint16_t)x;
+		}
+
+		// The index of the first key that is >= key.
+		std::size_t find(const std::uint16_t key) const {
+			return std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+		}
+
+		bool has_runs() const {
+			for (const Container& container : containers) {
+				if (container.kind == Container::RUN)
+					return true;
+			}
+			return false;
+		}
+
+		static RoaringBitmap combine(const RoaringBitmap& left, const RoaringBitmap& right, const Op op) {
+			RoaringBitmap out;
+			std::size_t i = 0, j = 0;
+			while (i < left.keys.size() || j < right.keys.size()) {
+				if (j == right.keys.size() || (i < left.keys.size() && left.keys[i] < right.keys[j])) {
+					if (op != _AND)
+						out.push(left.keys[i], left.containers[i]);
+					i++;
+				}
+				else if (i == left.keys.size() || right.keys[j] < left.keys[i]) {
+					if (op == _OR || op == _XOR)
+						out.push(right.keys[j], right.containers[j]);
+					j++;
+				}
+				else {
+					Container container = Container::combine(left.containers[i], right.containers[j], op);
+					if (container.card)
+						out.push(left.keys[i], std::move(container));
+					i++;
+					j++;
+				}
+			}
+			return out;
+		}
+
+		void push(const std::uint16_t key, Container container) {
+			keys.push_back(key);
+			containers.push_back(std::move(container));
+		}
+
+		std::vector<std::uint16_t> keys; // the high 16 bits of each chunk, sorted
+		std::vector<Container> containers;
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_ROARING_H__
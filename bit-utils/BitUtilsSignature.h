@@ -0,0 +1,206 @@
+/* BitUtilsSignature.h
+* Author: Grayson Spidle
+*
+* This file defines SignatureIndex, a bit sliced signature index (like BitFunnel) for finding the documents that might have all of a set of terms.
+* Every document gets a Bloom filter like signature, but the signatures are stored sideways: one row of bits per hash slot with one bit per document,
+* so a query is ANDing the rows its terms hash to a word (or 4) at a time.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_SIGNATURE_H__
+#define __BITUTILS_SIGNATURE_H__
+
+#include "BitUtils.h"
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	/* A signature index over a fixed number of documents. A term goes to one row in each of a list of ranks (its treatment), and adding a document
+	* sets its bit in each of the rows of each of its terms.
+	*
+	* A row of rank r has 1 / 2^r as many bits as there are documents, and document d uses bit d % (its size), so the row is like a rank 0 row folded
+	* in on itself r times. Higher rank rows are cheaper (and more of them fit in cache), but they're fuller, so a treatment usually mixes them with a
+	* rank 0 row to keep the false positives down, like { 0, 3, 3 }. Since the rows are a whole number of words, word q of a rank 0 row goes with
+	* word q % (the row's words) of any other rank, so ANDing them never has to spread bits out.
+	*
+	* A query can come back with documents that don't actually have all of the terms (but never misses one that does), so this is a prefilter for
+	* something that checks.
+	*/
+	class SignatureIndex {
+	public:
+		/* Makes an empty index for up to documents documents.
+		*
+		Parameters
+		* documents: the most documents it can hold. It gets rounded up so that every row is a whole number of 4 word chunks.
+		* rows: the number of rows of each rank (rows[r] is the number of rank r rows).
+		* treatment: the rank of each row a term goes to, in order. A term goes to one row of each rank listed, so { 0, 3, 3 } is one rank 0 row and
+		*	two rank 3 rows.
+		*
+		Throws std::invalid_argument if documents == 0, the treatment is empty, one of its ranks is > 16, or it has a rank that there are no rows of.
+		*/
+		SignatureIndex(const std::size_t documents, const std::vector<std::size_t>& rows, const std::vector<std::size_t>& treatment) : rows(rows), treatment(treatment) {
+			if (documents == 0)
+				throw std::invalid_argument("documents cannot be == 0.");
+			if (treatment.empty())
+				throw std::invalid_argument("The treatment cannot be empty.");
+			std::size_t top = 0;
+			for (const std::size_t rank : treatment) {
+				if (rank > 16)
+					throw std::invalid_argument("A rank cannot be > 16.");
+				if (rank >= rows.size() || rows[rank] == 0)
+					throw std::invalid_argument("There are no rows of one of the treatment's ranks.");
+				top = rank > top ? rank : top;
+			}
+			const std::size_t chunk = (std::size_t)256 << top; // 4 words in the smallest row
+			capacity = (documents + chunk - 1) / chunk * chunk;
+			bits.resize(rows.size());
+			for (std::size_t r = 0; r < rows.size(); r++) {
+				bits[r].assign(rows[r] * words(r), 0);
+			}
+		}
+
+		/* Returns the most documents it can hold. */
+		std::size_t capacity_documents() const {
+			return capacity;
+		}
+
+		/* Returns the number of documents that have been added. */
+		std::size_t size() const {
+			return documents;
+		}
+
+		/* Returns the bits of a row (one per document, or one per 2^rank documents folded). Throws std::out_of_range if there isn't a row there. */
+		ConstBitSpan row(const std::size_t rank, const std::size_t i) const {
+			_validateBounds(rows.size(), rank);
+			_validateBounds(rows[rank], i);
+			return ConstBitSpan(bits[rank].data() + i * words(rank), words(rank) * 64);
+		}
+
+		/* Adds a document with count terms and returns its number (they're numbered in the order they're added, from 0).
+		* Throws std::out_of_range if the index is full.
+		*/
+		std::size_t add_document(const std::uint64_t* const terms, const std::size_t count) {
+			if (documents == capacity)
+				throw std::out_of_range("The index is full.");
+			const std::size_t d = documents++;
+			for (std::size_t t = 0; t < count; t++) {
+				for (std::size_t j = 0; j < treatment.size(); j++) {
+					const std::size_t rank = treatment[j];
+					const std::size_t bit = d % (words(rank) * 64);
+					std::uint64_t* const row = bits[rank].data() + slot(terms[t], j) * words(rank);
+					row[bit / 64] |= (std::uint64_t)1 << (bit % 64);
+				}
+			}
+			return d;
+		}
+
+		std::size_t add_document(const std::vector<std::uint64_t>& terms) {
+			return add_document(terms.data(), terms.size());
+		}
+
+		/* Calls f(d) for each document d that might have all count of the terms, from lowest to highest. With no terms, every document matches.
+		* If f returns something then returning false stops the query. Returns false if f stopped the query early else returns true.
+		*/
+		template < class _F >
+		bool for_each_match(const std::uint64_t* const terms, const std::size_t count, _F&& f) const {
+			// The rows to AND, and where each one is in its cycle of words.
+			std::vector<const std::uint64_t*> query;
+			std::vector<std::size_t> sizes;
+			for (std::size_t t = 0; t < count; t++) {
+				for (std::size_t j = 0; j < treatment.size(); j++) {
+					const std::size_t rank = treatment[j];
+					query.push_back(bits[rank].data() + slot(terms[t], j) * words(rank));
+					sizes.push_back(words(rank));
+				}
+			}
+			const std::size_t used = (documents + 63) / 64;
+			for (std::size_t q = 0; q < used; q += 4) {
+				std::uint64_t chunk[4];
+				if (!and_rows(query, sizes, q, chunk))
+					continue;
+				for (std::size_t w = 0; w < 4 && q + w < used; w++) {
+					std::uint64_t word = chunk[w];
+					while (word != 0) {
+						const std::size_t d = (q + w) * 64 + countr_zero(word);
+						if (d >= documents)
+							return true;
+						if (!_visit(f, d))
+							return false;
+						word &= word - 1;
+					}
+				}
+			}
+			return true;
+		}
+
+		template < class _F >
+		bool for_each_match(const std::vector<std::uint64_t>& terms, _F&& f) const {
+			return for_each_match(terms.data(), terms.size(), f);
+		}
+
+		/* Returns the documents that might have all of the terms, from lowest to highest. */
+		std::vector<std::size_t> find(const std::vector<std::uint64_t>& terms) const {
+			std::vector<std::size_t> found;
+			for_each_match(terms, [&found](const std::size_t d) {
+				found.push_back(d);
+			});
+			return found;
+		}
+
+		/* Returns the number of documents that might have all of the terms. */
+		std::size_t count(const std::vector<std::uint64_t>& terms) const {
+			std::size_t found = 0;
+			for_each_match(terms, [&found](const std::size_t) {
+				found++;
+			});
+			return found;
+		}
+
+	private:
+		// Words in a row of the rank.
+		std::size_t words(const std::size_t rank) const {
+			return (capacity >> rank) / 64;
+		}
+
+		// Which row of its rank the term's j-th row is.
+		std::size_t slot(const std::uint64_t term, const std::size_t j) const {
+			const std::uint64_t h = _mix64(term + (j + 1) * 0x9E3779B97F4A7C15ULL);
+			return (std::size_t)(((h >> 32) * rows[treatment[j]]) >> 32);
+		}
+
+		// ANDs words [q, q + 4) of the rows into chunk, stopping as soon as they're all 0. Returns false if they are.
+		static bool and_rows(const std::vector<const std::uint64_t*>& query, const std::vector<std::size_t>& sizes, const std::size_t q, std::uint64_t* const chunk) {
+#if defined(_BITUTILS_HAS_AVX2)
+			__m256i acc = _mm256_set1_epi64x(-1);
+			for (std::size_t i = 0; i < query.size(); i++) {
+				acc = _mm256_and_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query[i] + q % sizes[i])));
+				if (_mm256_testz_si256(acc, acc))
+					return false;
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(chunk), acc);
+			return true;
+#else
+			chunk[0] = chunk[1] = chunk[2] = chunk[3] = ~(std::uint64_t)0;
+			for (std::size_t i = 0; i < query.size(); i++) {
+				const std::uint64_t* const row = query[i] + q % sizes[i];
+				chunk[0] &= row[0];
+				chunk[1] &= row[1];
+				chunk[2] &= row[2];
+				chunk[3] &= row[3];
+				if ((chunk[0] | chunk[1] | chunk[2] | chunk[3]) == 0)
+					return false;
+			}
+			return true;
+#endif
+		}
+
+		std::vector<std::size_t> rows; // per rank
+		std::vector<std::size_t> treatment;
+		std::size_t capacity = 0;
+		std::size_t documents = 0;
+		std::vector<std::vector<std::uint64_t>> bits; // per rank, rows[r] rows of words(r) words each
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_SIGNATURE_H__
@@ -0,0 +1,362 @@
+/* BitUtilsSketch.h
+* Author: Grayson Spidle
+*
+* This file defines LinearCounter and MultiResolutionBitmap, bitmap sketches that estimate how many different keys they've been given.
+* Both are a memory block with one bit set per key, so merging two sketches is bitwise_or() and estimating is counting the 0s.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_SKETCH_H__
+#define __BITUTILS_SKETCH_H__
+
+#include "BitUtils.h"
+#include <cmath>
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	// Linear counting: with z of m bits still 0 after hashing keys into them, there were about m ln(m / z) different keys.
+	// When every bit is 1 there's no telling how many there were past that, so it gives m ln(m), the most it can tell.
+	inline double _linear_count(const std::size_t m, const std::size_t zeros) {
+		return (double)m * std::log((double)m / (double)(zeros == 0 ? 1 : zeros));
+	}
+
+	inline void _put_varint(std::vector<unsigned char>& out, std::uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((unsigned char)value);
+	}
+
+	inline std::uint64_t _get_varint(const unsigned char* const in, const std::size_t size, std::size_t& at) {
+		std::uint64_t value = 0;
+		for (std::size_t shift = 0; shift < 64; shift += 7) {
+			if (at >= size)
+				throw std::invalid_argument("The serialized sketch is cut off.");
+			const unsigned char byte = in[at++];
+			value |= (std::uint64_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return value;
+		}
+		throw std::invalid_argument("That isn't a serialized sketch.");
+	}
+
+	// Writes the bits as whichever is smaller: the raw bytes (a 0 and then ceil(n / 8) bytes), or the gaps between the 1s (a 1, the number of 1s and
+	// then each gap as a varint). Sketches that haven't seen much are mostly 0s, so they come out a lot smaller than their blocks.
+	inline void _serialize_sketch_bits(std::vector<unsigned char>& out, const ConstBitSpan& bits, const std::size_t ones) {
+		std::vector<unsigned char> gaps;
+		std::uint64_t last = 0;
+		const std::size_t raw = (bits.n + 7) / 8;
+		for_each_set_bit(bits, [&](const std::size_t i) {
+			_put_varint(gaps, i - last);
+			last = i;
+			return gaps.size() < raw; // it's already bigger, so don't bother
+		});
+		if (gaps.size() < raw) {
+			out.push_back(1);
+			_put_varint(out, ones);
+			out.insert(out.end(), gaps.begin(), gaps.end());
+			return;
+		}
+		out.push_back(0);
+		for (std::size_t k = 0; k < (bits.n + 63) / 64; k++) {
+			const std::size_t len = _word_len(bits.n, k);
+			const std::uint64_t word = _load_word(bits, k, len);
+			for (std::size_t b = 0; b < (len + 7) / 8; b++) {
+				out.push_back((unsigned char)(word >> (8 * b)));
+			}
+		}
+	}
+
+	// Reads what _serialize_sketch_bits() wrote into bits (which are all 0 to start with), and returns the number of bytes it read.
+	inline std::size_t _deserialize_sketch_bits(const unsigned char* const in, const std::size_t size, std::size_t at, const BitSpan& bits) {
+		if (at >= size)
+			throw std::invalid_argument("The serialized sketch is cut off.");
+		const unsigned char kind = in[at++];
+		if (kind == 1) {
+			const std::uint64_t ones = _get_varint(in, size, at);
+			std::uint64_t i = 0;
+			for (std::uint64_t j = 0; j < ones; j++) {
+				const std::uint64_t gap = _get_varint(in, size, at);
+				if ((j > 0 && gap == 0) || gap >= bits.n - i)
+					throw std::invalid_argument("That isn't a serialized sketch.");
+				i += gap;
+				BitUtils::set(bits, (std::size_t)i, true);
+			}
+			return at;
+		}
+		if (kind != 0)
+			throw std::invalid_argument("That isn't a serialized sketch.");
+		if (size - at < (bits.n + 7) / 8)
+			throw std::invalid_argument("The serialized sketch is cut off.");
+		for (std::size_t k = 0; k < (bits.n + 63) / 64; k++) {
+			const std::size_t len = _word_len(bits.n, k);
+			std::uint64_t word = 0;
+			for (std::size_t b = 0; b < (len + 7) / 8; b++) {
+				word |= (std::uint64_t)in[at++] << (8 * b);
+			}
+			_store_word(bits, k, len, word);
+		}
+		return at;
+	}
+
+	/* A linear counting sketch: each key sets one bit (picked by its hash) of m, and the number of different keys is worked out from how many are
+	* still 0. It's accurate while there are up to a few times m keys, and the error is about 1 / sqrt(m) relative to that.
+	*/
+	class LinearCounter {
+	public:
+		/* Makes an empty sketch of m bits. Throws std::invalid_argument if m == 0 or m > 2^32. */
+		explicit LinearCounter(const std::size_t m) : m(m) {
+			if (m == 0)
+				throw std::invalid_argument("m cannot be == 0.");
+			if ((std::uint64_t)m > ((std::uint64_t)1 << 32))
+				throw std::invalid_argument("m cannot be > 2^32.");
+			words.assign((m + 63) / 64, 0);
+		}
+
+		/* Returns the number of bits. */
+		std::size_t size() const {
+			return m;
+		}
+
+		/* Returns the number of bits that are 1. */
+		std::size_t count() const {
+			return BitUtils::count(ConstBitSpan(words.data(), m));
+		}
+
+		/* Returns the memory block the bits are in, which is size() bits long. */
+		const void* data() const {
+			return words.data();
+		}
+
+		/* Adds a key. */
+		void insert(const std::uint64_t key) {
+			BitUtils::set(words.data(), m, bit(_mix64(key)), true);
+		}
+
+		/* Adds count keys. The bits for a batch of keys are prefetched before any of them are set, so the cache misses overlap. */
+		void insert(const std::uint64_t* const keys, const std::size_t count) {
+			std::size_t bits[_PREFETCH_BATCH];
+			for (std::size_t i = 0; i < count; i += _PREFETCH_BATCH) {
+				const std::size_t len = count - i < _PREFETCH_BATCH ? count - i : _PREFETCH_BATCH;
+				for (std::size_t j = 0; j < len; j++) {
+					bits[j] = bit(_mix64(keys[i + j]));
+					_prefetch((const unsigned char*)words.data() + bits[j] / CHAR_SIZE);
+				}
+				for (std::size_t j = 0; j < len; j++) {
+					BitUtils::set(words.data(), m, bits[j], true);
+				}
+			}
+		}
+
+		/* Returns the estimated number of different keys that have been added. */
+		double estimate() const {
+			return _linear_count(m, m - count());
+		}
+
+		/* Merges another sketch into this one, so it estimates the keys of both. Throws std::invalid_argument if the sizes aren't the same. */
+		LinearCounter& operator|=(const LinearCounter& other) {
+			if (m != other.m)
+				throw std::invalid_argument("The sizes cannot be different.");
+			bitwise_or(words.data(), other.words.data(), words.data(), m);
+			return *this;
+		}
+
+		friend LinearCounter operator|(LinearCounter left, const LinearCounter& right) {
+			return left |= right;
+		}
+
+		friend bool operator==(const LinearCounter& left, const LinearCounter& right) {
+			return left.m == right.m && BitUtils::equals(left.words.data(), right.words.data(), left.m);
+		}
+
+		friend bool operator!=(const LinearCounter& left, const LinearCounter& right) {
+			return !(left == right);
+		}
+
+		/* Writes m and then the bits, either as is or as the gaps between the 1s, whichever is smaller. */
+		std::vector<unsigned char> serialize() const {
+			std::vector<unsigned char> out;
+			_put_varint(out, m);
+			_serialize_sketch_bits(out, ConstBitSpan(words.data(), m), count());
+			return out;
+		}
+
+		/* Reads a sketch made by serialize(). Throws std::invalid_argument if the bytes aren't one. */
+		static LinearCounter deserialize(const void* const data, const std::size_t size) {
+			const unsigned char* const in = (const unsigned char*)data;
+			std::size_t at = 0;
+			const std::uint64_t m = _get_varint(in, size, at);
+			if (m == 0 || m > ((std::uint64_t)1 << 32))
+				throw std::invalid_argument("That isn't a serialized sketch.");
+			LinearCounter sketch((std::size_t)m);
+			if (_deserialize_sketch_bits(in, size, at, BitSpan(sketch.words.data(), sketch.m)) != size)
+				throw std::invalid_argument("The serialized sketch is the wrong size.");
+			return sketch;
+		}
+
+		static LinearCounter deserialize(const std::vector<unsigned char>& data) {
+			return deserialize(data.data(), data.size());
+		}
+
+	private:
+		std::size_t bit(const std::uint64_t h) const {
+			return (std::size_t)(((h >> 32) * m) >> 32);
+		}
+
+		std::size_t m;
+		std::vector<std::uint64_t> words;
+	};
+
+	/* A multi resolution bitmap (Estan, Varghese and Fisk): c linear counting components of b bits each, where component i gets 1 / 2^(i + 1) of the
+	* keys and the last one gets what's left (1 / 2^(c - 1)). The estimate comes from the first component that isn't too full and the ones after it,
+	* which together got 1 / 2^base of the keys, so it stays about as accurate as one component's linear counting over a range of 2^(c - 1) times
+	* more keys, for c times the memory.
+	*
+	* The components are next to each other in one memory block, so merging is a single bitwise_or().
+	*/
+	class MultiResolutionBitmap {
+	public:
+		/* Makes an empty sketch of c components of b bits each. Throws std::invalid_argument if b == 0, b > 2^32, c == 0 or c > 64. */
+		MultiResolutionBitmap(const std::size_t b, const std::size_t c) : b(b), c(c) {
+			if (b == 0)
+				throw std::invalid_argument("b cannot be == 0.");
+			if ((std::uint64_t)b > ((std::uint64_t)1 << 32))
+				throw std::invalid_argument("b cannot be > 2^32.");
+			if (c == 0)
+				throw std::invalid_argument("c cannot be == 0.");
+			if (c > 64)
+				throw std::invalid_argument("c cannot be > 64.");
+			words.assign((b * c + 63) / 64, 0);
+		}
+
+		/* Returns the number of bits in a component. */
+		std::size_t component_size() const {
+			return b;
+		}
+
+		/* Returns the number of components. */
+		std::size_t components() const {
+			return c;
+		}
+
+		/* Returns the number of bits in all of the components. */
+		std::size_t size() const {
+			return b * c;
+		}
+
+		/* Returns the number of bits that are 1 in component i. Throws std::out_of_range if i >= c. */
+		std::size_t count(const std::size_t i) const {
+			_validateBounds(c, i);
+			return BitUtils::count(ConstBitSpan(words.data(), i * b, (i + 1) * b));
+		}
+
+		/* Returns the memory block the components are in (component i is bits [i * b, (i + 1) * b)), which is size() bits long. */
+		const void* data() const {
+			return words.data();
+		}
+
+		/* Adds a key. */
+		void insert(const std::uint64_t key) {
+			BitUtils::set(words.data(), b * c, bit(_mix64(key)), true);
+		}
+
+		/* Adds count keys. The bits for a batch of keys are prefetched before any of them are set, so the cache misses overlap. */
+		void insert(const std::uint64_t* const keys, const std::size_t count) {
+			std::size_t bits[_PREFETCH_BATCH];
+			for (std::size_t i = 0; i < count; i += _PREFETCH_BATCH) {
+				const std::size_t len = count - i < _PREFETCH_BATCH ? count - i : _PREFETCH_BATCH;
+				for (std::size_t j = 0; j < len; j++) {
+					bits[j] = bit(_mix64(keys[i + j]));
+					_prefetch((const unsigned char*)words.data() + bits[j] / CHAR_SIZE);
+				}
+				for (std::size_t j = 0; j < len; j++) {
+					BitUtils::set(words.data(), b * c, bits[j], true);
+				}
+			}
+		}
+
+		/* Returns the estimated number of different keys that have been added. */
+		double estimate() const {
+			std::vector<std::size_t> zeros(c);
+			for (std::size_t i = 0; i < c; i++) {
+				zeros[i] = b - count(i);
+			}
+			// The first component that's at most 7/8 full. If even the last one is fuller than that, it's the best there is.
+			std::size_t base = 0;
+			while (base + 1 < c && zeros[base] < (b + 7) / 8) {
+				base++;
+			}
+			double sum = 0;
+			for (std::size_t i = base; i < c; i++) {
+				sum += _linear_count(b, zeros[i]);
+			}
+			return std::ldexp(sum, (int)base);
+		}
+
+		/* Merges another sketch into this one, so it estimates the keys of both. Throws std::invalid_argument if the shapes aren't the same. */
+		MultiResolutionBitmap& operator|=(const MultiResolutionBitmap& other) {
+			if (b != other.b || c != other.c)
+				throw std::invalid_argument("The sizes cannot be different.");
+			bitwise_or(words.data(), other.words.data(), words.data(), b * c);
+			return *this;
+		}
+
+		friend MultiResolutionBitmap operator|(MultiResolutionBitmap left, const MultiResolutionBitmap& right) {
+			return left |= right;
+		}
+
+		friend bool operator==(const MultiResolutionBitmap& left, const MultiResolutionBitmap& right) {
+			return left.b == right.b && left.c == right.c && BitUtils::equals(left.words.data(), right.words.data(), left.b * left.c);
+		}
+
+		friend bool operator!=(const MultiResolutionBitmap& left, const MultiResolutionBitmap& right) {
+			return !(left == right);
+		}
+
+		/* Writes b, c and then the bits, either as is or as the gaps between the 1s, whichever is smaller. */
+		std::vector<unsigned char> serialize() const {
+			std::vector<unsigned char> out;
+			_put_varint(out, b);
+			_put_varint(out, c);
+			_serialize_sketch_bits(out, ConstBitSpan(words.data(), b * c), BitUtils::count(ConstBitSpan(words.data(), b * c)));
+			return out;
+		}
+
+		/* Reads a sketch made by serialize(). Throws std::invalid_argument if the bytes aren't one. */
+		static MultiResolutionBitmap deserialize(const void* const data, const std::size_t size) {
+			const unsigned char* const in = (const unsigned char*)data;
+			std::size_t at = 0;
+			const std::uint64_t b = _get_varint(in, size, at);
+			const std::uint64_t c = _get_varint(in, size, at);
+			if (b == 0 || c == 0 || c > 64 || b > ((std::uint64_t)1 << 32))
+				throw std::invalid_argument("That isn't a serialized sketch.");
+			MultiResolutionBitmap sketch((std::size_t)b, (std::size_t)c);
+			if (_deserialize_sketch_bits(in, size, at, BitSpan(sketch.words.data(), sketch.b * sketch.c)) != size)
+				throw std::invalid_argument("The serialized sketch is the wrong size.");
+			return sketch;
+		}
+
+		static MultiResolutionBitmap deserialize(const std::vector<unsigned char>& data) {
+			return deserialize(data.data(), data.size());
+		}
+
+	private:
+		// The trailing 0s of the hash pick the component (1 / 2^(i + 1) of the time), so all 64 bits are there for up to 64 components.
+		// Those bits aren't random anymore once the component is picked, so the bit in it comes from mixing the hash again.
+		std::size_t bit(const std::uint64_t h) const {
+			std::size_t i = h == 0 ? c - 1 : countr_zero(h);
+			if (i > c - 1)
+				i = c - 1;
+			return i * b + (std::size_t)(((_mix64(h) >> 32) * b) >> 32);
+		}
+
+		std::size_t b;
+		std::size_t c;
+		std::vector<std::uint64_t> words;
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_SKETCH_H__
@@ -0,0 +1,252 @@
+/* BitUtilsSlidingWindow.h
+* Author: Grayson Spidle
+*
+* This file defines SlidingWindow and AtomicSlidingWindow, bitmaps of which of the last W sequence numbers have been seen (for anti-replay and dedup).
+* The bits live in a ring, so moving the window forward is moving the head and clearing the bits that fell off the back, never shifting the block.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_SLIDING_WINDOW_H__
+#define __BITUTILS_SLIDING_WINDOW_H__
+
+#include "BitUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	// Rounds the window up to a power of 2 (at least a word), so a sequence number's bit is seq & (W - 1). Throws std::invalid_argument if w == 0.
+	inline std::size_t _window_size(const std::size_t w) {
+		if (w == 0)
+			throw std::invalid_argument("w cannot be == 0.");
+		std::size_t size = 64;
+		while (size < w) {
+			size *= 2;
+		}
+		return size;
+	}
+
+	/* Which of the sequence numbers [head - W, head) have been seen. Sequence numbers at or past the head move the window up to them, and ones that
+	* are older than the window can't be told apart from replays, so they count as seen.
+	*/
+	class SlidingWindow {
+	public:
+		/* Makes a window of at least w sequence numbers (rounded up to a power of 2, at least 64) with nothing seen yet.
+		* Throws std::invalid_argument if w == 0.
+		*/
+		explicit SlidingWindow(const std::size_t w) : w(_window_size(w)), words(this->w / 64, 0) {}
+
+		/* Returns the number of sequence numbers in the window (W). */
+		std::size_t size() const {
+			return w;
+		}
+
+		/* Returns one past the newest sequence number in the window. The window is [head - W, head). */
+		std::uint64_t head() const {
+			return top;
+		}
+
+		/* Returns true if seq was seen or if it's too old for the window to know (either way it should be treated as a replay). */
+		bool seen(const std::uint64_t seq) const {
+			if (seq + w < top) // seq < top - W
+				return true;
+			if (seq >= top)
+				return false;
+			return (words[(seq & (w - 1)) / 64] >> (seq % 64)) & 1;
+		}
+
+		/* Marks seq as seen, moving the window up to it first if it's at or past the head.
+		* Returns what seen() would have returned before, so false means seq is new.
+		*/
+		bool test_and_set(const std::uint64_t seq) {
+			if (seq + w < top)
+				return true;
+			if (seq >= top)
+				advance_to(seq);
+			std::uint64_t& word = words[(seq & (w - 1)) / 64];
+			const std::uint64_t bit = (std::uint64_t)1 << (seq % 64);
+			const bool was = (word & bit) != 0;
+			word |= bit;
+			return was;
+		}
+
+		/* Moves the window up so that seq is the newest sequence number in it. Only the bits that fall off the back get cleared.
+		* Does nothing if seq is already in the window.
+		*/
+		void advance_to(const std::uint64_t seq) {
+			if (seq < top)
+				return;
+			const std::uint64_t from = top;
+			top = seq + 1;
+			if (top - from >= w) {
+				std::fill(words.begin(), words.end(), 0);
+				return;
+			}
+			// The bits for [from, top) are the ones that held [from - W, top - W).
+			const std::size_t start = (std::size_t)(from & (w - 1));
+			const std::size_t len = (std::size_t)(top - from);
+			const std::size_t first = len < w - start ? len : w - start;
+			BitUtils::fill(BitSpan(words.data(), start, start + first), false);
+			if (first < len)
+				BitUtils::fill(BitSpan(words.data(), 0, len - first), false);
+		}
+
+		/* Returns the number of sequence numbers in the window that have been seen. */
+		std::size_t count() const {
+			return BitUtils::count(ConstBitSpan(words.data(), w));
+		}
+
+		/* Returns the oldest sequence number in the window that hasn't been seen, or head() if they all have been. */
+		std::uint64_t find_first_missing() const {
+			std::uint64_t at = top > w ? top - w : 0;
+			while (at < top) {
+				const std::size_t shift = (std::size_t)(at % 64);
+				const std::uint64_t left = top - at;
+				const std::size_t len = left < 64 - shift ? (std::size_t)left : 64 - shift;
+				const std::uint64_t mask = len == 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << len) - 1;
+				const std::uint64_t missing = ~(words[(at & (w - 1)) / 64] >> shift) & mask;
+				if (missing != 0)
+					return at + countr_zero(missing);
+				at += len;
+			}
+			return top;
+		}
+
+	private:
+		std::size_t w;
+		std::uint64_t top = 0;
+		std::vector<std::uint64_t> words; // seq's bit is seq & (W - 1)
+	};
+
+	/* A SlidingWindow that any number of threads can use at once without a lock.
+	*
+	* Moving the window is done in two steps: a thread claims a range of new sequence numbers by moving the head with a CAS, clears the bits they're
+	* going to use, and then marks them as cleared (in the order they were claimed). Setting a bit in a range waits for it to be cleared, so a bit
+	* that was set is never lost to a clear. The only race left is a thread setting a bit for a sequence number that falls out of the window while it's
+	* doing it; that sequence number is reported as seen, and the bit can make its replacement (seq + W) look seen too. So when it's wrong it's wrong by
+	* rejecting something (it fails closed), never by letting a replay through.
+	*
+	* count() and find_first_missing() are snapshots. They can be off while other threads are moving the window.
+	*/
+	class AtomicSlidingWindow {
+	public:
+		/* Makes a window of at least w sequence numbers (rounded up to a power of 2, at least 64) with nothing seen yet.
+		* Throws std::invalid_argument if w == 0.
+		*/
+		explicit AtomicSlidingWindow(const std::size_t w) : w(_window_size(w)), words(new std::atomic<std::uint64_t>[this->w / 64]) {
+			for (std::size_t k = 0; k < this->w / 64; k++) {
+				words[k].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		AtomicSlidingWindow(const AtomicSlidingWindow&) = delete;
+		AtomicSlidingWindow& operator=(const AtomicSlidingWindow&) = delete;
+
+		/* Returns the number of sequence numbers in the window (W). */
+		std::size_t size() const {
+			return w;
+		}
+
+		/* Returns one past the newest sequence number in the window. The window is [head - W, head). */
+		std::uint64_t head() const {
+			return top.load();
+		}
+
+		/* Returns true if seq was seen or if it's too old for the window to know (either way it should be treated as a replay). */
+		bool seen(const std::uint64_t seq) const {
+			if (seq + w < top.load())
+				return true;
+			if (seq >= cleared.load())
+				return false;
+			return (words[(seq & (w - 1)) / 64].load() >> (seq % 64)) & 1;
+		}
+
+		/* Marks seq as seen, moving the window up to it first if it's at or past the head.
+		* Returns true if seq was already seen (or is too old to tell), so false means seq is new and this thread is the one that got it.
+		*/
+		bool test_and_set(const std::uint64_t seq) {
+			if (seq + w < top.load())
+				return true;
+			advance_to(seq);
+			while (cleared.load() <= seq) {
+				std::this_thread::yield();
+			}
+			const std::uint64_t bit = (std::uint64_t)1 << (seq % 64);
+			const bool was = (words[(seq & (w - 1)) / 64].fetch_or(bit) & bit) != 0;
+			// If the window moved past it in the meantime, the bit might have been cleared first (or might now belong to seq + W).
+			if (seq + w < top.load())
+				return true;
+			return was;
+		}
+
+		/* Moves the window up so that seq is the newest sequence number in it. Only the bits that fall off the back get cleared.
+		* Does nothing if seq is already in the window.
+		*/
+		void advance_to(const std::uint64_t seq) {
+			std::uint64_t from = top.load();
+			while (from <= seq) {
+				if (top.compare_exchange_weak(from, seq + 1)) {
+					clear(from, seq + 1);
+					// The ranges claimed before this one have to be marked as cleared first.
+					while (cleared.load() != from) {
+						std::this_thread::yield();
+					}
+					cleared.store(seq + 1);
+					return;
+				}
+			}
+		}
+
+		/* Returns the number of sequence numbers in the window that have been seen. */
+		std::size_t count() const {
+			std::size_t ones = 0;
+			for (std::size_t k = 0; k < w / 64; k++) {
+				ones += popcount(words[k].load(std::memory_order_relaxed));
+			}
+			return ones;
+		}
+
+		/* Returns the oldest sequence number in the window that hasn't been seen, or head() if they all have been. */
+		std::uint64_t find_first_missing() const {
+			const std::uint64_t end = cleared.load();
+			std::uint64_t at = end > w ? end - w : 0;
+			while (at < end) {
+				const std::size_t shift = (std::size_t)(at % 64);
+				const std::uint64_t left = end - at;
+				const std::size_t len = left < 64 - shift ? (std::size_t)left : 64 - shift;
+				const std::uint64_t mask = len == 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << len) - 1;
+				const std::uint64_t missing = ~(words[(at & (w - 1)) / 64].load() >> shift) & mask;
+				if (missing != 0)
+					return at + countr_zero(missing);
+				at += len;
+			}
+			return end;
+		}
+
+	private:
+		// Clears the bits for [from, to), a word at a time. The bits around them in the edge words are someone else's, so it's an atomic AND.
+		void clear(std::uint64_t from, const std::uint64_t to) {
+			if (to - from > w)
+				from = to - w;
+			while (from < to) {
+				const std::size_t shift = (std::size_t)(from % 64);
+				const std::uint64_t left = to - from;
+				const std::size_t len = left < 64 - shift ? (std::size_t)left : 64 - shift;
+				const std::uint64_t mask = (len == 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << len) - 1) << shift;
+				words[(from & (w - 1)) / 64].fetch_and(~mask);
+				from += len;
+			}
+		}
+
+		std::size_t w;
+		std::unique_ptr<std::atomic<std::uint64_t>[]> words; // seq's bit is seq & (W - 1)
+		std::atomic<std::uint64_t> top{ 0 }; // claimed
+		std::atomic<std::uint64_t> cleared{ 0 }; // every bit below this is ready to be set
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_SLIDING_WINDOW_H__
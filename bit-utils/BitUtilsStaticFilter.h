@@ -0,0 +1,385 @@
+/* BitUtilsStaticFilter.h
+* Author: Grayson Spidle
+*
+* This file defines XorFilter and RibbonFilter, filters for a set of keys that never changes. Like a Bloom filter they can say a key is in the set
+* when it isn't (about 1 in 2^r of the time for r bit fingerprints) but never the other way around. They're built by solving a system of equations
+* over GF(2), so they only need about 1.23 r (XorFilter) or 1.1 to 1.2 r (RibbonFilter, more for bigger sets) bits per key where a Bloom filter needs 1.44 r.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_STATIC_FILTER_H__
+#define __BITUTILS_STATIC_FILTER_H__
+
+#include "BitUtils.h"
+#include <algorithm>
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	// The key mixed with a seed. Different keys never get the same hash with the same seed.
+	inline std::uint64_t _filter_hash(const std::uint64_t key, const std::uint64_t seed) {
+		return _mix64(key + seed * 0x9E3779B97F4A7C15ULL);
+	}
+
+	// Maps a 32 bit hash to [0, n) by multiplying instead of %.
+	inline std::size_t _filter_reduce(const std::uint32_t h, const std::size_t n) {
+		return (std::size_t)(((std::uint64_t)h * n) >> 32);
+	}
+
+	inline void _validate_fingerprint_bits(const std::size_t bits) {
+		if (bits == 0)
+			throw std::invalid_argument("bits cannot be == 0.");
+		if (bits > 32)
+			throw std::invalid_argument("bits cannot be > 32.");
+	}
+
+	/* A filter where each key is an r bit fingerprint that has to equal the XOR of three slots, one from each third of the table.
+	* The table has about 1.23 slots per key, and it's built by peeling: a slot only one key uses can be given to that key last, which takes it out
+	* of the other two slots' counts, and so on until every key has its own slot. The slots are packed next to each other in a memory block.
+	*
+	* The keys are split into partitions of about 2^14 keys, each with its own table (one after the other in the block) and its own seed, and each
+	* one is peeled on its own. That keeps everything the peeling touches in cache, and a partition that fails to peel only has to redo itself, so
+	* the build time grows linearly with the number of keys. Besides the table, a build only needs a copy of the keys and a few hundred KB.
+	*
+	* A lookup is two hashes (one for the partition and one for the slots) and three loads. Duplicate keys are fine.
+	*/
+	class XorFilter {
+	public:
+		/* Builds a filter for n keys with fingerprints of the given number of bits. Throws std::invalid_argument if bits is 0 or > 32. */
+		XorFilter(const std::uint64_t* const keys, const std::size_t n, const std::size_t bits) : bits(bits) {
+			_validate_fingerprint_bits(bits);
+			// Sorting the keys by partition (a counting sort, so it's linear). Afterwards partition p's keys end where partition p + 1's start, at ends[p].
+			partitions.resize(n / _PARTITION_KEYS + 1);
+			std::vector<std::size_t> ends(partitions.size() + 1, 0);
+			for (std::size_t i = 0; i < n; i++) {
+				ends[partition(keys[i]) + 1]++;
+			}
+			for (std::size_t p = 0; p < partitions.size(); p++) {
+				ends[p + 1] += ends[p];
+			}
+			std::vector<std::uint64_t> sorted(n);
+			for (std::size_t i = 0; i < n; i++) {
+				sorted[ends[partition(keys[i])]++] = keys[i];
+			}
+
+			// The table grows a partition at a time, and it's only bigger than this if a partition had to grow.
+			table.reserve((std::size_t)((1.23 * (double)n + 32 * (double)partitions.size()) * (double)bits) / 64 + 1);
+			Scratch scratch;
+			std::size_t begin = 0;
+			for (std::size_t p = 0; p < partitions.size(); p++) {
+				std::uint64_t* const first = sorted.data() + begin;
+				std::size_t unique = ends[p] - begin;
+				begin = ends[p];
+
+				Partition& part = partitions[p];
+				part.start = slots_used;
+				std::size_t capacity = 32 + (std::size_t)(1.23 * (double)unique + 1);
+				for (std::size_t tries = 1;; tries++) {
+					part.third = capacity / 3;
+					if (build(part, first, unique, scratch))
+						break;
+					// Peeling can never get past two keys that are the same. Sorting is the slowest part of a build, so it's only done once it has failed.
+					if (tries == 1) {
+						std::sort(first, first + unique);
+						const std::size_t before = unique;
+						unique = (std::size_t)(std::unique(first, first + unique) - first);
+						if (unique != before) {
+							capacity = 32 + (std::size_t)(1.23 * (double)unique + 1);
+							continue;
+						}
+					}
+					part.seed++;
+					if (tries % 8 == 0) // it's really unlikely to fail this often at the right size, but better to be safe than to spin
+						capacity += capacity / 10;
+				}
+				count += unique;
+				slots_used += part.third * 3;
+			}
+		}
+
+		XorFilter(const std::vector<std::uint64_t>& keys, const std::size_t bits) : XorFilter(keys.data(), keys.size(), bits) {}
+
+		/* Returns false if the key isn't in the set, and true if it is (or if it's a false positive). */
+		bool contains(const std::uint64_t key) const {
+			const Partition& part = partitions[partition(key)];
+			const std::uint64_t h = _filter_hash(key, part.seed);
+			std::size_t at[3];
+			slots(part, h, at);
+			return fingerprint(h) == (load(at[0]) ^ load(at[1]) ^ load(at[2]));
+		}
+
+		/* Returns the number of different keys. */
+		std::size_t keys() const {
+			return count;
+		}
+
+		/* Returns the number of bits in a fingerprint. */
+		std::size_t fingerprint_bits() const {
+			return bits;
+		}
+
+		/* Returns the number of bits the slots take up. */
+		std::size_t size() const {
+			return slots_used * bits;
+		}
+
+		/* Returns the memory block the slots are packed into, which is size() bits long. */
+		const void* data() const {
+			return table.data();
+		}
+
+	private:
+		constexpr static const std::size_t _PARTITION_KEYS = (std::size_t)1 << 14; // so peeling one takes a few hundred KB of scratch
+
+		struct Partition {
+			std::size_t start = 0; // its first slot in the table
+			std::size_t third = 0; // slots in each third of its table
+			std::uint64_t seed = 1; // 0 is what picks the partition
+		};
+
+		// For each slot of the partition being peeled, the number of keys in it and the XOR of their hashes (which is the hash of the key once
+		// there's only one left). They're kept from one partition to the next so they only get allocated once.
+		struct Scratch {
+			std::vector<std::uint32_t> counts;
+			std::vector<std::uint64_t> hashes;
+			std::vector<std::uint32_t> ready;
+			std::vector<std::pair<std::uint64_t, std::uint32_t>> peeled; // each key's hash and the slot it gets
+		};
+
+		std::size_t partition(const std::uint64_t key) const {
+			return _filter_reduce((std::uint32_t)(_filter_hash(key, 0) >> 32), partitions.size());
+		}
+
+		std::uint32_t fingerprint(const std::uint64_t h) const {
+			return (std::uint32_t)((h ^ (h >> 32)) & (((std::uint64_t)1 << bits) - 1));
+		}
+
+		// The three slots of the hash, counted from the start of the partition's table.
+		static void local_slots(const Partition& part, const std::uint64_t h, std::size_t* const at) {
+			at[0] = _filter_reduce((std::uint32_t)h, part.third);
+			at[1] = _filter_reduce((std::uint32_t)(h >> 21 | h << 43), part.third) + part.third;
+			at[2] = _filter_reduce((std::uint32_t)(h >> 42 | h << 22), part.third) + 2 * part.third;
+		}
+
+		static void slots(const Partition& part, const std::uint64_t h, std::size_t* const at) {
+			local_slots(part, h, at);
+			at[0] += part.start;
+			at[1] += part.start;
+			at[2] += part.start;
+		}
+
+		std::uint32_t load(const std::size_t slot) const {
+			const unsigned char* const page = (const unsigned char*)table.data() + slot * bits / CHAR_SIZE;
+			return (std::uint32_t)_load_bits(page, slot * bits % CHAR_SIZE, bits);
+		}
+
+		void store(const std::size_t slot, const std::uint32_t value) {
+			unsigned char* const page = (unsigned char*)table.data() + slot * bits / CHAR_SIZE;
+			_store_bits(page, slot * bits % CHAR_SIZE, bits, value);
+		}
+
+		// Tries to peel a partition's keys with its current seed and size, and fills in its table if it can. Returns false if some keys couldn't be peeled.
+		bool build(const Partition& part, const std::uint64_t* const keys, const std::size_t n, Scratch& scratch) {
+			const std::size_t size = part.third * 3;
+			scratch.counts.assign(size, 0);
+			scratch.hashes.assign(size, 0);
+			std::size_t at[3];
+			for (std::size_t i = 0; i < n; i++) {
+				const std::uint64_t h = _filter_hash(keys[i], part.seed);
+				local_slots(part, h, at);
+				for (const std::size_t slot : at) {
+					scratch.counts[slot]++;
+					scratch.hashes[slot] ^= h;
+				}
+			}
+
+			scratch.ready.clear();
+			for (std::size_t slot = 0; slot < size; slot++) {
+				if (scratch.counts[slot] == 1)
+					scratch.ready.push_back((std::uint32_t)slot);
+			}
+			scratch.peeled.clear();
+			while (!scratch.ready.empty()) {
+				const std::size_t slot = scratch.ready.back();
+				scratch.ready.pop_back();
+				if (scratch.counts[slot] != 1) // the key was peeled from another slot since
+					continue;
+				const std::uint64_t h = scratch.hashes[slot];
+				scratch.peeled.push_back(std::make_pair(h, (std::uint32_t)slot));
+				local_slots(part, h, at);
+				for (const std::size_t other : at) {
+					scratch.counts[other]--;
+					scratch.hashes[other] ^= h;
+					if (scratch.counts[other] == 1)
+						scratch.ready.push_back((std::uint32_t)other);
+				}
+			}
+			if (scratch.peeled.size() != n)
+				return false;
+
+			// The last key peeled has all three of its slots to itself, so it goes first, and so on back up.
+			table.resize(((part.start + size) * bits + 63) / 64, 0);
+			for (std::size_t i = scratch.peeled.size(); i-- > 0;) {
+				const std::uint64_t h = scratch.peeled[i].first;
+				slots(part, h, at);
+				store(part.start + scratch.peeled[i].second, fingerprint(h) ^ load(at[0]) ^ load(at[1]) ^ load(at[2]));
+			}
+			return true;
+		}
+
+		std::size_t bits;
+		std::size_t count = 0;
+		std::size_t slots_used = 0; // in all of the partitions
+		std::vector<Partition> partitions;
+		std::vector<std::uint64_t> table;
+	};
+
+	/* A standard Ribbon filter with a width of 64. Each key gets a random 64 bit row of coefficients that starts at a random slot, and its r bit
+	* fingerprint has to equal the parity of (row & the 64 slots starting there) for each of r columns of bits. Since the rows are a band down the
+	* diagonal, the system can be solved with Gaussian elimination that only ever XORs one word into another: a row that lands on a slot that's taken
+	* gets the row in that slot XORed out of it and moves to its new first 1. The rows are sorted by where they start first, so the elimination walks
+	* through memory in order.
+	*
+	* The solution is stored in blocks of 64 slots, with the r columns of a block next to each other as words, so a lookup is two blocks next to each
+	* other and r ANDs and popcounts. Duplicate keys are fine.
+	*/
+	class RibbonFilter {
+	public:
+		/* Builds a filter for n keys with fingerprints of the given number of bits. Throws std::invalid_argument if bits is 0 or > 32. */
+		RibbonFilter(const std::uint64_t* const keys, const std::size_t n, const std::size_t bits) : bits(bits), count(n) {
+			_validate_fingerprint_bits(bits);
+			// A row can only go wrong by running off the end of its band, which gets more likely the more rows there are, so bigger sets get a
+			// little more room: 10% up to 2^20 keys and 0.7% more for each doubling after that.
+			const std::size_t doublings = n >> 20 == 0 ? 0 : 63 - countl_zero((std::uint64_t)(n >> 20));
+			std::size_t slots = n + (std::size_t)((double)n * (0.1 + 0.007 * (double)doublings)) + 64;
+			for (std::size_t tries = 1;; tries++) {
+				blocks = (slots + 63) / 64;
+				if (build(keys, n))
+					break;
+				seed++;
+				if (tries % 4 == 0)
+					slots += slots / 20;
+			}
+		}
+
+		RibbonFilter(const std::vector<std::uint64_t>& keys, const std::size_t bits) : RibbonFilter(keys.data(), keys.size(), bits) {}
+
+		/* Returns false if the key isn't in the set, and true if it is (or if it's a false positive). */
+		bool contains(const std::uint64_t key) const {
+			const Row row = make_row(_filter_hash(key, seed));
+			const std::uint64_t* const first = solution.data() + row.start / 64 * bits;
+			const std::size_t shift = row.start % 64;
+			std::uint32_t result = 0;
+			for (std::size_t j = 0; j < bits; j++) {
+				std::uint64_t window = first[j] >> shift;
+				if (shift != 0)
+					window |= first[bits + j] << (64 - shift);
+				result |= (std::uint32_t)(popcount(window & row.coefficients) & 1) << j;
+			}
+			return result == row.fingerprint;
+		}
+
+		/* Returns the number of keys it was built with. */
+		std::size_t keys() const {
+			return count;
+		}
+
+		/* Returns the number of bits in a fingerprint. */
+		std::size_t fingerprint_bits() const {
+			return bits;
+		}
+
+		/* Returns the number of bits the solution takes up. */
+		std::size_t size() const {
+			return blocks * 64 * bits;
+		}
+
+		/* Returns the memory block the solution is in, which is size() bits long. */
+		const void* data() const {
+			return solution.data();
+		}
+
+	private:
+		struct Row {
+			std::size_t start;
+			std::uint64_t coefficients; // bit t is for slot start + t, and bit 0 is always 1
+			std::uint32_t fingerprint;
+		};
+
+		Row make_row(const std::uint64_t h) const {
+			Row row;
+			row.start = _filter_reduce((std::uint32_t)(h >> 32), blocks * 64 - 63);
+			row.coefficients = _filter_hash(h, 1) | 1;
+			row.fingerprint = (std::uint32_t)(h & (((std::uint64_t)1 << bits) - 1));
+			return row;
+		}
+
+		// Tries to solve the system with the current seed and size. Returns false if it doesn't have a solution.
+		bool build(const std::uint64_t* const keys, const std::size_t n) {
+			const std::size_t size = blocks * 64;
+			// Sorting the hashes by the block they start in (a counting sort, so it's linear).
+			std::vector<std::size_t> starts(blocks + 1, 0);
+			for (std::size_t i = 0; i < n; i++) {
+				starts[make_row(_filter_hash(keys[i], seed)).start / 64 + 1]++;
+			}
+			for (std::size_t b = 0; b < blocks; b++) {
+				starts[b + 1] += starts[b];
+			}
+			std::vector<std::uint64_t> hashes(n);
+			for (std::size_t i = 0; i < n; i++) {
+				const std::uint64_t h = _filter_hash(keys[i], seed);
+				hashes[starts[make_row(h).start / 64]++] = h;
+			}
+
+			// coefficients[i] is the row whose first 1 is slot i (or 0 if there isn't one yet) and results[i] is what it has to equal.
+			std::vector<std::uint64_t> coefficients(size, 0);
+			std::vector<std::uint32_t> results(size, 0);
+			for (const std::uint64_t h : hashes) {
+				Row row = make_row(h);
+				std::size_t i = row.start;
+				std::uint64_t c = row.coefficients;
+				std::uint32_t r = row.fingerprint;
+				while (coefficients[i] != 0) {
+					c ^= coefficients[i];
+					r ^= results[i];
+					if (c == 0) {
+						if (r != 0) // 0 = 1, no solution
+							return false;
+						break; // the same key again (or a row that was already implied)
+					}
+					const std::size_t skip = countr_zero(c);
+					i += skip;
+					c >>= skip;
+				}
+				if (c != 0) {
+					coefficients[i] = c;
+					results[i] = r;
+				}
+			}
+
+			// Back substitution, from the last slot up. window[j] holds column j's solution for the 64 slots starting at the current one.
+			solution.assign(blocks * bits, 0);
+			std::vector<std::uint64_t> window(bits, 0);
+			for (std::size_t i = size; i-- > 0;) {
+				std::uint64_t* const block = solution.data() + i / 64 * bits;
+				for (std::size_t j = 0; j < bits; j++) {
+					window[j] <<= 1;
+					// Free slots (no row) can be anything, so 0.
+					const std::uint64_t bit = coefficients[i] == 0 ? 0 : (popcount(window[j] & coefficients[i]) & 1) ^ ((results[i] >> j) & 1);
+					window[j] |= bit;
+					block[j] |= bit << (i % 64);
+				}
+			}
+			return true;
+		}
+
+		std::size_t bits;
+		std::size_t count;
+		std::size_t blocks = 0; // of 64 slots each
+		std::uint64_t seed = 0;
+		std::vector<std::uint64_t> solution; // blocks * bits words
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_STATIC_FILTER_H__
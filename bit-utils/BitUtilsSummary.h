@@ -0,0 +1,256 @@
+/* BitUtilsSummary.h
+* Author: Grayson Spidle
+*
+* This file defines SummaryBitmap, which keeps a 64-ary tree of summaries on top of a memory block so that finding
+* the next/previous set bit in a huge, mostly empty bit array only takes a handful of word reads instead of a scan.
+*
+* The bare minimum language standard for this file is C++11
+*/
+
+#ifndef __BITUTILS_SUMMARY_H__
+#define __BITUTILS_SUMMARY_H__
+
+#include "BitUtils.h"
+
+#if __cplusplus >= 201100 // C++11
+namespace BitUtils {
+	/* A memory block with summary levels on top of it. Level 1 has one bit per 64 bit word of the memory block that isn't 0,
+	* level 2 has one bit per word of level 1 that isn't 0 and so on, until a level fits in a single word.
+	* Searches walk up the levels to skip empty stretches and back down to the bit, which is about two word reads per level
+	* (5 levels for 2^32 bits). set() and flip() keep the levels (and the number of set bits) up to date as they go.
+	*
+	* If you change the memory block without going through this class, then call rebuild() before searching.
+	*/
+	class SummaryBitmap {
+	public:
+		/* Makes a bitmap of n bits that are all 0 and owns its memory block.
+		* Throws std::invalid_argument if n == 0.
+		*/
+		explicit SummaryBitmap(const std::size_t n) : n(n) {
+			_validateBounds(n, 0);
+			owned.resize((n + 63) / 64);
+			block = (unsigned char*)owned.data();
+			rebuild();
+		}
+
+		/* Makes a bitmap on top of an existing memory block of n bits. The memory block isn't copied, so it has to outlive this.
+		* Throws std::invalid_argument if n == 0.
+		*/
+		SummaryBitmap(void* const block, const std::size_t n) : block((unsigned char*)block), n(n) {
+			_validateBounds(n, 0);
+			rebuild();
+		}
+
+		// The block pointer would end up pointing at the other bitmap's memory.
+		SummaryBitmap(const SummaryBitmap&) = delete;
+		SummaryBitmap& operator=(const SummaryBitmap&) = delete;
+		SummaryBitmap(SummaryBitmap&&) = default;
+		SummaryBitmap& operator=(SummaryBitmap&&) = default;
+
+		/* Returns a pointer to the memory block. */
+		void* data() {
+			return block;
+		}
+
+		const void* data() const {
+			return block;
+		}
+
+		/* Returns the number of bits. */
+		std::size_t size() const {
+			return n;
+		}
+
+		/* Returns the number of bits that are 1. */
+		std::size_t count() const {
+			return ones;
+		}
+
+		/* Gets the selected bit's state. Throws std::out_of_range if i >= n. */
+		bool get(const std::size_t i) const {
+			return BitUtils::get(block, n, i);
+		}
+
+		/* Sets the selected bit to reflect the given boolean and updates the summaries. Throws std::out_of_range if i >= n. */
+		void set(const std::size_t i, const bool b) {
+			if (BitUtils::get(block, n, i) == b)
+				return;
+			BitUtils::flip(block, n, i);
+			changed(i, b);
+		}
+
+		/* Flips the selected bit and updates the summaries. Throws std::out_of_range if i >= n. */
+		void flip(const std::size_t i) {
+			BitUtils::flip(block, n, i);
+			changed(i, BitUtils::get(block, n, i));
+		}
+
+		/* Sets every bit to b. */
+		void fill(const bool b) {
+			BitUtils::fill(block, n, b);
+			rebuild();
+		}
+
+		/* Returns false if all the bits are 0 else returns true. Only looks at the top level. */
+		bool bool_op() const {
+			for (std::size_t j = 0; j < words(top()); j++) {
+				if (word(top(), j))
+					return true;
+			}
+			return false;
+		}
+
+		/* Returns true if all the bits are 1 else returns false. */
+		bool all() const {
+			return ones == n;
+		}
+
+		/* Returns the index of the first bit that is 1, or n if there isn't one. */
+		std::size_t find_first() const {
+			return found(next(0, 0));
+		}
+
+		/* Returns the index of the first bit after i that is 1, or n if there isn't one. */
+		std::size_t find_next(const std::size_t i) const {
+			return i + 1 >= n ? n : found(next(0, i + 1));
+		}
+
+		/* Returns the index of the last bit before i that is 1, or n if there isn't one. i can be n (ie find_prev(size()) finds the last bit that is 1). */
+		std::size_t find_prev(const std::size_t i) const {
+			return found(prev(0, i < n ? i : n));
+		}
+
+		/* Returns the index of the last bit that is 1, or n if there isn't one. */
+		std::size_t find_last() const {
+			return find_prev(n);
+		}
+
+		/* Works out the summaries and the number of set bits from the memory block again. */
+		void rebuild() {
+			levels.clear();
+			ones = 0;
+			std::size_t below = (n + 63) / 64; // the number of words in the level below
+			for (std::size_t j = 0; j < below; j++) {
+				ones += popcount(word(0, j));
+			}
+			while (below > 1) {
+				std::vector<std::uint64_t> level((below + 63) / 64, 0);
+				for (std::size_t j = 0; j < below; j++) {
+					if (word(levels.size(), j))
+						level[j / 64] |= (std::uint64_t)1 << (j % 64);
+				}
+				levels.push_back(level);
+				below = level.size();
+			}
+		}
+
+	private:
+		constexpr static const std::size_t npos = (std::size_t)-1;
+
+		// Level 0 is the memory block and level l is levels[l - 1].
+		std::size_t top() const {
+			return levels.size();
+		}
+
+		// The number of bits in a level.
+		std::size_t bits(const std::size_t level) const {
+			return level == 0 ? n : words(level - 1);
+		}
+
+		// The number of words in a level.
+		std::size_t words(const std::size_t level) const {
+			return level == 0 ? (n + 63) / 64 : levels[level - 1].size();
+		}
+
+		std::uint64_t word(const std::size_t level, const std::size_t j) const {
+			if (level == 0)
+				return _load_bits(block + j * sizeof(std::uint64_t), 0, _word_len(n, j));
+			return levels[level - 1][j];
+		}
+
+		std::size_t found(const std::size_t i) const {
+			return i == npos ? n : i;
+		}
+
+		// Bit i of the memory block was changed to b. Only goes up as far as a word changes between 0 and not 0.
+		void changed(const std::size_t i, const bool b) {
+			if (b)
+				ones++;
+			else
+				ones--;
+			std::size_t j = i / 64; // the bit to update in the next level up
+			const std::uint64_t w0 = word(0, j);
+			if (b ? (w0 & (w0 - 1)) != 0 : w0 != 0) // the word had other bits set (or still has), so the summaries don't change
+				return;
+			for (std::size_t level = 1; level <= top(); level++) {
+				std::uint64_t& w = levels[level - 1][j / 64];
+				const bool was_nonzero = w != 0;
+				if (b)
+					w |= (std::uint64_t)1 << (j % 64);
+				else
+					w &= ~((std::uint64_t)1 << (j % 64));
+				if (was_nonzero == (w != 0))
+					return;
+				j /= 64;
+			}
+		}
+
+		// The first bit in the level at or after from that is 1, or npos.
+		std::size_t next(const std::size_t level, const std::size_t from) const {
+			if (from >= bits(level))
+				return npos;
+			std::size_t j = from / 64;
+			std::uint64_t w = word(level, j) & (~(std::uint64_t)0 << (from % 64));
+			if (!w) {
+				if (level == top()) {
+					while (!w && ++j < words(level)) {
+						w = word(level, j);
+					}
+					if (!w)
+						return npos;
+				}
+				else {
+					j = next(level + 1, j + 1); // the summary knows which word is next
+					if (j == npos)
+						return npos;
+					w = word(level, j);
+				}
+			}
+			return j * 64 + countr_zero(w);
+		}
+
+		// The last bit in the level before before that is 1, or npos.
+		std::size_t prev(const std::size_t level, const std::size_t before) const {
+			if (before == 0)
+				return npos;
+			const std::size_t last = (before < bits(level) ? before : bits(level)) - 1;
+			std::size_t j = last / 64;
+			std::uint64_t w = word(level, j) & (~(std::uint64_t)0 >> (63 - last % 64));
+			if (!w) {
+				if (level == top()) {
+					while (!w && j > 0) {
+						w = word(level, --j);
+					}
+					if (!w)
+						return npos;
+				}
+				else {
+					j = prev(level + 1, j);
+					if (j == npos)
+						return npos;
+					w = word(level, j);
+				}
+			}
+			return j * 64 + 63 - countl_zero(w);
+		}
+
+		unsigned char* block;
+		std::size_t n;
+		std::size_t ones = 0;
+		std::vector<std::vector<std::uint64_t>> levels;
+		std::vector<std::uint64_t> owned; // the memory block, if we made it
+	};
+};
+#endif // C++11
+
+#endif // __BITUTILS_SUMMARY_H__
@@ -3,8 +3,25 @@
 
 #define __STDC_WANT_LIB_EXT1__ 1
 #include "BitUtils.h"
+#include "BitUtilsSummary.h"
+#include "BitUtilsBitap.h"
+#include "BitUtilsMyers.h"
+#include "BitUtilsRoaring.h"
+#include "BitUtilsEwah.h"
+#include "BitUtilsAdaptive.h"
+#include "BitUtilsBloom.h"
+#include "BitUtilsStaticFilter.h"
+#include "BitUtilsSlidingWindow.h"
+#include "BitUtilsSketch.h"
+#include "BitUtilsSignature.h"
+#include "BitUtilsIdAllocator.h"
 #undef __STDC_WANT_LIB_EXT1__
 #include <cassert>
+#include <vector>
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <iterator>
 
 #define IS_LITTLE_ENDIAN (1 << 1) > 1
 
@@ -899,6 +916,1865 @@ namespace TestCpp11 {
 
 	}
 
+	// Fills the block with junk that is the same every run.
+	void scramble(void* const block, const std::size_t bytes, std::uint64_t seed) {
+		for (std::size_t i = 0; i < bytes; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			((unsigned char*)block)[i] = (unsigned char)(seed >> 56);
+		}
+	}
+
+	void test_bit_span() {
+		// Checking the word kernels against the bit by bit functions for a bunch of offsets and lengths.
+		const std::size_t n = 300;
+		void* left = BitUtils::create(n);
+		void* right = BitUtils::create(n);
+		void* dst = BitUtils::create(n);
+		void* expected = BitUtils::create(n);
+
+		const std::size_t starts[] = { 0, 1, 7, 8, 13, 64, 65 };
+		const std::size_t lengths[] = { 1, 5, 8, 63, 64, 65, 130, 200 };
+		for (std::size_t start : starts) {
+			for (std::size_t length : lengths) {
+				const std::size_t end = start + length;
+				scramble(left, BitUtils::size(n), start * 31 + length);
+				scramble(right, BitUtils::size(n), start * 17 + length);
+				scramble(dst, BitUtils::size(n), start + length);
+				BitUtils::copy(dst, expected, n);
+
+				const BitUtils::ConstBitSpan l(left, start, end);
+				const BitUtils::ConstBitSpan r(right, start, end);
+				const BitUtils::BitSpan d(dst, start, end);
+
+				std::size_t bits = 0;
+				for (std::size_t i = 0; i < length; i++) {
+					assert(BitUtils::get(l, i) == BitUtils::get(left, n, start + i));
+					bits += BitUtils::get(l, i);
+				}
+				assert(BitUtils::count(l) == bits);
+				assert(BitUtils::bool_op(l) == (bits > 0));
+				assert(BitUtils::all(l) == (bits == length));
+				int order = 0;
+				for (std::size_t i = start; i < end && !order; i++) {
+					if (BitUtils::get(left, n, i) != BitUtils::get(right, n, i))
+						order = BitUtils::get(left, n, i) ? 1 : -1;
+				}
+				assert(BitUtils::compare(l, r) == order);
+
+				// The expected results are worked out with the unbounded functions, one bit at a time.
+				BitUtils::bitwise_and(l, r, d);
+				for (std::size_t i = start; i < end; i++) {
+					BitUtils::set(expected, n, i, BitUtils::get(left, n, i) && BitUtils::get(right, n, i));
+				}
+				assert(BitUtils::compare(dst, expected, n) == 0); // the bits outside of the view weren't touched
+
+				BitUtils::bitwise_xor(l, r, d);
+				for (std::size_t i = start; i < end; i++) {
+					BitUtils::set(expected, n, i, BitUtils::get(left, n, i) != BitUtils::get(right, n, i));
+				}
+				assert(BitUtils::compare(dst, expected, n) == 0);
+
+				BitUtils::bitwise_or(l, r, d);
+				for (std::size_t i = start; i < end; i++) {
+					BitUtils::set(expected, n, i, BitUtils::get(left, n, i) || BitUtils::get(right, n, i));
+				}
+				assert(BitUtils::compare(dst, expected, n) == 0);
+
+				BitUtils::bitwise_not(d);
+				for (std::size_t i = start; i < end; i++) {
+					BitUtils::flip(expected, n, i);
+				}
+				assert(BitUtils::compare(dst, expected, n) == 0);
+				assert(BitUtils::equals(d, BitUtils::ConstBitSpan(expected, start, end)));
+
+				BitUtils::fill(d, 1);
+				for (std::size_t i = start; i < end; i++) {
+					BitUtils::set(expected, n, i, 1);
+				}
+				assert(BitUtils::compare(dst, expected, n) == 0);
+
+				// shifting within the view, checked against the old copy
+				BitUtils::copy(left, dst, n);
+				const std::size_t by = length / 3 + 1;
+				BitUtils::shift_right(d, by);
+				for (std::size_t i = 0; i < length; i++) {
+					assert(BitUtils::get(d, i) == (i >= by && BitUtils::get(left, n, start + i - by)));
+				}
+				BitUtils::copy(left, dst, n);
+				BitUtils::shift_left(d, by);
+				for (std::size_t i = 0; i < length; i++) {
+					assert(BitUtils::get(d, i) == (i + by < length && BitUtils::get(left, n, start + i + by)));
+				}
+			}
+		}
+
+		// misaligned copy between two different views
+		scramble(left, BitUtils::size(n), 1);
+		BitUtils::copy(BitUtils::ConstBitSpan(left, 3, 203), BitUtils::BitSpan(dst, 70, 270));
+		for (std::size_t i = 0; i < 200; i++) {
+			assert(BitUtils::get(dst, n, 70 + i) == BitUtils::get(left, n, 3 + i));
+		}
+
+		// dst overlapping both sources and starting between them (so neither direction alone is safe), both ways around
+		const std::size_t placements[][3] = { { 0, 10, 20 }, { 20, 10, 0 }, { 3, 70, 131 }, { 131, 70, 3 }, { 0, 1, 2 } };
+		for (const std::size_t* at : placements) {
+			for (int op = 0; op < 3; op++) {
+				const std::size_t length = 160;
+				scramble(dst, BitUtils::size(n), 100 + at[0] + op);
+				BitUtils::copy(dst, expected, n);
+				for (std::size_t i = 0; i < length; i++) {
+					const bool a = BitUtils::get(dst, n, at[0] + i);
+					const bool b = BitUtils::get(dst, n, at[2] + i);
+					BitUtils::set(expected, n, at[1] + i, op == 0 ? a && b : op == 1 ? a || b : a != b);
+				}
+				const BitUtils::ConstBitSpan l(dst, at[0], at[0] + length);
+				const BitUtils::ConstBitSpan r(dst, at[2], at[2] + length);
+				const BitUtils::BitSpan d(dst, at[1], at[1] + length);
+				if (op == 0)
+					BitUtils::bitwise_and(l, r, d);
+				else if (op == 1)
+					BitUtils::bitwise_or(l, r, d);
+				else
+					BitUtils::bitwise_xor(l, r, d);
+				assert(BitUtils::compare(dst, expected, n) == 0);
+			}
+		}
+
+		BitUtils::BitSpan s(dst, 5, 12);
+		BitUtils::from_str(s, "1011001");
+		assert(BitUtils::str(s) == "1011001");
+
+		bool threw = false;
+		try {
+			BitUtils::BitSpan bad(dst, 10, 10);
+		}
+		catch (const std::invalid_argument&) {
+			threw = true;
+		}
+		assert(threw);
+
+		free(left);
+		free(right);
+		free(dst);
+		free(expected);
+	}
+
+	void test_for_each_set_bit() {
+		const std::size_t n = 300;
+		void* block = BitUtils::create(n);
+		scramble(block, BitUtils::size(n), 5);
+		// Making it sparse, with a whole word of 0s in the middle.
+		void* sparse = BitUtils::create(n);
+		scramble(sparse, BitUtils::size(n), 6);
+		BitUtils::bitwise_and(block, sparse, block, n);
+		BitUtils::fill(BitUtils::BitSpan(block, 100, 180), 0);
+
+		const std::size_t starts[] = { 0, 3, 64, 99 };
+		const std::size_t ends[] = { 101, 180, 229, 300 };
+		for (std::size_t start : starts) {
+			for (std::size_t end : ends) {
+				std::vector<std::size_t> ones, zeros;
+				for (std::size_t i = start; i < end; i++) {
+					(BitUtils::get(block, n, i) ? ones : zeros).push_back(i - start);
+				}
+
+				std::vector<std::size_t> seen;
+				assert(BitUtils::for_each_set_bit(block, start, end, [&](std::size_t i) { seen.push_back(i); }));
+				assert(seen == ones);
+				seen.clear();
+				assert(BitUtils::for_each_clear_bit(block, start, end, [&](std::size_t i) { seen.push_back(i); }));
+				assert(seen == zeros);
+				seen.clear();
+				assert(BitUtils::rfor_each_set_bit(block, start, end, [&](std::size_t i) { seen.push_back(i); }));
+				assert(std::equal(seen.begin(), seen.end(), ones.rbegin()) && seen.size() == ones.size());
+				seen.clear();
+				assert(BitUtils::rfor_each_clear_bit(block, start, end, [&](std::size_t i) { seen.push_back(i); }));
+				assert(std::equal(seen.begin(), seen.end(), zeros.rbegin()) && seen.size() == zeros.size());
+			}
+		}
+
+		// stopping early
+		std::size_t visits = 0;
+		assert(!BitUtils::for_each_set_bit(block, n, [&](std::size_t) { return ++visits < 3; }));
+		assert(visits == 3);
+		std::size_t last = 0;
+		assert(!BitUtils::rfor_each_clear_bit(block, n, [&](std::size_t i) { last = i; return false; }));
+		for (std::size_t i = last + 1; i < n; i++) {
+			assert(BitUtils::get(block, n, i)); // last was the highest 0
+		}
+		assert(!BitUtils::get(block, n, last));
+
+		// An empty block never calls f.
+		BitUtils::fill(block, n, 0);
+		assert(BitUtils::for_each_set_bit(block, n, [](std::size_t) { assert(false); }));
+
+		free(block);
+		free(sparse);
+	}
+
+	void test_for_each_run() {
+		const std::size_t n = 300;
+		void* block = BitUtils::create(n);
+		void* other = BitUtils::create(n);
+
+		const std::size_t starts[] = { 0, 5, 64 };
+		const std::size_t ends[] = { 64, 129, 300 };
+		for (std::uint64_t seed = 0; seed < 4; seed++) {
+			scramble(block, BitUtils::size(n), seed);
+			if (seed == 1) // long runs that cross words
+				BitUtils::fill(BitUtils::BitSpan(block, 60, 200), 1);
+			if (seed == 2)
+				BitUtils::fill(block, n, 1);
+			if (seed == 3)
+				BitUtils::fill(block, n, 0);
+			for (std::size_t start : starts) {
+				for (std::size_t end : ends) {
+					if (start >= end)
+						continue;
+					// The runs found one bit at a time.
+					std::vector<std::pair<std::size_t, std::size_t>> expected;
+					for (std::size_t i = start; i < end; i++) {
+						if (!BitUtils::get(block, n, i))
+							continue;
+						std::size_t j = i;
+						while (j < end && BitUtils::get(block, n, j))
+							j++;
+						expected.push_back(std::make_pair(i - start, j - start));
+						i = j;
+					}
+
+					assert(BitUtils::to_intervals(block, start, end) == expected);
+
+					// converting them back gives the same bits, without touching anything outside the bounds
+					scramble(other, BitUtils::size(n), seed + 100);
+					void* before = BitUtils::create(n);
+					BitUtils::copy(other, before, n);
+					BitUtils::from_intervals(other, start, end, expected.data(), expected.size());
+					assert(BitUtils::equals(BitUtils::ConstBitSpan(block, start, end), BitUtils::ConstBitSpan(other, start, end)));
+					for (std::size_t i = 0; i < n; i++) {
+						if (i < start || i >= end)
+							assert(BitUtils::get(other, n, i) == BitUtils::get(before, n, i));
+					}
+					free(before);
+				}
+			}
+		}
+
+		// stopping early
+		BitUtils::fill(block, n, 0);
+		BitUtils::fill(BitUtils::BitSpan(block, 10, 20), 1);
+		BitUtils::fill(BitUtils::BitSpan(block, 30, 40), 1);
+		std::size_t runs = 0;
+		assert(!BitUtils::for_each_run(block, n, [&](std::size_t begin, std::size_t end) { runs++; return !(begin == 10 && end == 20); }));
+		assert(runs == 1);
+
+		// unsorted and overlapping intervals
+		const std::pair<std::size_t, std::size_t> intervals[] = { { 50, 70 }, { 3, 4 }, { 60, 90 }, { 8, 8 } };
+		BitUtils::from_intervals(block, n, intervals, 4);
+		const std::vector<std::pair<std::size_t, std::size_t>> merged = { { 3, 4 }, { 50, 90 } };
+		assert(BitUtils::to_intervals(block, n) == merged);
+
+		// bad intervals
+		const std::pair<std::size_t, std::size_t> backwards[] = { { 5, 4 } };
+		const std::pair<std::size_t, std::size_t> too_far[] = { { 5, 301 } };
+		try {
+			BitUtils::from_intervals(block, n, backwards, 1);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+		try {
+			BitUtils::from_intervals(block, n, too_far, 1);
+			assert(false);
+		}
+		catch (const std::out_of_range&) {}
+		assert(BitUtils::to_intervals(block, n) == merged); // nothing changed
+
+		free(block);
+		free(other);
+	}
+
+	void test_bit_iterator() {
+		const std::size_t n = 300;
+		void* block = BitUtils::create(n);
+		void* other = BitUtils::create(n);
+		scramble(block, BitUtils::size(n), 7);
+
+		const BitUtils::bit_iterator begin(block, 0);
+		const BitUtils::bit_iterator end(block, n);
+		assert(end - begin == (std::ptrdiff_t)n);
+		assert(std::distance(begin, end) == (std::ptrdiff_t)n);
+		std::size_t i = 0;
+		for (BitUtils::const_bit_iterator it = begin; it != end; ++it, i++) {
+			assert(*it == BitUtils::get(block, n, i));
+		}
+		assert(i == n);
+		for (std::ptrdiff_t j = 0; j < (std::ptrdiff_t)n; j += 11) {
+			assert(begin[j] == BitUtils::get(block, n, j));
+			assert(*(end - ((std::ptrdiff_t)n - j)) == BitUtils::get(block, n, j));
+			assert((begin + j) - begin == j && begin + j < end && begin + j >= begin);
+		}
+		BitUtils::bit_iterator it = begin + 17;
+		it -= 10;
+		it += -3;
+		assert(it - begin == 4);
+		const bool old = *it;
+		*it = !old;
+		assert(BitUtils::get(block, n, 4) == !old);
+		(*it).flip();
+		assert(BitUtils::get(block, n, 4) == old);
+
+		// the generic algorithms work through the proxy
+		BitUtils::copy(block, other, n);
+		std::reverse(BitUtils::bit_iterator(other, 3), BitUtils::bit_iterator(other, 203));
+		for (std::size_t j = 0; j < 200; j++) {
+			assert(BitUtils::get(other, n, 3 + j) == BitUtils::get(block, n, 202 - j));
+		}
+
+		// the overloads are picked through ADL and give the same answers as going bit by bit
+		using std::find;
+		using std::count;
+		using std::fill;
+		using std::copy;
+		using std::equal;
+		const std::size_t starts[] = { 0, 5, 70 };
+		const std::size_t ends[] = { 70, 133, 300 };
+		for (std::size_t start : starts) {
+			for (std::size_t stop : ends) {
+				if (start >= stop)
+					continue;
+				const BitUtils::const_bit_iterator first(block, start);
+				const BitUtils::const_bit_iterator last(block, stop);
+				std::size_t ones = 0, first_one = stop, first_zero = stop;
+				for (std::size_t j = start; j < stop; j++) {
+					if (BitUtils::get(block, n, j)) {
+						ones++;
+						first_one = first_one == stop ? j : first_one;
+					}
+					else {
+						first_zero = first_zero == stop ? j : first_zero;
+					}
+				}
+				assert(count(first, last, true) == (std::ptrdiff_t)ones);
+				assert(count(first, last, false) == (std::ptrdiff_t)(stop - start - ones));
+				assert(find(first, last, true) - first == (std::ptrdiff_t)(first_one - start));
+				assert(find(first, last, false) - first == (std::ptrdiff_t)(first_zero - start));
+
+				scramble(other, BitUtils::size(n), start + stop);
+				const BitUtils::bit_iterator d_first(other, stop - start < 100 ? 100 : 0);
+				assert(copy(first, last, d_first) == d_first + (std::ptrdiff_t)(stop - start));
+				assert(equal(first, last, d_first));
+				assert(std::equal(first, last, BitUtils::const_bit_iterator(d_first)));
+				BitUtils::flip(other, n, (d_first - BitUtils::bit_iterator(other, 0)) + (stop - start) / 2);
+				assert(!equal(first, last, d_first));
+
+				fill(d_first, d_first + (std::ptrdiff_t)(stop - start), true);
+				assert(count(d_first, d_first + (std::ptrdiff_t)(stop - start), true) == (std::ptrdiff_t)(stop - start));
+			}
+		}
+
+		// ranged for over a view
+		BitUtils::fill(block, n, 0);
+		for (BitUtils::bit_reference bit : BitUtils::BitSpan(block, 10, 20)) {
+			bit = true;
+		}
+		std::size_t visited = 0;
+		for (bool bit : BitUtils::ConstBitSpan(block, 5, 25)) {
+			assert(bit == (visited >= 5 && visited < 15));
+			visited++;
+		}
+		assert(visited == 20);
+
+		free(block);
+		free(other);
+	}
+
+	void test_for_each_word() {
+		const std::size_t n = 300;
+		void* block = BitUtils::create(n);
+		void* before = BitUtils::create(n);
+		const std::size_t starts[] = { 0, 1, 9, 64, 70 };
+		const std::size_t ends[] = { 65, 128, 133, 300 };
+		for (std::size_t start : starts) {
+			for (std::size_t end : ends) {
+				if (start >= end)
+					continue;
+				scramble(block, BitUtils::size(n), start * 7 + end);
+				BitUtils::copy(block, before, n);
+
+				// a reduction done a word at a time
+				std::size_t ones = 0, next_index = 0;
+				assert(BitUtils::for_each_word(block, start, end, [&](std::uint64_t word, std::uint64_t mask, std::size_t index) {
+					assert(index == next_index);
+					assert((word & ~mask) == 0);
+					assert(mask == (end - start - index >= 64 ? ~(std::uint64_t)0 : ((std::uint64_t)1 << (end - start - index)) - 1));
+					for (std::size_t i = 0; i < 64 && index + i < end - start; i++) {
+						assert(((word >> i) & 1) == BitUtils::get(block, n, start + index + i));
+					}
+					ones += BitUtils::popcount(word);
+					next_index += 64;
+				}));
+				assert(next_index >= end - start && next_index - (end - start) < 64);
+				assert(ones == BitUtils::count(BitUtils::ConstBitSpan(block, start, end)));
+
+				// flipping every bit through the mutable version only touches the bits in the bounds
+				assert(BitUtils::for_each_word_mutable(block, start, end, [](std::uint64_t& word, std::uint64_t, std::size_t) {
+					word = ~word;
+				}));
+				for (std::size_t i = 0; i < n; i++) {
+					if (i >= start && i < end)
+						assert(BitUtils::get(block, n, i) != BitUtils::get(before, n, i));
+					else
+						assert(BitUtils::get(block, n, i) == BitUtils::get(before, n, i));
+				}
+			}
+		}
+
+		// stopping early still writes the last word back
+		BitUtils::fill(block, n, 0);
+		std::size_t visits = 0;
+		assert(!BitUtils::for_each_word_mutable(block, n, [&](std::uint64_t& word, std::uint64_t mask, std::size_t) {
+			word = mask;
+			return ++visits < 2;
+		}));
+		assert(BitUtils::count(BitUtils::ConstBitSpan(block, n)) == 128);
+		visits = 0;
+		assert(!BitUtils::for_each_word(block, n, [&](std::uint64_t, std::uint64_t, std::size_t) { visits++; return false; }));
+		assert(visits == 1);
+
+		free(block);
+		free(before);
+	}
+
+	void test_summary_bitmap() {
+		// Checked against a std::set as bits come and go, for sizes with 1 to 4 levels.
+		const std::size_t sizes[] = { 1, 64, 65, 4096, 4097, 300000 };
+		for (std::size_t n : sizes) {
+			BitUtils::SummaryBitmap bitmap(n);
+			std::set<std::size_t> expected;
+			assert(!bitmap.bool_op() && bitmap.find_first() == n && bitmap.find_last() == n);
+
+			std::uint64_t seed = n;
+			for (std::size_t step = 0; step < 2000; step++) {
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				const std::size_t i = (std::size_t)(seed >> 20) % n;
+				const bool b = step % 3 != 2 || expected.empty();
+				const std::size_t target = b ? i : *expected.lower_bound(0);
+				if (step % 7 == 0) {
+					bitmap.flip(target);
+					if (expected.count(target))
+						expected.erase(target);
+					else
+						expected.insert(target);
+				}
+				else {
+					bitmap.set(target, b);
+					if (b)
+						expected.insert(target);
+					else
+						expected.erase(target);
+				}
+				assert(bitmap.count() == expected.size());
+				assert(bitmap.bool_op() == !expected.empty());
+				assert(bitmap.find_first() == (expected.empty() ? n : *expected.begin()));
+				assert(bitmap.find_last() == (expected.empty() ? n : *expected.rbegin()));
+
+				const std::size_t probe = (std::size_t)(seed >> 33) % n;
+				auto after = expected.upper_bound(probe);
+				assert(bitmap.find_next(probe) == (after == expected.end() ? n : *after));
+				auto before = expected.lower_bound(probe);
+				assert(bitmap.find_prev(probe) == (before == expected.begin() ? n : *--before));
+			}
+
+			// walking every set bit both ways
+			std::vector<std::size_t> forward;
+			for (std::size_t i = bitmap.find_first(); i != n; i = bitmap.find_next(i))
+				forward.push_back(i);
+			assert(std::equal(forward.begin(), forward.end(), expected.begin()) && forward.size() == expected.size());
+			std::size_t visits = 0;
+			for (std::size_t i = bitmap.find_last(); i != n; i = bitmap.find_prev(i))
+				visits++;
+			assert(visits == expected.size());
+
+			bitmap.fill(1);
+			assert(bitmap.all() && bitmap.count() == n && bitmap.find_last() == n - 1);
+			bitmap.set(n - 1, 0);
+			assert(!bitmap.all());
+		}
+
+		// layered over an existing block
+		const std::size_t n = 10000;
+		void* block = BitUtils::create(n);
+		BitUtils::set(block, n, 9000, 1);
+		BitUtils::SummaryBitmap bitmap(block, n);
+		assert(bitmap.find_first() == 9000 && bitmap.count() == 1);
+		BitUtils::set(block, n, 5, 1);
+		bitmap.rebuild();
+		assert(bitmap.find_first() == 5 && bitmap.find_next(5) == 9000 && bitmap.find_next(9000) == n);
+		bitmap.set(20, 1);
+		assert(BitUtils::get(block, n, 20));
+
+		try {
+			bitmap.set(n, 1);
+			assert(false);
+		}
+		catch (const std::out_of_range&) {}
+		free(block);
+	}
+
+	// The first run of k bits equal to b at or after from, found one bit at a time.
+	std::size_t naive_first_fit(const void* const block, const std::size_t n, const std::size_t k, const bool b, const std::size_t from) {
+		std::size_t length = 0;
+		for (std::size_t i = from; i < n; i++) {
+			length = BitUtils::get(block, n, i) == b ? length + 1 : 0;
+			if (length == k)
+				return i + 1 - k;
+		}
+		return n;
+	}
+
+	void test_find_fit() {
+		const std::size_t n = 1000;
+		void* block = BitUtils::create(n);
+		void* sparse = BitUtils::create(n);
+		const std::size_t ks[] = { 1, 2, 3, 7, 8, 31, 33, 63, 64, 65, 100, 300 };
+		for (std::uint64_t seed = 0; seed < 6; seed++) {
+			scramble(block, BitUtils::size(n), seed);
+			// Making longer runs of both kinds, so the big ks have something to find.
+			for (std::size_t j = 0; j < seed; j++) {
+				scramble(sparse, BitUtils::size(n), seed * 10 + j);
+				if (seed % 2)
+					BitUtils::bitwise_or(block, sparse, block, n);
+				else
+					BitUtils::bitwise_and(block, sparse, block, n);
+			}
+			if (seed == 5)
+				BitUtils::fill(BitUtils::BitSpan(block, 130, 700), 0);
+
+			for (std::size_t k : ks) {
+				for (bool b : { false, true }) {
+					for (std::size_t from : { (std::size_t)0, (std::size_t)5, (std::size_t)64, (std::size_t)500 }) {
+						assert(BitUtils::find_first_fit(BitUtils::ConstBitSpan(block, n), k, b, from) == naive_first_fit(block, n, k, b, from));
+					}
+					assert(BitUtils::find_first_fit(block, n, k, b) == naive_first_fit(block, n, k, b, 0));
+
+					// next fit wraps around
+					const std::size_t after = naive_first_fit(block, n, k, b, 600);
+					assert(BitUtils::find_next_fit(BitUtils::ConstBitSpan(block, n), k, b, 600) == (after != n ? after : naive_first_fit(block, n, k, b, 0)));
+
+					// best fit is the shortest run that is long enough
+					std::size_t best = n, best_length = n + 1;
+					for (std::size_t i = 0; i < n;) {
+						std::size_t j = i;
+						while (j < n && BitUtils::get(block, n, j) == b)
+							j++;
+						if (j - i >= k && j - i < best_length) {
+							best = i;
+							best_length = j - i;
+						}
+						i = j == i ? i + 1 : j;
+					}
+					assert(BitUtils::find_best_fit(BitUtils::ConstBitSpan(block, n), k, b) == best);
+				}
+			}
+
+			// bounded
+			const BitUtils::ConstBitSpan bounded(block, 3, 503);
+			std::size_t expected = 500;
+			for (std::size_t i = 0, length = 0; i < 500; i++) {
+				length = BitUtils::get(bounded, i) ? 0 : length + 1;
+				if (length == 7) {
+					expected = i + 1 - 7;
+					break;
+				}
+			}
+			assert(BitUtils::find_first_fit(block, 3, 503, 7, false) == expected);
+		}
+
+		try {
+			BitUtils::find_first_fit(block, n, 0, true);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		free(block);
+		free(sparse);
+	}
+
+	void test_claim_run() {
+		const std::size_t n = 4096;
+		void* block = BitUtils::create(n);
+		const BitUtils::BitSpan span(block, 3, n); // not byte aligned on purpose
+
+		// Every thread claims runs until the map is full. Nobody should get a bit that somebody else got.
+		const std::size_t threads = 4;
+		const std::size_t k = 13;
+		std::vector<std::vector<std::size_t>> claimed(threads);
+		std::vector<std::thread> workers;
+		for (std::size_t t = 0; t < threads; t++) {
+			workers.push_back(std::thread([&, t]() {
+				std::size_t hint = t * 1000;
+				while (true) {
+					const std::size_t start = BitUtils::claim_run(span, k, hint);
+					if (start == span.n)
+						return;
+					claimed[t].push_back(start);
+					hint = start + k;
+				}
+			}));
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+
+		std::vector<bool> owner(span.n, false);
+		std::size_t runs = 0;
+		for (const std::vector<std::size_t>& starts : claimed) {
+			for (std::size_t start : starts) {
+				for (std::size_t i = start; i < start + k; i++) {
+					assert(!owner[i]);
+					owner[i] = true;
+					assert(BitUtils::get(span, i));
+				}
+				runs++;
+			}
+		}
+		assert(BitUtils::count(span) == runs * k);
+		assert(BitUtils::find_first_fit(span, k, false, 0) == span.n); // it really is full
+		assert(!BitUtils::get(block, n, 0) && !BitUtils::get(block, n, 2)); // the bits before the view weren't touched
+
+		// giving one back (from the first thread that got one, since a thread can start after the others have taken everything)
+		std::size_t first = 0;
+		while (claimed[first].empty())
+			first++;
+		const std::size_t start = claimed[first].front();
+		BitUtils::release_run(span, start, k);
+		assert(BitUtils::count(span) == (runs - 1) * k);
+		assert(BitUtils::claim_run(span, k, 0) == start);
+		free(block);
+	}
+
+	void test_atomic_bits() {
+		// 1000 bits is 125 bytes: 15 whole words and 5 bytes that have to use byte atomics.
+		const std::size_t n = 1000;
+		void* block = BitUtils::create(n);
+
+		assert(!BitUtils::atomic_test_and_set(block, n, 5));
+		assert(BitUtils::atomic_test_and_set(block, n, 5, BitUtils::MemoryOrder::RELAXED));
+		assert(!BitUtils::atomic_test_and_set(block, n, 999)); // in the tail
+		assert(BitUtils::atomic_get(block, n, 999) && BitUtils::get(block, n, 999));
+		assert(BitUtils::atomic_test_and_clear(block, n, 999));
+		assert(!BitUtils::atomic_test_and_clear(block, n, 999));
+		assert(!BitUtils::atomic_flip(block, n, 64) && BitUtils::atomic_flip(block, n, 64, BitUtils::MemoryOrder::SEQ_CST));
+		BitUtils::atomic_set(block, n, 130, true);
+		assert(BitUtils::atomic_count(block, n) == 2);
+
+		// ranges against the plain fill(), including ones that start and end in the tail and ones inside one word
+		std::uint64_t seed = 49;
+		void* plain = BitUtils::create(n);
+		BitUtils::copy(block, plain, n);
+		for (std::size_t round = 0; round < 200; round++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			std::size_t start = (std::size_t)(seed >> 33) % (n + 1);
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			std::size_t end = (std::size_t)(seed >> 33) % (n + 1);
+			if (start > end)
+				std::swap(start, end);
+			const bool b = round % 3 != 0;
+			BitUtils::atomic_set_range(block, n, start, end, b, round % 2 ? BitUtils::MemoryOrder::RELAXED : BitUtils::MemoryOrder::ACQ_REL);
+			if (start < end)
+				BitUtils::fill(plain, start, end, b);
+			assert(BitUtils::equals(block, plain, n));
+		}
+		assert(BitUtils::atomic_count(block, n) == BitUtils::count(BitUtils::ConstBitSpan(plain, n)));
+
+		// bulk ops against the plain ones
+		void* other = BitUtils::create(n);
+		for (std::size_t i = 0; i < n; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			BitUtils::set(other, n, i, (seed >> 40) & 1);
+		}
+		BitUtils::atomic_bitwise_xor(other, block, n);
+		BitUtils::bitwise_xor(other, plain, plain, n);
+		assert(BitUtils::equals(block, plain, n));
+		BitUtils::atomic_bitwise_and(other, block, n, BitUtils::MemoryOrder::RELAXED);
+		BitUtils::bitwise_and(other, plain, plain, n);
+		assert(BitUtils::equals(block, plain, n));
+		BitUtils::atomic_bitwise_or(other, block, n);
+		BitUtils::bitwise_or(other, plain, plain, n);
+		assert(BitUtils::equals(block, plain, n));
+
+		// the bits past n in the last byte are left alone
+		const std::size_t odd = 1003;
+		void* edge = BitUtils::create(odd);
+		void* ones = BitUtils::create(odd);
+		memset(ones, 0xFF, BitUtils::size(odd));
+		BitUtils::atomic_set_range(edge, odd, 0, odd, true);
+		assert(BitUtils::atomic_count(edge, odd) == odd && ((unsigned char*)edge)[BitUtils::size(odd) - 1] == 0x07);
+		BitUtils::atomic_bitwise_xor(ones, edge, odd);
+		assert(BitUtils::atomic_count(edge, odd) == 0 && ((unsigned char*)edge)[BitUtils::size(odd) - 1] == 0);
+		BitUtils::atomic_bitwise_or(ones, edge, odd);
+		assert(((unsigned char*)edge)[BitUtils::size(odd) - 1] == 0x07);
+
+		bool threw = false;
+		try {
+			BitUtils::atomic_test_and_set((unsigned char*)block + 1, n - 8, 0); // not 8 byte aligned
+		}
+		catch (const std::invalid_argument&) {
+			threw = true;
+		}
+		assert(threw);
+		threw = false;
+		try {
+			BitUtils::atomic_set_range(block, n, 10, n + 1, true);
+		}
+		catch (const std::out_of_range&) {
+			threw = true;
+		}
+		assert(threw);
+
+		// Every thread tries to set every bit. Each bit should be won by exactly one of them.
+		BitUtils::fill(block, n, false);
+		const std::size_t threads = 8;
+		std::vector<std::size_t> wins(threads, 0);
+		std::vector<std::thread> workers;
+		for (std::size_t t = 0; t < threads; t++) {
+			workers.push_back(std::thread([&, t]() {
+				for (std::size_t j = 0; j < n; j++) {
+					const std::size_t i = (j * 7 + t * 131) % n; // a different order for each thread
+					if (!BitUtils::atomic_test_and_set(block, n, i, BitUtils::MemoryOrder::RELAXED))
+						wins[t]++;
+				}
+			}));
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		workers.clear();
+		std::size_t total = 0;
+		for (std::size_t w : wins)
+			total += w;
+		assert(total == n);
+		assert(BitUtils::atomic_count(block, n) == n);
+
+		// Ranges from different threads that share edge words, and flips that cancel out.
+		BitUtils::fill(block, n, false);
+		for (std::size_t t = 0; t < threads; t++) {
+			workers.push_back(std::thread([&, t]() {
+				for (std::size_t start = t * 5; start < n; start += threads * 5) {
+					BitUtils::atomic_set_range(block, n, start, start + 5 < n ? start + 5 : n, true);
+				}
+			}));
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		workers.clear();
+		assert(BitUtils::atomic_count(block, n) == n);
+		for (std::size_t t = 0; t < threads; t++) {
+			workers.push_back(std::thread([&]() {
+				for (std::size_t i = 0; i < n; i++) {
+					BitUtils::atomic_flip(block, n, i, BitUtils::MemoryOrder::RELAXED);
+				}
+			}));
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		assert(BitUtils::atomic_count(block, n) == n); // every bit was flipped an even number of times
+
+		free(ones);
+		free(edge);
+		free(other);
+		free(plain);
+		free(block);
+	}
+
+	void test_find_pattern() {
+		const std::size_t n = 40000; // big enough for the long patterns to skip ahead
+		void* block = BitUtils::create(n);
+		void* pattern = BitUtils::create(300);
+		const std::size_t lengths[] = { 1, 5, 12, 24, 56, 57, 58, 64, 100, 300 };
+		for (std::uint64_t seed = 0; seed < 3; seed++) {
+			scramble(block, BitUtils::size(n), seed);
+			if (seed == 2) { // lots of overlapping matches
+				for (std::size_t i = 0; i < n; i++) {
+					BitUtils::set(block, n, i, i % 7 < 5);
+				}
+			}
+			for (std::size_t m : lengths) {
+				for (std::size_t source : { (std::size_t)1234, (std::size_t)30001 }) {
+					// The pattern comes out of the haystack, so there's at least one match.
+					BitUtils::copy(BitUtils::BitSpan(block, source, source + m), BitUtils::BitSpan(pattern, m));
+					for (std::size_t start : { (std::size_t)0, (std::size_t)3 }) {
+						const std::size_t end = start == 0 ? n : 32003;
+						const BitUtils::ConstBitSpan haystack(block, start, end);
+						const BitUtils::ConstBitSpan needle(pattern, m);
+
+						std::vector<std::size_t> expected;
+						for (std::size_t i = 0; i + m <= haystack.n; i++) {
+							std::size_t j = 0;
+							while (j < m && BitUtils::get(haystack, i + j) == BitUtils::get(needle, j))
+								j++;
+							if (j == m)
+								expected.push_back(i);
+						}
+						assert(!expected.empty());
+						assert(BitUtils::find_all_pattern(haystack, needle) == expected);
+						assert(BitUtils::find_all_pattern(block, start, end, pattern, m) == expected);
+						assert(BitUtils::count_pattern(haystack, needle) == expected.size());
+						assert(BitUtils::count_pattern(block, start, end, pattern, m) == expected.size());
+						assert(BitUtils::find_pattern(block, start, end, pattern, m) == expected.front());
+						const std::size_t from = expected.front() + 1;
+						const std::size_t next = expected.size() > 1 ? expected[1] : haystack.n;
+						assert(BitUtils::find_pattern(haystack, needle, from) == next);
+					}
+				}
+			}
+		}
+
+		// No room for the pattern
+		BitUtils::fill(pattern, 300, 0);
+		assert(BitUtils::find_pattern(block, 10, 20, pattern, 11) == 10);
+		assert(BitUtils::count_pattern(block, 10, 20, pattern, 300) == 0);
+		assert(BitUtils::find_pattern(BitUtils::ConstBitSpan(block, n), BitUtils::ConstBitSpan(pattern, 5), n) == n);
+		try {
+			BitUtils::find_pattern(block, 0, n, pattern, 0);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		free(block);
+		free(pattern);
+	}
+
+	void test_bitap() {
+		std::uint64_t seed = 7;
+		const auto random_text = [&seed](const std::size_t len) {
+			std::string text(len, 'a');
+			for (char& c : text) {
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				c = "acgt"[seed >> 62];
+			}
+			return text;
+		};
+
+		const std::size_t lengths[] = { 1, 5, 64, 65, 130 };
+		for (std::size_t m : lengths) {
+			for (std::size_t k = 0; k < 4 && k < m; k++) {
+				std::vector<std::string> texts;
+				for (std::size_t t = 0; t < 3; t++) {
+					std::string text = random_text(400);
+					// The pattern is taken from the first text, and the other texts get one of their own.
+					text.replace(100 + t, m, random_text(m));
+					texts.push_back(text);
+				}
+				const std::string pattern = texts[0].substr(100, m);
+				texts[1][110] = 'x';
+				const BitUtils::Bitap bitap(pattern, k);
+
+				for (std::size_t t = 0; t < texts.size(); t++) {
+					const std::string& text = texts[t];
+					// The smallest edit distance between the pattern and anything that ends at i (Sellers' algorithm).
+					std::vector<std::size_t> column(m + 1), expected_ends, expected_errors;
+					for (std::size_t j = 0; j <= m; j++)
+						column[j] = j;
+					for (std::size_t i = 0; i < text.size(); i++) {
+						std::size_t diagonal = column[0];
+						column[0] = 0;
+						for (std::size_t j = 1; j <= m; j++) {
+							const std::size_t up = column[j];
+							column[j] = std::min(std::min(column[j] + 1, column[j - 1] + 1), diagonal + (pattern[j - 1] == text[i] ? 0 : 1));
+							diagonal = up;
+						}
+						if (column[m] <= k) {
+							expected_ends.push_back(i);
+							expected_errors.push_back(column[m]);
+						}
+					}
+
+					std::vector<std::size_t> ends, errors;
+					bitap.for_each_match(text.data(), text.size(), [&](std::size_t i, std::size_t e) {
+						ends.push_back(i);
+						errors.push_back(e);
+					});
+					assert(ends == expected_ends);
+					assert(errors == expected_errors);
+					assert(bitap.find_all(text) == expected_ends);
+					assert(bitap.count(text.data(), text.size()) == expected_ends.size());
+					assert(bitap.find(text) == (expected_ends.empty() ? text.size() : expected_ends.front()));
+				}
+				assert(bitap.find(texts[0]) <= 100 + m - 1);
+
+				// batch
+				const std::vector<std::size_t> firsts = bitap.find(texts);
+				std::size_t batch_count = 0;
+				bitap.for_each_match(texts, [&](std::size_t t, std::size_t i, std::size_t) {
+					assert(t < texts.size() && i < texts[t].size());
+					batch_count++;
+				});
+				std::size_t total = 0;
+				for (std::size_t t = 0; t < texts.size(); t++) {
+					assert(firsts[t] == bitap.find(texts[t]));
+					total += bitap.count(texts[t].data(), texts[t].size());
+				}
+				assert(batch_count == total);
+			}
+		}
+
+		try {
+			BitUtils::Bitap("abc", 3);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+	}
+
+	void test_myers() {
+		std::uint64_t seed = 11;
+		const auto random_text = [&seed](const std::size_t len, const char* const alphabet, const std::uint64_t size) {
+			std::string text(len, 'a');
+			for (char& c : text) {
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				c = alphabet[(seed >> 33) % size];
+			}
+			return text;
+		};
+		// The whole table, one cell at a time. The first row is 0s for the semi global distance.
+		const auto table = [](const std::string& pattern, const std::string& text, const bool global, std::vector<std::size_t>& last_row) {
+			std::vector<std::size_t> column(pattern.size() + 1);
+			for (std::size_t j = 0; j <= pattern.size(); j++)
+				column[j] = j;
+			last_row.clear();
+			for (std::size_t i = 0; i < text.size(); i++) {
+				std::size_t diagonal = column[0];
+				column[0] = global ? i + 1 : 0;
+				for (std::size_t j = 1; j <= pattern.size(); j++) {
+					const std::size_t up = column[j];
+					column[j] = std::min(std::min(column[j] + 1, column[j - 1] + 1), diagonal + (pattern[j - 1] == text[i] ? 0 : 1));
+					diagonal = up;
+				}
+				last_row.push_back(column.back());
+			}
+			return column.back();
+		};
+
+		const std::size_t lengths[] = { 1, 5, 63, 64, 65, 128, 150, 200 };
+		for (std::size_t m : lengths) {
+			for (const char* alphabet : { "ab", "acgt" }) {
+				const std::uint64_t size = strlen(alphabet);
+				const std::string pattern = random_text(m, alphabet, size);
+				const BitUtils::Myers myers(pattern);
+				for (std::size_t len : { (std::size_t)0, (std::size_t)1, m / 2, m, m + 7, 3 * m + 10 }) {
+					std::string text = random_text(len, alphabet, size);
+					if (len > m + 3) { // something close to the pattern in the middle (which can make the text longer)
+						text.replace(len / 3, m, pattern);
+						text[len / 3 + m / 2] = 'x';
+					}
+
+					std::vector<std::size_t> last_row;
+					const std::size_t global = table(pattern, text, true, last_row);
+					assert(myers.distance(text) == global);
+					table(pattern, text, false, last_row);
+					std::pair<std::size_t, std::size_t> semi(len == 0 ? m : m + 1, text.size());
+					for (std::size_t i = 0; i < last_row.size(); i++) {
+						if (last_row[i] < semi.first)
+							semi = std::make_pair(last_row[i], i);
+					}
+					assert(myers.search(text) == semi);
+
+					for (std::size_t max_k : { (std::size_t)0, (std::size_t)1, (std::size_t)3, m / 4, m / 2, m, 2 * m }) {
+						assert(myers.banded_distance(text, max_k) == std::min(global, max_k + 1));
+						const std::pair<std::size_t, std::size_t> banded = myers.banded_search(text, max_k);
+						if (semi.first <= max_k)
+							assert(banded == semi);
+						else
+							assert(banded == std::make_pair(max_k + 1, text.size()));
+					}
+				}
+			}
+		}
+
+		assert(BitUtils::Myers("kitten").distance("sitting") == 3);
+		assert(BitUtils::Myers("kitten").banded_distance("sitting", 2) == 3);
+		assert(BitUtils::Myers("kitten").banded_distance("sitting", 0) == 1);
+		try {
+			BitUtils::Myers("", 0);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+	}
+
+	void test_roaring() {
+		std::uint64_t seed = 3;
+		const auto next = [&seed]() {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			return (std::uint32_t)(seed >> 32);
+		};
+		const auto values = [](const BitUtils::RoaringBitmap& bitmap) {
+			std::vector<std::uint32_t> out;
+			bitmap.for_each([&out](std::uint32_t x) { out.push_back(x); });
+			return out;
+		};
+
+		// Sparse values all over, a dense chunk, a chunk of runs, and a run over a chunk boundary.
+		std::set<std::uint32_t> left_set, right_set;
+		BitUtils::RoaringBitmap left, right;
+		for (std::size_t i = 0; i < 3000; i++) {
+			const std::uint32_t x = next();
+			left.add(x);
+			left_set.insert(x);
+			const std::uint32_t y = i % 2 ? next() : x ^ 1;
+			right.add(y);
+			right_set.insert(y);
+		}
+		for (std::size_t i = 0; i < 20000; i++) {
+			const std::uint32_t x = (7u << 16) | (next() & 0xFFFF);
+			left.add(x);
+			left_set.insert(x);
+			if (i % 3 == 0) {
+				right.add(x ^ 2);
+				right_set.insert(x ^ 2);
+			}
+		}
+		for (std::uint32_t start = 9u << 16; start < (10u << 16); start += 1000) {
+			left.add_range(start, start + 300);
+			for (std::uint32_t x = start; x < start + 300; x++)
+				left_set.insert(x);
+		}
+		right.add_range((7u << 16) - 100, (9u << 16) + 50);
+		for (std::uint32_t x = (7u << 16) - 100; x < (9u << 16) + 50; x++)
+			right_set.insert(x);
+		left.add(0xFFFFFFFF);
+		left_set.insert(0xFFFFFFFF);
+
+		assert(left.count() == left_set.size() && right.count() == right_set.size());
+		assert(values(left) == std::vector<std::uint32_t>(left_set.begin(), left_set.end()));
+		for (std::size_t i = 0; i < 2000; i++) {
+			const std::uint32_t x = i % 2 ? next() : (7u << 16) + (std::uint32_t)i * 31;
+			assert(left.contains(x) == (left_set.count(x) == 1));
+			assert(left.rank(x) == (std::uint64_t)std::distance(left_set.begin(), left_set.upper_bound(x)));
+		}
+		assert(left.rank(0xFFFFFFFF) == left.count());
+
+		// The set operations, against std::set
+		std::vector<std::uint32_t> expected;
+		std::set_intersection(left_set.begin(), left_set.end(), right_set.begin(), right_set.end(), std::back_inserter(expected));
+		assert(values(left & right) == expected);
+		expected.clear();
+		std::set_union(left_set.begin(), left_set.end(), right_set.begin(), right_set.end(), std::back_inserter(expected));
+		assert(values(left | right) == expected);
+		expected.clear();
+		std::set_symmetric_difference(left_set.begin(), left_set.end(), right_set.begin(), right_set.end(), std::back_inserter(expected));
+		assert(values(left ^ right) == expected);
+		expected.clear();
+		std::set_difference(left_set.begin(), left_set.end(), right_set.begin(), right_set.end(), std::back_inserter(expected));
+		assert(values(left - right) == expected);
+		assert(((left ^ right) ^ right) == left);
+		assert((left - left).empty());
+		BitUtils::RoaringBitmap both = left;
+		both &= right;
+		assert(both == (left & right) && both != left);
+
+		// Galloping: a few values against a lot of them
+		BitUtils::RoaringBitmap few;
+		few.add((7u << 16) + 5);
+		few.add((7u << 16) + 60000);
+		few.add((9u << 16) + 1000);
+		BitUtils::RoaringBitmap some;
+		for (std::uint32_t x = 0; x < 4000; x++)
+			some.add((7u << 16) + x * 16 + 5);
+		assert(values(few & some) == std::vector<std::uint32_t>(1, (7u << 16) + 5));
+
+		// remove
+		for (std::uint32_t x : { (7u << 16) + 5, 0xFFFFFFFFu, (9u << 16) + 10, (9u << 16) + 400, 12345u }) {
+			left.remove(x);
+			left_set.erase(x);
+			assert(!left.contains(x));
+		}
+		assert(values(left) == std::vector<std::uint32_t>(left_set.begin(), left_set.end()));
+
+		// Memory blocks (and bounded ranges of them) in and out
+		const std::size_t n = 300000;
+		void* block = BitUtils::create(n);
+		void* back = BitUtils::create(n);
+		BitUtils::fill(block, n, 0);
+		for (std::size_t i = 0; i < 500; i++)
+			BitUtils::set(block, n, next() % n, true);
+		BitUtils::fill(BitUtils::BitSpan(block, 70000, 140000), 1);
+		scramble((unsigned char*)block + 25000, 4000, 1);
+		for (std::size_t start : { (std::size_t)0, (std::size_t)5 }) {
+			const std::size_t end = start == 0 ? n : 200003;
+			const BitUtils::RoaringBitmap bitmap(block, start, end);
+			assert(bitmap.count() == BitUtils::count(BitUtils::ConstBitSpan(block, start, end)));
+			BitUtils::fill(back, n, 1);
+			bitmap.copy_to(back, start, end);
+			assert(BitUtils::equals(BitUtils::ConstBitSpan(back, start, end), BitUtils::ConstBitSpan(block, start, end)));
+			assert(start == 0 || BitUtils::get(back, n, start - 1)); // the bits before the view were left alone
+			const BitUtils::RoaringBitmap again = BitUtils::RoaringBitmap::deserialize(bitmap.serialize());
+			assert(again == bitmap);
+			assert(bitmap.serialize().size() == bitmap.serialized_size());
+			assert(bitmap.serialized_size() < BitUtils::size(n) / 4);
+		}
+		left.optimize();
+		assert(BitUtils::RoaringBitmap::deserialize(left.serialize()) == left);
+		assert(BitUtils::RoaringBitmap::deserialize(BitUtils::RoaringBitmap().serialize()).empty());
+
+		// The format, byte for byte. No runs: cookie 12346, 1 container, key 0 with 3 values, its offset, then the values.
+		BitUtils::RoaringBitmap small;
+		small.add(1);
+		small.add(2);
+		small.add(3);
+		const std::vector<unsigned char> no_runs = { 0x3A, 0x30, 0, 0, 1, 0, 0, 0, 0, 0, 2, 0, 16, 0, 0, 0, 1, 0, 2, 0, 3, 0 };
+		assert(small.serialize() == no_runs);
+		// Runs: cookie 12347 with 0 (1 container - 1) on top, the run flags, key 0 with 100 values, no offsets (fewer than 4 containers), and 1 run of [0, 100).
+		BitUtils::RoaringBitmap run;
+		run.add_range(0, 100);
+		const std::vector<unsigned char> runs = { 0x3B, 0x30, 0, 0, 1, 0, 0, 99, 0, 1, 0, 0, 0, 99, 0 };
+		assert(run.serialize() == runs);
+		assert(BitUtils::RoaringBitmap::deserialize(runs) == run);
+
+		// Adding a value to a run container. With room left it has to become an array, since the format tells arrays from bitmaps by cardinality.
+		BitUtils::RoaringBitmap grown = run;
+		grown.add(50); // already in the run
+		assert(grown.serialize() == runs);
+		grown.add(200);
+		const std::vector<unsigned char> grown_bytes = grown.serialize();
+		assert(grown_bytes.size() == grown.serialized_size() && grown_bytes.size() < 8 + 8 + 2 * 101 + 1);
+		const BitUtils::RoaringBitmap grown_back = BitUtils::RoaringBitmap::deserialize(grown_bytes);
+		assert(grown_back == grown && grown_back.contains(200) && grown_back.contains(99) && !grown_back.contains(100));
+		// and past 4096 values it's a bitmap
+		BitUtils::RoaringBitmap big;
+		big.add_range(0, 5000);
+		big.add(6000);
+		const BitUtils::RoaringBitmap big_back = BitUtils::RoaringBitmap::deserialize(big.serialize());
+		assert(big_back == big && big_back.contains(6000) && big.serialize().size() == big.serialized_size());
+
+		const std::vector<unsigned char> cut_off(runs.begin(), runs.end() - 1);
+		try {
+			BitUtils::RoaringBitmap::deserialize(cut_off);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		free(block);
+		free(back);
+	}
+
+	void test_ewah() {
+		// Long runs of both kinds with some junk between them, which is what EWAH is for.
+		const std::size_t n = 100000;
+		const auto make = [n](const std::uint64_t seed) {
+			void* block = BitUtils::create(n);
+			BitUtils::fill(block, n, 0);
+			BitUtils::fill(BitUtils::BitSpan(block, 1000 + seed * 64, 40000), 1);
+			BitUtils::fill(BitUtils::BitSpan(block, 60001, 60001 + 3000 * seed), 1);
+			scramble((unsigned char*)block + 2000 + seed * 300, 1000, seed);
+			scramble((unsigned char*)block + 9000, 8, seed);
+			BitUtils::set(block, n, n - 1, true);
+			return block;
+		};
+		void* left = make(1);
+		void* right = make(2);
+		void* out = BitUtils::create(n);
+		void* expected = BitUtils::create(n);
+
+		for (std::size_t start : { (std::size_t)0, (std::size_t)3 }) {
+			const BitUtils::ConstBitSpan span(left, start, n);
+			const BitUtils::EwahBitmap bitmap(span);
+			assert(bitmap.size() == span.n);
+			assert(bitmap.count() == BitUtils::count(span));
+			assert(bitmap.compressed_words() < span.n / 64 / 3);
+			BitUtils::fill(out, n, 1);
+			bitmap.copy_to(out, start, n);
+			assert(BitUtils::equals(BitUtils::ConstBitSpan(out, start, n), span));
+
+			std::vector<std::pair<std::size_t, std::size_t>> runs;
+			bitmap.for_each_run([&runs](std::size_t begin, std::size_t end) { runs.push_back(std::make_pair(begin, end)); });
+			assert(runs == BitUtils::to_intervals(left, start, n));
+			std::size_t ones = 0;
+			bitmap.for_each_set_bit([&](std::size_t i) {
+				assert(BitUtils::get(span, i));
+				ones++;
+			});
+			assert(ones == bitmap.count());
+		}
+
+		// Built a piece at a time, it comes out the same.
+		BitUtils::EwahBitmap pieces;
+		std::size_t at = 0;
+		for (std::size_t piece : { (std::size_t)1, (std::size_t)63, (std::size_t)70, (std::size_t)5000, (std::size_t)129, (std::size_t)30000 }) {
+			pieces.append(BitUtils::ConstBitSpan(left, at, at + piece));
+			at += piece;
+		}
+		pieces.append(BitUtils::ConstBitSpan(left, at, n));
+		assert(pieces == BitUtils::EwahBitmap(left, n));
+		assert(pieces.data() == BitUtils::EwahBitmap(left, n).data());
+
+		BitUtils::EwahBitmap appended;
+		appended.append(true, 10);
+		appended.append(false, 200);
+		appended.append(true, 1000);
+		appended.add(5000);
+		appended.add(5001);
+		appended.add(5100);
+		BitUtils::fill(expected, 5101, 0);
+		BitUtils::fill(BitUtils::BitSpan(expected, 0, 10), 1);
+		BitUtils::fill(BitUtils::BitSpan(expected, 210, 1210), 1);
+		BitUtils::set(expected, 5101, 5000, true);
+		BitUtils::set(expected, 5101, 5001, true);
+		BitUtils::set(expected, 5101, 5100, true);
+		assert(appended == BitUtils::EwahBitmap(expected, 5101));
+		try {
+			appended.add(5100);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		// The bitwise operations, against the memory block versions. The right one is shorter, so it gets 0s at the end.
+		const std::size_t m = 77777;
+		const BitUtils::EwahBitmap a(left, n), b(right, m);
+		BitUtils::fill(BitUtils::BitSpan(right, m, n), 0);
+		const BitUtils::EwahBitmap results[] = { a & b, a | b, a ^ b, b & a, b ^ a };
+		for (std::size_t op = 0; op < 5; op++) {
+			const BitUtils::ConstBitSpan l(left, n), r(right, n);
+			if (op % 3 == 0)
+				BitUtils::bitwise_and(l, r, BitUtils::BitSpan(expected, n));
+			else if (op == 1)
+				BitUtils::bitwise_or(l, r, BitUtils::BitSpan(expected, n));
+			else
+				BitUtils::bitwise_xor(l, r, BitUtils::BitSpan(expected, n));
+			assert(results[op].size() == n);
+			results[op].copy_to(out, n);
+			assert(BitUtils::equals(out, expected, n));
+			assert(results[op] == BitUtils::EwahBitmap(expected, n));
+		}
+		assert((a ^ a).count() == 0 && (a & a) == a);
+
+		// Appending to the result of an operation that ended on a partial word of 0s
+		BitUtils::EwahBitmap partial = BitUtils::EwahBitmap(left, 100) & BitUtils::EwahBitmap();
+		partial.add(150);
+		assert(partial.count() == 1 && partial.size() == 151);
+
+		free(left);
+		free(right);
+		free(out);
+		free(expected);
+	}
+
+	void test_adaptive() {
+		const std::size_t n = 6400; // dense past 200 1s, sparse again under 100
+		BitUtils::AdaptiveBitset bits(n);
+		std::set<std::size_t> reference;
+		std::uint64_t seed = 43;
+		const auto rng = [&seed]() {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			return (std::size_t)(seed >> 33);
+		};
+		const auto matches = [&](const BitUtils::AdaptiveBitset& b, const std::set<std::size_t>& r) {
+			std::vector<std::size_t> ones;
+			b.for_each([&ones](std::size_t i) { ones.push_back(i); });
+			return b.count() == r.size() && ones == std::vector<std::size_t>(r.begin(), r.end());
+		};
+
+		// Up past the line, then back down, and it only goes back to an array once it's well under it.
+		for (std::size_t i = 0; i < 200; i++) {
+			const std::size_t at = rng() % n;
+			bits.set(at, true);
+			reference.insert(at);
+			assert(bits.is_dense() == (reference.size() > n / 32));
+		}
+		while (reference.size() <= n / 32) {
+			const std::size_t at = rng() % n;
+			bits.set(at, true);
+			reference.insert(at);
+		}
+		assert(bits.is_dense() && matches(bits, reference));
+		while (reference.size() >= n / 64) {
+			const std::size_t at = *reference.begin();
+			bits.set(at, false);
+			bits.set(at, false);
+			reference.erase(at);
+			assert(bits.is_dense() == (reference.size() >= n / 64));
+			assert(!bits.get(at));
+		}
+		assert(!bits.is_dense() && matches(bits, reference));
+		for (std::size_t i = 0; i < n; i++) {
+			assert(bits.get(i) == (reference.count(i) == 1));
+		}
+		try {
+			bits.get(n);
+			assert(false);
+		}
+		catch (const std::out_of_range&) {}
+		try {
+			BitUtils::AdaptiveBitset empty(0);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		// Every pair of representations for every operation, against std::set.
+		const auto make = [&](const std::size_t ones, std::set<std::size_t>& r) {
+			BitUtils::AdaptiveBitset b(n);
+			r.clear();
+			while (r.size() < ones) {
+				const std::size_t at = rng() % (n / 2) + (rng() % 2) * (n / 2);
+				r.insert(at);
+				b.set(at, true);
+			}
+			return b;
+		};
+		for (std::size_t left_ones : { (std::size_t)0, (std::size_t)7, (std::size_t)150, (std::size_t)3000 }) {
+			for (std::size_t right_ones : { (std::size_t)1, (std::size_t)90, (std::size_t)180, (std::size_t)5000 }) {
+				std::set<std::size_t> l, r;
+				const BitUtils::AdaptiveBitset a = make(left_ones, l), b = make(right_ones, r);
+				for (std::size_t op = 0; op < 4; op++) {
+					std::set<std::size_t> expected;
+					for (std::size_t i = 0; i < n; i++) {
+						const bool x = l.count(i) == 1, y = r.count(i) == 1;
+						if (op == 0 ? x && y : op == 1 ? x || y : op == 2 ? x != y : x && !y)
+							expected.insert(i);
+					}
+					BitUtils::AdaptiveBitset result = op == 0 ? a & b : op == 1 ? a | b : op == 2 ? a ^ b : a - b;
+					assert(matches(result, expected));
+					assert(result.is_dense() == (expected.size() > n / 32));
+					BitUtils::AdaptiveBitset compound = a;
+					if (op == 0)
+						compound &= b;
+					else if (op == 1)
+						compound |= b;
+					else if (op == 2)
+						compound ^= b;
+					else
+						compound -= b;
+					assert(compound == result);
+				}
+			}
+		}
+		try {
+			bits & BitUtils::AdaptiveBitset(n + 1);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		// The galloping lookup, with a small array against long runs of a big one.
+		BitUtils::AdaptiveBitset big(1 << 20), small(1 << 20);
+		std::set<std::size_t> expected;
+		for (std::size_t i = 0; i < 30000; i++) {
+			big.set(i * 3, true);
+		}
+		for (std::size_t i : { (std::size_t)0, (std::size_t)1, (std::size_t)24, (std::size_t)25, (std::size_t)3000, (std::size_t)89997, (std::size_t)89999, (std::size_t)90000, (std::size_t)500000 }) {
+			small.set(i, true);
+			if (i % 3 == 0 && i < 90000)
+				expected.insert(i);
+		}
+		assert(!big.is_dense() && matches(small & big, expected) && matches(big & small, expected));
+
+		// To and from memory blocks, with and without an offset.
+		void* block = BitUtils::create(n + 10);
+		void* out = BitUtils::create(n + 10);
+		scramble((unsigned char*)block, (n + 10) / CHAR_BIT, 43);
+		for (std::size_t start : { (std::size_t)0, (std::size_t)5 }) {
+			const BitUtils::ConstBitSpan span(block, start, start + n);
+			const BitUtils::AdaptiveBitset dense(span);
+			assert(dense.is_dense() && dense.count() == BitUtils::count(span));
+			BitUtils::fill(out, n + 10, 1);
+			dense.copy_to(out, start, start + n);
+			assert(BitUtils::equals(BitUtils::ConstBitSpan(out, start, start + n), span));
+			dense.copy_to(out, n + 10);
+			assert(BitUtils::equals(BitUtils::ConstBitSpan(out, n), span) && !BitUtils::get(out, n + 10, n + 9));
+
+			const BitUtils::AdaptiveBitset sparse = dense & make(50, expected);
+			assert(!sparse.is_dense());
+			BitUtils::fill(out, n + 10, 1);
+			sparse.copy_to(out, start, start + n);
+			assert(BitUtils::AdaptiveBitset(BitUtils::ConstBitSpan(out, start, start + n)) == sparse);
+		}
+
+		free(block);
+		free(out);
+	}
+
+	void test_bloom_filter() {
+		const std::size_t keys = 20000;
+		BitUtils::BlockedBloomFilter filter(keys * 10);
+		assert(filter.size() % 512 == 0 && filter.size() >= keys * 10 && filter.size() < keys * 10 + 512);
+		assert((std::uintptr_t)filter.data() % 64 == 0 && filter.count() == 0);
+
+		// No false negatives, one at a time or batched, and not too many false positives.
+		std::vector<std::uint64_t> in, out;
+		for (std::uint64_t i = 0; i < keys; i++) {
+			in.push_back(i * 7);
+			out.push_back(i * 7 + 3);
+		}
+		for (std::size_t i = 0; i < keys / 2; i++) {
+			filter.insert(in[i]);
+		}
+		filter.insert(in.data() + keys / 2, keys - keys / 2);
+		assert(filter.count() <= keys * 8 && filter.count() > keys * 4);
+		void* results = BitUtils::create(keys);
+		assert(filter.contains(in.data(), keys, results) == keys);
+		assert(BitUtils::count(BitUtils::ConstBitSpan(results, keys)) == keys);
+		std::size_t false_positives = 0;
+		for (std::size_t i = 0; i < keys; i++) {
+			assert(filter.contains(in[i]));
+			false_positives += filter.contains(out[i]);
+		}
+		assert(false_positives < keys / 50);
+		assert(filter.contains(out.data(), keys, results) == false_positives);
+		for (std::size_t i = 0; i < keys; i++) {
+			assert(BitUtils::get(results, keys, i) == filter.contains(out[i]));
+		}
+
+		// Merging
+		BitUtils::BlockedBloomFilter evens(keys * 10), odds(keys * 10);
+		for (std::size_t i = 0; i < keys; i++) {
+			(i % 2 ? odds : evens).insert(in[i]);
+		}
+		BitUtils::BlockedBloomFilter both = evens | odds;
+		assert(both == filter && both.data() != filter.data() && (std::uintptr_t)both.data() % 64 == 0);
+		BitUtils::BlockedBloomFilter common = evens & filter;
+		for (std::size_t i = 0; i < keys; i += 2) {
+			assert(common.contains(in[i]));
+		}
+		assert(common.count() < both.count());
+		common = odds;
+		common &= evens;
+		assert(common.count() < odds.count());
+		try {
+			evens |= BitUtils::BlockedBloomFilter(keys * 20);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		// Serializing
+		const std::vector<unsigned char> bytes = filter.serialize();
+		assert(bytes.size() == filter.serialized_size() && bytes.size() == 8 + filter.size() / 8);
+		const BitUtils::BlockedBloomFilter back = BitUtils::BlockedBloomFilter::deserialize(bytes);
+		assert(back == filter && back.contains(in[123]));
+		try {
+			BitUtils::BlockedBloomFilter::deserialize(bytes.data(), bytes.size() - 1);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		filter.clear();
+		assert(filter.count() == 0 && !filter.contains(in[0]) && filter != back);
+		try {
+			BitUtils::BlockedBloomFilter empty(0);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		free(results);
+	}
+
+	void test_static_filters() {
+		// No false negatives, about 1 in 2^bits false positives, and fewer bits per key than a Bloom filter would need (1.44 bits).
+		const std::size_t n = 50000;
+		std::vector<std::uint64_t> keys;
+		for (std::uint64_t i = 0; i < n; i++) {
+			keys.push_back(i * 0x9E3779B97F4A7C15ULL);
+		}
+		for (std::size_t bits : { (std::size_t)1, (std::size_t)8, (std::size_t)13, (std::size_t)32 }) {
+			const BitUtils::XorFilter x(keys, bits);
+			const BitUtils::RibbonFilter r(keys, bits);
+			assert(x.keys() == n && r.keys() == n && x.fingerprint_bits() == bits && r.fingerprint_bits() == bits);
+			assert(x.size() < n * bits * 125 / 100 + 64 && r.size() < n * bits * 115 / 100 + 64 * bits);
+			std::size_t x_positives = 0, r_positives = 0;
+			for (std::size_t i = 0; i < n; i++) {
+				assert(x.contains(keys[i]) && r.contains(keys[i]));
+				x_positives += x.contains(keys[i] + 1);
+				r_positives += r.contains(keys[i] + 1);
+			}
+			const double expected = (double)n / (double)((std::uint64_t)1 << bits);
+			assert(x_positives < expected * 1.5 + 10 && r_positives < expected * 1.5 + 10);
+			assert(bits > 8 || (x_positives > expected / 2 && r_positives > expected / 2));
+		}
+
+		// Duplicates, and sets too small to fill a block.
+		std::vector<std::uint64_t> repeats = { 5, 9, 5, 5, 1000, 9 };
+		const BitUtils::XorFilter x(repeats, 16);
+		const BitUtils::RibbonFilter r(repeats, 16);
+		assert(x.keys() == 3 && r.keys() == 6);
+		for (std::uint64_t key : repeats) {
+			assert(x.contains(key) && r.contains(key));
+		}
+		assert(!x.contains(6) && !r.contains(6));
+		std::vector<std::uint64_t> twice(keys);
+		twice.insert(twice.end(), keys.begin(), keys.end());
+		const BitUtils::XorFilter x_twice(twice, 8);
+		assert(x_twice.keys() == n && x_twice.size() < n * 8 * 125 / 100 + 64);
+		for (std::size_t i = 0; i < n; i++) {
+			assert(x_twice.contains(keys[i]));
+		}
+		const BitUtils::XorFilter x_empty(repeats.data(), 0, 8);
+		const BitUtils::RibbonFilter r_empty(repeats.data(), 0, 8);
+		assert(x_empty.keys() == 0 && r_empty.keys() == 0);
+
+		try {
+			BitUtils::XorFilter(keys, 0);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+		try {
+			BitUtils::RibbonFilter(keys, 33);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+	}
+
+	void test_sliding_window() {
+		// Against a set of everything seen, with small steps, jumps inside the window, jumps past it, and old sequence numbers.
+		BitUtils::SlidingWindow window(1000);
+		BitUtils::AtomicSlidingWindow atomic(1000);
+		assert(window.size() == 1024 && atomic.size() == 1024);
+		assert(window.find_first_missing() == 0 && window.count() == 0 && !window.seen(5));
+		std::set<std::uint64_t> seen;
+		std::uint64_t head = 0, seed = 46;
+		for (std::size_t i = 0; i < 20000; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			const std::uint64_t r = seed >> 33;
+			std::uint64_t seq;
+			if (r % 100 == 0)
+				seq = head + 1500 + r % 3000;
+			else if (r % 10 == 0)
+				seq = head > 1100 ? head - 1100 + r % 200 : r % 50;
+			else
+				seq = head + r % 40 - (head >= 30 ? 30 : head);
+			const bool old = seq + 1024 < head;
+			const bool expected = old || seen.count(seq) == 1;
+			assert(window.seen(seq) == expected && atomic.seen(seq) == expected);
+			if (r % 7 == 0) {
+				window.advance_to(seq);
+				atomic.advance_to(seq);
+				head = std::max(head, seq + 1);
+			}
+			else {
+				assert(window.test_and_set(seq) == expected && atomic.test_and_set(seq) == expected);
+				if (!old) {
+					head = std::max(head, seq + 1);
+					seen.insert(seq);
+				}
+			}
+			assert(window.head() == head && atomic.head() == head);
+			const std::uint64_t low = head > 1024 ? head - 1024 : 0;
+			const std::size_t ones = std::distance(seen.lower_bound(low), seen.end());
+			assert(window.count() == ones && atomic.count() == ones);
+			std::uint64_t missing = low;
+			while (seen.count(missing) == 1) {
+				missing++;
+			}
+			assert(window.find_first_missing() == missing && atomic.find_first_missing() == missing);
+		}
+		try {
+			BitUtils::SlidingWindow empty(0);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		// Threads going through the same sequence numbers: each one is let through at most once (and a missed one is only ever rejected).
+		const std::size_t n = 200000;
+		BitUtils::AtomicSlidingWindow shared(1 << 10);
+		std::vector<std::vector<unsigned char>> wins(4, std::vector<unsigned char>(n, 0));
+		std::vector<std::thread> threads;
+		for (std::size_t t = 0; t < 4; t++) {
+			threads.emplace_back([&shared, &wins, t, n]() {
+				for (std::uint64_t seq = 0; seq < n; seq++) {
+					wins[t][seq ^ (t & 1)] = !shared.test_and_set(seq ^ (t & 1));
+				}
+			});
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		std::size_t total = 0;
+		for (std::size_t seq = 0; seq < n; seq++) {
+			const std::size_t winners = wins[0][seq] + wins[1][seq] + wins[2][seq] + wins[3][seq];
+			assert(winners <= 1);
+			total += winners;
+		}
+		assert(total > n / 2 && shared.head() == n);
+		assert(shared.count() == shared.size() && shared.find_first_missing() == n);
+	}
+
+	void test_sketches() {
+		const auto close = [](const double estimate, const double actual, const double error) {
+			return std::fabs(estimate - actual) <= actual * error + 1;
+		};
+		std::vector<std::uint64_t> keys;
+		for (std::uint64_t i = 0; i < 200000; i++) {
+			keys.push_back(i * 3 + 1);
+		}
+
+		// Linear counting, a key at a time or batched (with repeats), merged, and serialized sparse and dense.
+		BitUtils::LinearCounter lc(1 << 16), evens(1 << 16), odds(1 << 16);
+		assert(lc.estimate() == 0 && lc.size() == 1 << 16);
+		for (std::size_t i = 0; i < 30000; i++) {
+			lc.insert(keys[i]);
+			(i % 2 ? odds : evens).insert(keys[i]);
+		}
+		lc.insert(keys.data(), 30000);
+		assert(close(lc.estimate(), 30000, 0.03));
+		assert(close(evens.estimate(), 15000, 0.03));
+		assert((evens | odds) == lc);
+		evens |= odds;
+		assert(evens == lc);
+		const std::vector<unsigned char> dense = lc.serialize();
+		assert(dense.size() < (1 << 16) / 8 + 8 && BitUtils::LinearCounter::deserialize(dense) == lc);
+		BitUtils::LinearCounter few(1 << 16);
+		few.insert(keys.data(), 100);
+		const std::vector<unsigned char> sparse = few.serialize();
+		assert(sparse.size() < 300 && BitUtils::LinearCounter::deserialize(sparse) == few);
+		try {
+			BitUtils::LinearCounter::deserialize(sparse.data(), sparse.size() - 1);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+		try {
+			lc |= BitUtils::LinearCounter(100);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		// A multi resolution bitmap should stay close from a handful of keys up to way more than its components have bits.
+		BitUtils::MultiResolutionBitmap mrb(4096, 16), left(4096, 16), right(4096, 16);
+		assert(mrb.size() == 4096 * 16 && mrb.estimate() == 0);
+		std::size_t added = 0;
+		for (std::size_t target : { (std::size_t)10, (std::size_t)1000, (std::size_t)20000, (std::size_t)200000 }) {
+			mrb.insert(keys.data() + added, target - added);
+			for (std::size_t i = added; i < target; i++) {
+				(i % 3 ? left : right).insert(keys[i]);
+			}
+			added = target;
+			assert(close(mrb.estimate(), (double)target, 0.1));
+		}
+		assert(mrb.count(0) > mrb.count(5) && mrb.count(5) > mrb.count(10));
+		assert((left | right) == mrb);
+		const std::vector<unsigned char> bytes = mrb.serialize();
+		const BitUtils::MultiResolutionBitmap back = BitUtils::MultiResolutionBitmap::deserialize(bytes);
+		assert(back == mrb && back.estimate() == mrb.estimate());
+		try {
+			mrb.count(16);
+			assert(false);
+		}
+		catch (const std::out_of_range&) {}
+		try {
+			BitUtils::MultiResolutionBitmap(4096, 65);
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+
+		// With 64 components every one of them should be reachable. _mix64 is a bijection, so run it backwards to get the key whose hash is 2^j,
+		// which belongs in component j (and the key that hashes to 0 belongs in the last one).
+		const auto inverse = [](const std::uint64_t a) {
+			std::uint64_t x = a;
+			for (int i = 0; i < 6; i++) {
+				x *= 2 - a * x;
+			}
+			return x;
+		};
+		const auto unmix = [&inverse](std::uint64_t h) {
+			h ^= h >> 33;
+			h *= inverse(0xC4CEB9FE1A85EC53ULL);
+			h ^= h >> 33;
+			h *= inverse(0xFF51AFD7ED558CCDULL);
+			h ^= h >> 33;
+			return h;
+		};
+		BitUtils::MultiResolutionBitmap wide(64, 64);
+		for (std::size_t j = 0; j < 64; j++) {
+			assert(BitUtils::_mix64(unmix((std::uint64_t)1 << j)) == (std::uint64_t)1 << j);
+			wide.insert(unmix((std::uint64_t)1 << j));
+		}
+		wide.insert(unmix(0));
+		for (std::size_t i = 0; i < 63; i++) {
+			assert(wide.count(i) == 1);
+		}
+		assert(wide.count(63) == 2);
+	}
+
+	void test_signature_index() {
+		// Documents with 5 to 40 terms out of 3000, where the low terms are a lot more common than the high ones.
+		const std::size_t documents = 3000;
+		std::vector<std::set<std::uint64_t>> corpus(documents);
+		std::uint64_t seed = 48;
+		const auto next = [&seed]() {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			return seed >> 33;
+		};
+		for (std::set<std::uint64_t>& terms : corpus) {
+			const std::size_t count = 5 + next() % 36;
+			while (terms.size() < count) {
+				terms.insert(next() % (1 + next() % 3000));
+			}
+		}
+
+		const std::vector<std::vector<std::size_t>> treatments = { { 0 }, { 0, 0 }, { 0, 3, 3 }, { 2, 2, 2 } };
+		for (const std::vector<std::size_t>& treatment : treatments) {
+			BitUtils::SignatureIndex index(documents, { 2000, 0, 1500, 1500 }, treatment);
+			assert(index.capacity_documents() >= documents && index.capacity_documents() % (256 << treatment.back()) == 0);
+			for (std::size_t d = 0; d < documents; d++) {
+				const std::vector<std::uint64_t> terms(corpus[d].begin(), corpus[d].end());
+				assert(index.add_document(terms) == d);
+			}
+			assert(index.size() == documents);
+
+			std::size_t matches = 0, candidates = 0;
+			for (std::size_t q = 0; q < 200; q++) {
+				std::vector<std::uint64_t> query;
+				for (std::size_t t = 0; t < 1 + q % 3; t++) {
+					query.push_back(next() % (1 + next() % 300));
+				}
+				const std::vector<std::size_t> found = index.find(query);
+				assert(found.size() == index.count(query) && std::is_sorted(found.begin(), found.end()));
+				std::size_t at = 0;
+				for (std::size_t d = 0; d < documents; d++) {
+					bool all = true;
+					for (std::uint64_t term : query) {
+						all = all && corpus[d].count(term) == 1;
+					}
+					const bool candidate = at < found.size() && found[at] == d;
+					at += candidate;
+					assert(!all || candidate); // no false negatives
+					matches += all;
+					candidates += candidate;
+				}
+				assert(at == found.size());
+
+				// ANDing the rows of all of the terms is the same as intersecting what each term finds on its own.
+				std::vector<std::size_t> intersection = index.find({ query[0] });
+				for (std::size_t t = 1; t < query.size(); t++) {
+					const std::vector<std::size_t> alone = index.find({ query[t] });
+					std::vector<std::size_t> both;
+					std::set_intersection(intersection.begin(), intersection.end(), alone.begin(), alone.end(), std::back_inserter(both));
+					intersection = both;
+				}
+				assert(intersection == found);
+			}
+			// Rows that are all high rank fill up for common terms, which is what the rank 0 rows are for.
+			assert(candidates >= matches && candidates * 2 < matches * (treatment[0] == 0 ? 3 : 10));
+		}
+
+		// Every document matches no terms, stopping works, and a full index says so.
+		BitUtils::SignatureIndex small(10, { 64 }, { 0 });
+		for (std::uint64_t d = 0; d < small.capacity_documents(); d++) {
+			small.add_document(&d, 1);
+		}
+		assert(small.count({}) == small.capacity_documents());
+		std::size_t seen = 0;
+		assert(!small.for_each_match(std::vector<std::uint64_t>(), [&seen](std::size_t) { return ++seen < 3; }) && seen == 3);
+		try {
+			small.add_document({ 1 });
+			assert(false);
+		}
+		catch (const std::out_of_range&) {}
+		try {
+			BitUtils::SignatureIndex bad(10, { 64 }, { 1 });
+			assert(false);
+		}
+		catch (const std::invalid_argument&) {}
+		try {
+			small.row(0, 64);
+			assert(false);
+		}
+		catch (const std::out_of_range&) {}
+	}
+
+	void test_id_allocator() {
+		// 1000 IDs is 16 words, the last one with 24 that don't exist.
+		const std::size_t n = 1000;
+		BitUtils::IdAllocator ids(n);
+		assert(ids.capacity() == n && ids.count() == 0);
+
+		std::vector<bool> seen(n, false);
+		for (std::size_t j = 0; j < n; j++) {
+			const std::size_t id = ids.acquire();
+			assert(id < n && !seen[id] && ids.taken(id));
+			seen[id] = true;
+		}
+		assert(ids.count() == n);
+		assert(ids.acquire() == n); // all taken
+
+		// a given back ID is the only free one, so it's the next one out
+		ids.release(517);
+		assert(!ids.taken(517) && ids.count() == n - 1);
+		assert(ids.acquire() == 517);
+		ids.release(999);
+		ids.release(3);
+		bool threw = false;
+		try {
+			ids.release(3);
+		}
+		catch (const std::invalid_argument&) {
+			threw = true;
+		}
+		assert(threw);
+		threw = false;
+		try {
+			ids.release(n);
+		}
+		catch (const std::out_of_range&) {
+			threw = true;
+		}
+		assert(threw);
+
+		// batches, including one that runs out
+		std::vector<std::size_t> batch = ids.acquire(5);
+		assert(batch.size() == 2);
+		std::sort(batch.begin(), batch.end());
+		assert(batch[0] == 3 && batch[1] == 999);
+		for (std::size_t id = 0; id < n; id += 2) {
+			ids.release(id);
+		}
+		batch = ids.acquire(n);
+		assert(batch.size() == n / 2);
+		for (std::size_t id : batch)
+			assert(id % 2 == 0);
+		assert(std::set<std::size_t>(batch.begin(), batch.end()).size() == n / 2);
+
+		// Every thread takes and gives back IDs. Nobody should ever get an ID that somebody else has.
+		const std::size_t m = 5000;
+		BitUtils::IdAllocator shared(m);
+		std::unique_ptr<std::atomic<std::size_t>[]> owner(new std::atomic<std::size_t>[m]);
+		for (std::size_t i = 0; i < m; i++)
+			owner[i].store(0);
+		const std::size_t threads = 8;
+		std::vector<std::vector<std::size_t>> held(threads);
+		std::vector<std::thread> workers;
+		for (std::size_t t = 0; t < threads; t++) {
+			workers.push_back(std::thread([&, t]() {
+				std::uint64_t seed = t + 1;
+				std::size_t got[8];
+				for (std::size_t round = 0; round < 4000; round++) {
+					seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+					const std::size_t k = round % 4 == 0 ? 1 + (std::size_t)(seed >> 61) : 1;
+					const std::size_t count = shared.acquire(got, k);
+					for (std::size_t j = 0; j < count; j++) {
+						assert(owner[got[j]].exchange(t + 1) == 0);
+						held[t].push_back(got[j]);
+					}
+					// give back about half, in no particular order
+					if ((seed >> 40) & 1 && !held[t].empty()) {
+						const std::size_t at = (std::size_t)(seed >> 20) % held[t].size();
+						const std::size_t id = held[t][at];
+						held[t][at] = held[t].back();
+						held[t].pop_back();
+						assert(owner[id].exchange(0) == t + 1);
+						shared.release(id);
+					}
+				}
+			}));
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		std::size_t total = 0;
+		for (std::size_t t = 0; t < threads; t++) {
+			for (std::size_t id : held[t]) {
+				assert(owner[id].load() == t + 1 && shared.taken(id));
+			}
+			total += held[t].size();
+		}
+		assert(shared.count() == total);
+		// and the rest can all still be found
+		assert(shared.acquire(m).size() == m - total);
+		assert(shared.acquire() == m);
+	}
+
 	void test_everything() {
 		test_get();
 		test_size();
@@ -922,6 +2798,27 @@ namespace TestCpp11 {
 		test_bool_op_s();
 		test_shift_left();
 		test_shift_right();
+		test_bit_span();
+		test_for_each_set_bit();
+		test_for_each_run();
+		test_bit_iterator();
+		test_for_each_word();
+		test_summary_bitmap();
+		test_find_fit();
+		test_claim_run();
+		test_atomic_bits();
+		test_find_pattern();
+		test_bitap();
+		test_myers();
+		test_roaring();
+		test_ewah();
+		test_adaptive();
+		test_bloom_filter();
+		test_static_filters();
+		test_sliding_window();
+		test_sketches();
+		test_signature_index();
+		test_id_allocator();
 	}
 };
 
@@ -0,0 +1,204 @@
+#ifndef TESTCPP17_H
+#define TESTCPP17_H
+
+#include "BitUtils.h"
+#include "BitUtils17.h"
+#include <cassert>
+
+#if __cplusplus >= 201700 // C++17
+namespace TestCpp17 {
+	// Fills the block with junk that is the same every run.
+	void scramble(void* const block, const std::size_t bytes, std::uint64_t seed) {
+		for (std::size_t i = 0; i < bytes; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			((unsigned char*)block)[i] = (unsigned char)(seed >> 56);
+		}
+	}
+
+	template <std::size_t _n>
+	void test_wide() {
+		typedef BitUtils::BitUtils<_n> Wide;
+		static_assert(Wide::is_wide, "expected the wide kernels to be used");
+		static_assert(Wide::size == _n / BitUtils::CHAR_SIZE, "wrong size");
+
+		void* left = Wide::create();
+		void* right = Wide::create();
+		void* dst = Wide::create();
+		scramble(left, Wide::size, _n);
+		scramble(right, Wide::size, _n + 1);
+
+		Wide::bitwise_and(left, right, dst);
+		for (std::size_t i = 0; i < _n; i++) {
+			assert(Wide::get(dst, i) == (Wide::get(left, i) && Wide::get(right, i)));
+		}
+		Wide::bitwise_or(left, right, dst);
+		for (std::size_t i = 0; i < _n; i++) {
+			assert(Wide::get(dst, i) == (Wide::get(left, i) || Wide::get(right, i)));
+		}
+		Wide::bitwise_xor(left, right, dst);
+		for (std::size_t i = 0; i < _n; i++) {
+			assert(Wide::get(dst, i) == (Wide::get(left, i) != Wide::get(right, i)));
+		}
+		Wide::bitwise_not(left, dst);
+		for (std::size_t i = 0; i < _n; i++) {
+			assert(Wide::get(dst, i) == !Wide::get(left, i));
+		}
+
+		std::size_t expected = 0;
+		for (std::size_t i = 0; i < _n; i++) {
+			expected += Wide::get(left, i);
+		}
+		assert(Wide::count(left) == expected);
+
+		assert(!Wide::equals(left, right));
+		Wide::copy(left, dst);
+		assert(Wide::equals(left, dst));
+		Wide::flip(dst, _n - 1);
+		assert(!Wide::equals(left, dst));
+
+		// find_first
+		Wide::fill(dst, 0);
+		assert(Wide::find_first(dst) == _n);
+		assert(!Wide::bool_op(dst));
+		Wide::set(dst, _n - 3, 1);
+		assert(Wide::find_first(dst) == _n - 3);
+		Wide::set(dst, 70, 1);
+		assert(Wide::find_first(dst) == 70);
+		assert(Wide::bool_op(dst));
+		assert(!Wide::all(dst));
+		Wide::fill(dst, 1);
+		assert(Wide::all(dst));
+
+		// shifts, compared against shifting bit by bit
+		for (std::size_t by = 0; by < _n; by += 13) {
+			Wide::copy(left, dst);
+			Wide::shift_left(dst, by);
+			for (std::size_t i = 0; i < _n; i++) {
+				assert(Wide::get(dst, i) == (i + by < _n && Wide::get(left, i + by)));
+			}
+			Wide::copy(left, dst);
+			Wide::shift_right(dst, by);
+			for (std::size_t i = 0; i < _n; i++) {
+				assert(Wide::get(dst, i) == (i >= by && Wide::get(left, i - by)));
+			}
+		}
+
+		free(left);
+		free(right);
+		free(dst);
+	}
+
+	void test_narrow() {
+		// The generic versions of the new functions
+		typedef BitUtils::BitUtils<20> Narrow;
+		typedef BitUtils::BitUtils<20, 4, 12> Bounded;
+		void* block = Narrow::create();
+
+		assert(Narrow::count(block) == 0);
+		assert(Narrow::find_first(block) == 20);
+		Narrow::set(block, 17, 1);
+		Narrow::set(block, 5, 1);
+		assert(Narrow::count(block) == 2);
+		assert(Narrow::find_first(block) == 5);
+		assert(Bounded::find_first(block) == 1);
+		assert(Bounded::count(block) == 1);
+
+		Narrow::shift_left(block, 3);
+		assert(Narrow::get(block, 2) && Narrow::get(block, 14));
+		assert(Narrow::count(block) == 2);
+		Narrow::shift_right(block, 4);
+		assert(Narrow::get(block, 6) && Narrow::get(block, 18));
+		assert(Narrow::count(block) == 2);
+
+		free(block);
+	}
+
+	// A character class table that is built entirely by the compiler.
+	constexpr BitUtils::BitUtils<256>::storage make_digits() {
+		typedef BitUtils::BitUtils<256> Table;
+		Table::storage table{};
+		for (char c = '0'; c <= '9'; c++) {
+			Table::set(table, (unsigned char)c, 1);
+		}
+		return table;
+	}
+
+	constexpr BitUtils::BitUtils<16>::storage make_pattern() {
+		typedef BitUtils::BitUtils<16> Pattern;
+		Pattern::storage left{};
+		Pattern::from_str(left, "1100110011001100");
+		Pattern::storage right{};
+		Pattern::fill(right, 1);
+		BitUtils::BitUtils<16, 8, 16>::fill(right, 0); // right: 1111111100000000
+		Pattern::storage dst{};
+		Pattern::bitwise_and(left, right, dst);          // dst:   1100110000000000
+		Pattern::shift_right(dst, 2);                    // dst:   0011001100000000
+		Pattern::bitwise_xor(dst, right, dst);           // dst:   1100110000000000
+		Pattern::bitwise_or(dst, left, dst);             // dst:   1100110011001100
+		Pattern::shift_left(dst, 1);                     // dst:   1001100110011000
+		Pattern::bitwise_not(dst);                       // dst:   0110011001100111
+		return dst;
+	}
+
+	void test_constexpr() {
+		typedef BitUtils::BitUtils<256> Table;
+		constexpr Table::storage digits = make_digits();
+		static_assert(Table::count(digits) == 10, "the table should be computed at compile time");
+		static_assert(Table::get(digits, '7') && !Table::get(digits, 'a'), "the table should be computed at compile time");
+		static_assert(Table::find_first(digits) == '0', "the table should be computed at compile time");
+
+		typedef BitUtils::BitUtils<16> Pattern;
+		constexpr Pattern::storage pattern = make_pattern();
+		constexpr Pattern::storage expected = [] {
+			Pattern::storage s{};
+			Pattern::from_str(s, "0110011001100111");
+			return s;
+		}();
+		static_assert(Pattern::equals(pattern, expected), "the pattern should be computed at compile time");
+		static_assert(Pattern::count(pattern) == 9, "the pattern should be computed at compile time");
+
+		// The storage can be used with the void* functions too.
+		assert(Table::count(digits.data()) == 10);
+		assert(Pattern::str(pattern.data()) == "0110011001100111");
+	}
+
+	void test_literals() {
+		using namespace BitUtils::literals;
+
+		constexpr auto mask = 0101_bits;
+		static_assert(decltype(mask)::n == 4, "the size should come from the literal");
+		static_assert(!BitUtils::BitUtils<4>::get(mask, 0) && BitUtils::BitUtils<4>::get(mask, 1), "the literal should be parsed at compile time");
+		static_assert(BitUtils::BitUtils<4>::count(mask) == 2, "the literal should be parsed at compile time");
+
+		constexpr auto separated = 0b1111'0000'1_bits;
+		static_assert(decltype(separated)::n == 9, "separators and the 0b prefix shouldn't count as bits");
+		static_assert(BitUtils::BitUtils<9>::find_first(separated) == 0, "the literal should be parsed at compile time");
+		static_assert(BitUtils::BitUtils<9>::get(separated, 8), "the literal should be parsed at compile time");
+
+		constexpr auto hex = 0xA1_bits;
+		static_assert(decltype(hex)::n == 8, "hex digits should be 4 bits each");
+		typedef BitUtils::BitUtils<8> Hex;
+		constexpr auto expected = 10100001_bits;
+		static_assert(Hex::equals(hex, expected), "0xA1 should be 1010 0001");
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L // C++20
+		constexpr auto str = "0101"_bits;
+		static_assert(BitUtils::BitUtils<4>::equals(str, mask), "string literals should be parsed like numeric ones");
+		static_assert(decltype("0xff"_bits)::n == 8, "string literals should be parsed like numeric ones");
+#endif // C++20
+
+		assert(Hex::str(hex.data()) == "10100001");
+	}
+
+	void test_everything() {
+		test_wide<128>();
+		test_wide<256>();
+		test_wide<512>();
+		test_narrow();
+		test_constexpr();
+		test_literals();
+	}
+};
+#endif // C++17
+
+#endif // TESTCPP17_H
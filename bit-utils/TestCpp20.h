@@ -0,0 +1,114 @@
+#ifndef TESTCPP20_H
+#define TESTCPP20_H
+
+#include "BitUtils.h"
+#include "BitUtils17.h"
+#include "BitUtils20.h"
+#include <cassert>
+#include <vector>
+
+#if defined(__cpp_lib_ranges) // C++20
+namespace TestCpp20 {
+	// Fills the block with junk that is the same every run.
+	void scramble(void* const block, const std::size_t bytes, std::uint64_t seed) {
+		for (std::size_t i = 0; i < bytes; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			((unsigned char*)block)[i] = (unsigned char)(seed >> 56);
+		}
+	}
+
+	void test_views() {
+		using namespace BitUtils::views;
+		static_assert(std::ranges::forward_range<PositionView<false>> && std::ranges::view<PositionView<false>>);
+		static_assert(std::ranges::forward_range<RunView> && std::ranges::view<RunView>);
+		static_assert(std::ranges::forward_range<WordView> && std::ranges::sized_range<WordView>);
+		static_assert(std::ranges::borrowed_range<RunView>);
+
+		const std::size_t n = 300;
+		void* block = BitUtils::create(n);
+		scramble(block, BitUtils::size(n), 9);
+		BitUtils::fill(BitUtils::BitSpan(block, 100, 250), 0);
+		BitUtils::fill(BitUtils::BitSpan(block, 120, 200), 1);
+
+		const std::size_t starts[] = { 0, 3, 64, 110 };
+		const std::size_t ends[] = { 64, 129, 251, 300 };
+		for (std::size_t start : starts) {
+			for (std::size_t end : ends) {
+				if (start >= end)
+					continue;
+				const BitUtils::ConstBitSpan span(block, start, end);
+
+				std::vector<std::size_t> ones, zeros;
+				BitUtils::for_each_set_bit(span, [&](std::size_t i) { ones.push_back(i); });
+				BitUtils::for_each_clear_bit(span, [&](std::size_t i) { zeros.push_back(i); });
+				std::vector<std::size_t> seen;
+				for (std::size_t i : span | set_positions)
+					seen.push_back(i);
+				assert(seen == ones);
+				seen.clear();
+				for (std::size_t i : clear_positions(span))
+					seen.push_back(i);
+				assert(seen == zeros);
+
+				std::vector<std::pair<std::size_t, std::size_t>> seen_runs;
+				for (auto run : span | runs)
+					seen_runs.push_back(run);
+				assert(seen_runs == BitUtils::to_intervals(block, start, end));
+
+				std::size_t k = 0;
+				for (std::uint64_t word : span | words) {
+					for (std::size_t i = 0; i < 64; i++) {
+						assert(((word >> i) & 1) == (k * 64 + i < span.n && BitUtils::get(span, k * 64 + i)));
+					}
+					k++;
+				}
+				assert(k == (span | words).size());
+			}
+		}
+
+		// Pipelines with the standard views.
+		const BitUtils::BitSpan span(block, n);
+		std::vector<std::size_t> even;
+		for (std::size_t i : span | set_positions | std::views::filter([](std::size_t i) { return i % 2 == 0; }) | std::views::take(5))
+			even.push_back(i);
+		assert(even.size() == 5);
+		for (std::size_t j = 0; j < even.size(); j++) {
+			assert(even[j] % 2 == 0 && BitUtils::get(block, n, even[j]));
+			assert(j == 0 || even[j] > even[j - 1]);
+		}
+		auto lengths = span | runs | std::views::transform([](auto run) { return run.second - run.first; });
+		assert(std::ranges::max(lengths) >= 80);
+
+		// The iterators still work after the view is gone.
+		auto it = (span | set_positions).begin();
+		assert(BitUtils::get(block, n, *it));
+
+		// Nothing to visit
+		BitUtils::fill(block, n, 0);
+		assert(std::ranges::empty(span | set_positions));
+		assert(std::ranges::empty(span | runs));
+		assert(std::ranges::distance(span | clear_positions) == (std::ptrdiff_t)n);
+
+		free(block);
+	}
+
+	void test_storage_views() {
+		using namespace BitUtils::literals;
+		constexpr auto mask = 0b0110'0000'0000'0000'0000'0000'0000'0000'0000'0000'0000'0000'0000'0000'0000'0000'111_bits;
+		std::vector<std::size_t> seen;
+		for (std::size_t i : mask | BitUtils::views::set_positions)
+			seen.push_back(i);
+		const std::vector<std::size_t> expected = { 1, 2, 64, 65, 66 };
+		assert(seen == expected);
+		const std::vector<std::pair<std::size_t, std::size_t>> expected_runs = { { 1, 3 }, { 64, 67 } };
+		assert(std::ranges::equal(mask | BitUtils::views::runs, expected_runs));
+	}
+
+	void test_everything() {
+		test_views();
+		test_storage_views();
+	}
+};
+#endif // C++20
+
+#endif // TESTCPP20_H
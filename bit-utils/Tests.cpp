@@ -7,6 +7,8 @@
 
 #include "BitUtils.h"
 #include "TestCpp11.h"
+#include "TestCpp17.h"
+#include "TestCpp20.h"
 
 #ifdef CHAR_BIT
 constexpr const std::size_t CHAR_SIZE = CHAR_BIT;
@@ -25,6 +27,12 @@ void testCpp17();
 
 int main(int argc, char * argv[]) {
 	TestCpp11::test_everything();
+#if __cplusplus >= 201700 // C++17
+	TestCpp17::test_everything();
+#endif // C++17
+#if defined(__cpp_lib_ranges) // C++20
+	TestCpp20::test_everything();
+#endif // C++20
 
 	std::cout << "All good!" << std::endl;
 
@@ -40,6 +48,8 @@ void testCpp11() {
 
 #if __cplusplus >= 201700 // C++17
 void testCpp17() {
-
+	std::cout << "Testing the C++17 version" << std::endl;
+	TestCpp17::test_everything();
+	std::cout << "All tests passed!" << std::endl;
 }
 #endif // C++17
\ No newline at end of file